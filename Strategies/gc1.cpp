@@ -56,6 +56,7 @@ void GC1::set_param_values(
 {
     // Find parameter value in parameter_set by its name (as appear in XML file)
     MyStop_ = find_param_value_by_name( "MyStop", parameter_set );
+    DOW_switch_ = find_param_value_by_name( "DOW_switch", parameter_set );
     Side_switch_ = find_param_value_by_name( "Side_switch", parameter_set );
     fractN_long_  = find_param_value_by_name( "fractN_long", parameter_set );
     fractN_short_ = find_param_value_by_name( "fractN_short", parameter_set );
@@ -110,6 +111,12 @@ int GC1::preliminaries( const std::deque<Event>& data1,
         TradingEnabled_ = true;
         NewSession_ = true;
         SessionOpenPrice_ = OpenD_[0];
+        // Day of week of the session close
+        SessionDOW_ = CurrentDOW_;
+        if( symbol_.two_days_session()
+            && CurrentTime_ > symbol_.session_close_time() ){
+            SessionDOW_ = CurrentDOW_ % 7 + 1;
+        }
     }
     else{
         NewSession_ = false;
@@ -156,8 +163,12 @@ void GC1::compute_entry( const std::deque<Event>& data1,
     bool Filter1_long { HighD_[0]-OpenD_[0] > HighD_[1]-OpenD_[1] };
     // --------------------------------------------------------------------- //
 
+    // -------------------------    DOW FILTER    -------------------------- //
+    bool FilterDOW { DOW_switch_ == 0 || SessionDOW_ != DOW_switch_ };
+    // --------------------------------------------------------------------- //
+
     // ----------------------    COMBINE ALL FILTERS    -------------------- //
-    bool All_filters_long  { FilterT_long && Filter1_long };
+    bool All_filters_long  { FilterT_long && Filter1_long && FilterDOW };
     bool All_filters_short { false };
     // --------------------------------------------------------------------- //
 
@@ -278,3 +289,20 @@ void GC1::compute_signals( const PriceCollection& price_collection,
         compute_exit( data1, data1D, position_handler, signals );
     }
 }
+
+
+
+
+//-------------------------------------------------------------------------- //
+/*! Whether entry filter 'filter_name' set to 'value' allows entries on the
+    current session (same rule as in compute_entry).
+    Called on entry fills: SessionDOW_ is the one of the entry session.
+*/
+bool GC1::mask_filter_passes( const std::string &filter_name, int value,
+                        const PriceCollection& /*price_collection*/ ) const
+{
+    if( filter_name == "DOW_switch" ){
+        return( value == 0 || SessionDOW_ != value );
+    }
+    return(true);
+}
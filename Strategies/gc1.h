@@ -58,6 +58,8 @@ Member Variables:
                     E.g. forbids multiple trades in same session.
 - SessionOpenPrice_: opening price of the current session
 - NewSession_: true at the start of a new session (day), otherwise false
+- SessionDOW_: day of week of current session (Mon=1, ..., Sun=7),
+                taken at the session close
 - OpenD_, ... , CloseD_: array of OHLC of current and previous 5 sessions
 - T_segment_duration: duration of T-segment window (in minutes)
 
@@ -66,6 +68,8 @@ Member Variables:
 Strategy Parameters:
 
 - MyStop_: Stop-Loss in USD per contract
+- DOW_switch_: 0 = no filter, 1..7 = no entries in sessions closing on that
+                day of week (Mon=1)
 - fractN_: Fraction for breakout = 2^fractN_ / 10
 */
 
@@ -82,6 +86,7 @@ class GC1 : public Strategy {
     bool TradingEnabled_ {true};
     double SessionOpenPrice_ {0.0};
     bool NewSession_ {false};
+    int SessionDOW_ {0};
     std::array<double, 6> OpenD_ {};
     std::array<double, 6> HighD_ {};
     std::array<double, 6> LowD_ {};
@@ -95,6 +100,7 @@ class GC1 : public Strategy {
     // --- Initialization of Input Parameters --- //
     //  (default values, may be replaced by XML)  //
     int MyStop_ {0};            // Stop-Loss in USD per contract
+    int DOW_switch_ {0};        // 0: off, 1..7: skip sessions of that DOW
     // Switches
     int Side_switch_ {3};
     // Parameters
@@ -136,6 +142,13 @@ class GC1 : public Strategy {
         void compute_signals( const PriceCollection& price_collection,
                               const PositionHandler& position_handler,
                               std::array<Event, 2> &signals ) override;
+        // Entry filters evaluated by masks in filter optimizations
+        std::vector<std::string> mask_filters() const override
+                                            { return { "DOW_switch" }; }
+        // Whether entry filter 'filter_name' set to 'value' allows entries
+        // on the current session
+        bool mask_filter_passes( const std::string &filter_name, int value,
+                    const PriceCollection& price_collection ) const override;
 };
 
 
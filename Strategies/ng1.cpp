@@ -50,6 +50,7 @@ void NG1::set_param_values(
 {
     // Find parameter value in parameter_set by its name (as appear in XML file)
     MyStop_ = find_param_value_by_name( "MyStop", parameter_set );
+    DOW_switch_ = find_param_value_by_name( "DOW_switch", parameter_set );
     fractN_ = find_param_value_by_name( "fractN", parameter_set );
     epsilon_ = find_param_value_by_name( "epsilon", parameter_set );
 
@@ -103,6 +104,12 @@ int NG1::preliminaries( const std::deque<Event>& data1,
         TradingEnabled_ = true;
         NewSession_ = true;
         SessionOpenPrice_ = OpenD_[0];
+        // Day of week of the session close
+        SessionDOW_ = CurrentDOW_;
+        if( symbol_.two_days_session()
+            && CurrentTime_ > symbol_.session_close_time() ){
+            SessionDOW_ = CurrentDOW_ % 7 + 1;
+        }
     }
     else{
         NewSession_ = false;
@@ -176,9 +183,13 @@ void NG1::compute_entry( const std::deque<Event>& data1,
     Filter1_short = data1[0].low() != LowD_[0];
     // --------------------------------------------------------------------- //
 
+    // -------------------------    DOW FILTER    -------------------------- //
+    bool FilterDOW { DOW_switch_ == 0 || SessionDOW_ != DOW_switch_ };
+    // --------------------------------------------------------------------- //
+
     // ----------------------    COMBINE ALL FILTERS    -------------------- //
-    bool All_filters_long  { FilterT && Filter1_long };
-    bool All_filters_short { FilterT && Filter1_short };
+    bool All_filters_long  { FilterT && Filter1_long && FilterDOW };
+    bool All_filters_short { FilterT && Filter1_short && FilterDOW };
     // --------------------------------------------------------------------- //
 
     // ------------------------    ENTRY RULES    -------------------------- //
@@ -302,3 +313,20 @@ void NG1::compute_signals( const PriceCollection& price_collection,
         compute_exit( data1, data1D, position_handler, signals );
     }
 }
+
+
+
+
+//-------------------------------------------------------------------------- //
+/*! Whether entry filter 'filter_name' set to 'value' allows entries on the
+    current session (same rule as in compute_entry).
+    Called on entry fills: SessionDOW_ is the one of the entry session.
+*/
+bool NG1::mask_filter_passes( const std::string &filter_name, int value,
+                        const PriceCollection& /*price_collection*/ ) const
+{
+    if( filter_name == "DOW_switch" ){
+        return( value == 0 || SessionDOW_ != value );
+    }
+    return(true);
+}
@@ -75,6 +75,29 @@ class Strategy {
                                 const PriceCollection& price_collection,
                                 const PositionHandler& position_handler,
                                 std::array<Event, 2> &signals ) = 0;
+
+        // Max number of trades opened in a session, used to bound the
+        // number of trades of a backtest (pruning, see PruningRules).
+        // Default: 0 (no max)
+        virtual int max_trades_per_session() const { return(0); }
+
+        // Entry filters which can be evaluated as masks over the trades of
+        // the strategy without them (filter value 0 = filter off).
+        // A filter may be listed only if it just suppresses entries, its
+        // value is constant within each session, and trades are opened
+        // and closed within the same session (at most one per session),
+        // so that the trades with the filter on are the trades with the
+        // filter off on the sessions where the filter passes.
+        // Default: none (all filters evaluated by full backtests)
+        virtual std::vector<std::string> mask_filters() const { return {}; }
+
+        // Whether entry filter 'filter_name' set to 'value' allows entries
+        // on the session of the latest bar in 'price_collection'
+        // (called on entry fills, for filters in mask_filters() )
+        virtual bool mask_filter_passes( const std::string &/*filter_name*/,
+                            int /*value*/,
+                            const PriceCollection& /*price_collection*/ ) const
+                            { return(true); }
         /*
         virtual Event compute_entry(const std::deque<Event>& data1,
                                     const std::deque<Event>& data1D,
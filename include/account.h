@@ -2,6 +2,7 @@
 #define ACCOUNT_H
 
 #include "datetime.h"
+#include "metrics_accumulator.h"
 #include "transaction.h"
 
 
@@ -19,6 +20,9 @@ Member Variables
 - transactions_: vector of transaction objects
 - equity_: floating equity, non consolidated balance at end of day.
            vector of pairs ( Date, double )
+- metrics_: summary metrics of closed trades, updated on each trade
+- keep_transactions_: switch to store closed trades in transactions_
+                      (not needed when only metrics_ are used)
 
 [- df: pandas dataframe containing 'exit_time', 'net_pl' 'Bars_in_trade'
     of all transactions]
@@ -38,6 +42,8 @@ class Account {
 
     std::vector<Transaction> transactions_ {};
     std::vector<std::pair<Date,double>> equity_ {};
+    MetricsAccumulator metrics_ {};
+    bool keep_transactions_ {true};
     //std::string strategy_name_{""};
 
 
@@ -63,12 +69,19 @@ class Account {
         double initial_balance() const { return(initial_balance_); }
         double balance() const { return(balance_); }
         std::vector<std::pair<Date,double>> equity() const { return(equity_); }
-        std::vector<Transaction> transactions() const {return(transactions_);}
+        const std::vector<Transaction>& transactions() const {
+            return(transactions_);
+        }
+        const MetricsAccumulator& metrics() const { return(metrics_); }
         //std::string strategy_name() const { return(strategy_name_); }
 
         // Setters
         void update_balance( double bal ){ balance_ += bal; }
         void reset( double initial_balance );
+        void set_keep_transactions( bool value ){ keep_transactions_ = value; }
+        void set_needed_metrics( unsigned needed ){
+            metrics_ = MetricsAccumulator { needed };
+        }
         void add_to_equity( Date new_date, double daily_pl );
 
 };
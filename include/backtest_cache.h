@@ -0,0 +1,149 @@
+#ifndef BACKTEST_CACHE_H
+#define BACKTEST_CACHE_H
+
+#include "btfast.h"         // parameters_t
+#include "datafeed.h"       // DataFeed
+#include "datetime.h"       // Date
+
+#include <cstdint>          // uint64_t
+#include <cstdio>           // FILE
+#include <mutex>            // std::mutex
+#include <string>           // std::string
+#include <unordered_map>    // std::unordered_map
+#include <vector>           // std::vector
+
+
+/*!
+Compact result of a single backtest, as stored in BacktestCache.
+
+Metrics are those stored by utils_optim::append_to_optim_results
+(plus nyears, profitable_yrs used in validation), together with the
+counters/dates set by BTfast::run_backtest.
+The list of ticks of each trade is optional (empty if not stored).
+Pruned backtests (stopped early, partial metrics) are never stored.
+*/
+struct BacktestRecord {
+    double ntrades {0.0};
+    double avgticks {0.0};
+    double winperc {0.0};
+    double profitfactor {0.0};
+    double npmdd {0.0};
+    double expectancy {0.0};
+    double zscore {0.0};
+    double netpl {0.0};
+    double avgtrade {0.0};
+    double stdticks {0.0};
+    int nyears {0};
+    int profitable_yrs {0};
+    int bar_counter {0};
+    int day_counter {0};
+    Date first_date_parsed {};
+    Date last_date_parsed {};
+    bool has_ticks {false};
+    std::vector<double> ticks {};
+    bool pruned {false};
+};
+
+
+/*!
+Persistent on-disk cache of backtest results, shared across runs.
+
+Results are content-addressed: the key of each backtest is a hash of
+    - content of the data file, date range and format,
+    - strategy name and build version of the program,
+    - execution settings (symbol, timeframe, position sizing, costs, ...),
+    - strategy parameter vector.
+All the items but the parameters form the "context" of the backtest:
+records of the same context are appended to a single binary file
+'<cache_dir_>/<context hash>.bin', loaded the first time the context is used.
+Each record also stores the parameter values, compared on lookup: a record
+whose key collides with the hash of different parameters is a miss.
+
+Backtests with random components (noise, slippage) must not be cached
+(checked by the caller).
+
+Member Variables
+- cache_dir_: directory containing cache files
+- store_ticks_: switch to store the list of trade ticks with each record
+- contexts_: map (context hash, map (params hash, parameter values and
+             record) of the context)
+- files_: map (context hash, file where records of the context are appended)
+- file_hashes_: map (path, (size, mtime, hash)) of data files already hashed
+- mtx_: lock on records and files (lookup/store)
+- hash_mtx_: lock on file_hashes_
+- lookups_, hits_: number of lookups and hits
+- bytes_saved_: number of bytes of data not parsed thanks to cache hits
+*/
+
+
+// ------------------------------------------------------------------------- //
+// Class for BacktestCache
+
+class BacktestCache {
+
+    struct FileHash {
+        long long size {0};
+        long long mtime {0};
+        uint64_t hash {0};
+    };
+
+    struct CachedRecord {
+        std::vector<int> param_values {};
+        BacktestRecord record {};
+    };
+
+    std::string cache_dir_ {""};
+    bool store_ticks_ {false};
+
+    std::unordered_map<uint64_t,
+                       std::unordered_map<uint64_t, CachedRecord>> contexts_ {};
+    std::unordered_map<uint64_t, FILE*> files_ {};
+    std::unordered_map<std::string, FileHash> file_hashes_ {};
+
+    long long lookups_ {0};
+    long long hits_ {0};
+    long long bytes_saved_ {0};
+
+    std::mutex mtx_;
+    std::mutex hash_mtx_;
+
+    // Hash of the content of file 'path' (memoized on size/mtime)
+    uint64_t file_content_hash( const std::string &path, long long &size );
+    // Records of context 'ctx' (loaded from file the first time)
+    std::unordered_map<uint64_t, CachedRecord>& context_records(uint64_t ctx);
+
+    public:
+        // Context of a backtest (hash, and data file size in bytes)
+        struct Context {
+            uint64_t hash {0};
+            long long data_size {0};
+        };
+
+        // constructor
+        BacktestCache( const std::string &cache_dir, bool store_ticks );
+        // destructor (close cache files)
+        ~BacktestCache();
+
+        // Context of a backtest on 'datafeed' with execution 'settings'
+        Context context( const DataFeed &datafeed,
+                         const std::string &settings );
+
+        // Search for backtest in cache. Return true if found
+        // (with ticks, if 'with_ticks'), and copy it into 'record'
+        bool lookup( const Context &ctx, const parameters_t &params,
+                     bool with_ticks, BacktestRecord &record );
+
+        // Store backtest result into cache (memory and file)
+        void store( const Context &ctx, const parameters_t &params,
+                    const BacktestRecord &record );
+
+        // Print hit ratio and bytes saved on stdout
+        void print_statistics() const;
+
+        // Getters
+        bool store_ticks() const { return(store_ticks_); }
+};
+
+
+
+#endif
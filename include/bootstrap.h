@@ -0,0 +1,94 @@
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+#include "transaction.h"
+
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+
+/*!
+Confidence interval of a performance metric, from the distribution
+of its values over bootstrap resamples.
+
+- metric: name of the metric
+- value: value on the original trade sequence
+- mean, std_error: mean and standard deviation over resamples
+- lower, upper: percentiles of the resamples at (1-confidence)/2 and
+                (1+confidence)/2
+*/
+struct BootstrapInterval {
+    std::string metric {""};
+    double value {0.0};
+    double mean {0.0};
+    double std_error {0.0};
+    double lower {0.0};
+    double upper {0.0};
+};
+
+
+/*!
+Monte Carlo resampling of the trades of a backtest, to get standard errors
+and confidence intervals on performance metrics (NP/MDD, MaxDD, Z-score,
+AvgTicks) without running extra backtests.
+
+Resampling methods:
+    - "iid": bootstrap of single trades (with replacement)
+    - "block": circular block bootstrap, with blocks of block_size_
+               consecutive trades (preserves short-range dependence)
+    - "shuffle": random permutation of trade order (only path-dependent
+                 metrics change: only NP/MDD and MaxDD are reported)
+
+Resamples are independent and run in parallel. Each resample r draws from
+its own random stream (stats domain, run index r), so results do not
+depend on the number of threads.
+
+Member Variables
+- profits_: P/L of each trade (trades with 0 contracts excluded)
+- ticks_: ticks of each trade
+- num_resamples_: number of resamples
+- block_size_: number of trades in each block (block bootstrap).
+               0 in input: automatic, about ntrades^(1/3)
+- confidence_: confidence level of intervals (e.g. 0.95)
+*/
+
+// ------------------------------------------------------------------------- //
+// Class for Bootstrap
+
+class Bootstrap {
+
+    std::vector<double> profits_ {};
+    std::vector<double> ticks_ {};
+    int num_resamples_ {10000};
+    int block_size_ {5};
+    double confidence_ {0.95};
+
+    // Metrics of trade sequence 'pl', 'tk' (n trades):
+    // NP/MDD, MaxDD, Z-score, AvgTicks
+    static void sequence_metrics( const double *pl, const double *tk,
+                                  size_t n, double metrics[4] );
+
+    public:
+        // constructor
+        Bootstrap( const std::vector<Transaction> &transactions,
+                   int num_resamples, int block_size,
+                   double confidence = 0.95 );
+
+        // Run resamples with 'method', and store confidence intervals
+        // of the metrics into 'intervals'
+        void run( const std::string &method,
+                  std::vector<BootstrapInterval> &intervals ) const;
+
+        // Print intervals on stdout
+        static void print_intervals( const std::string &method,
+                            const std::vector<BootstrapInterval> &intervals );
+
+        // Getters
+        size_t ntrades() const { return( profits_.size() ); }
+        int block_size() const { return(block_size_); }
+        double confidence() const { return(confidence_); }
+};
+
+
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef BTFAST_H
 #define BTFAST_H
 
+#include "account.h"                // Account
 #include "datafeed.h"               // select_datafeed
 #include "execution_handler.h"
 #include "signal_handler.h"
@@ -22,6 +23,9 @@ Member Variables
 - last_date_parsed_: last date parsed from datafeed
 - bar_counter_: counter of number of bars parsed/received
 - day_counter: counter of number of days actually parsed from file
+  [first/last_date_parsed_, bar/day_counter_ refer to the data parsed by the
+   last run mode, for printing. Each backtest returns its own values in
+   BacktestResult/BacktestRecord]
 - max_bars_back_: max number of intraday bars in price collection,
                     (for each symbol/tf) and in indicator deques.
 - initial_balance_: initial account balance
@@ -33,6 +37,24 @@ Member Variables
 - include_commissions_: switch to control whether to include commission costs
 - slippage_: int number of slippage ticks
 - random_noise_: switch to control random noise added to data
+  (in run_backtest(); for run(), set in BacktestRequest)
+- cache_: pointer to persistent cache of backtest results (nullptr if disabled)
+- pruning_: pruning rules registered by the run mode for optimization
+            backtests (nullptr if disabled)
+- param_deps_: dependencies among strategy parameters (from strategy XML),
+               used to run only one combination of each equivalence class
+- ga_selection_: selection method of genetic optimization
+                 ("roulette", "tournament")
+- ga_steady_state_: switch to control steady-state (asynchronous) evaluation
+                    in genetic optimization
+- filter_mask_: switch to evaluate entry filters as masks over the trades
+                of the strategy without them (run_filter_optimization)
+- combined_is_oos_: switch to run in-sample and out-of-sample backtests
+                    of validation as a single continuous backtest
+                    (run_split_backtest)
+- factory_pruning_: pruning rules registered by the strategy factory for
+                    generation backtests (0: none, 1: bounds,
+                    2: bounds + heuristic projections, see PruningRules)
 
 */
 
@@ -52,8 +74,107 @@ using strategy_t = std::vector<std::pair<std::string,double>>;
 // [ ("p1", [10]), ("p2", [2,4,6,8]), ... ]
 using param_ranges_t = std::vector<std::pair<std::string,std::vector<int>>>;
 
+// Dependency of parameter 'param' on (switch) parameter 'controller',
+// declared with <ActiveIf> in the strategy XML:
+// 'param' is active only if 'controller' takes one of 'active_values',
+// otherwise its value does not change the strategy behaviour, and it is
+// set to 'inactive_value' (its first value in XML) in canonical combinations
+struct ParamDependency {
+    std::string param {""};
+    std::string controller {""};
+    std::vector<int> active_values {};
+    int inactive_value {0};
+};
+
+// All dependencies of strategy parameters, in order of 'param' in XML
+using param_deps_t = std::vector<ParamDependency>;
+
 //---
 
+class BacktestCache;
+struct BacktestRecord;
+class PruningRules;
+struct TradeMetrics;
+
+
+/*!
+Input of a single backtest run by BTfast::run().
+
+- datafeed: datafeed to parse (not owned). It is modified by the run
+            (connection, cursor), so it must not be shared by concurrent runs
+            (use a clone for each run).
+- strategy_params: combination of strategy parameters
+- random_noise: switch to add random noise to price data
+- print_progress: switch to print number of parsed bars on stdout
+- run_index: index of the run, identifying its random streams (noise,
+             slippage) together with the global seed. Runs with same index
+             get same random numbers, whatever thread executes them.
+- keep_transactions: switch to store the transaction history in the
+                     account (summary metrics are always accumulated)
+- metrics: groups of summary metrics needed by the caller
+           (MetricGroup flags; the others are left to 0)
+- pruning: rules to stop the backtest early (not owned; nullptr: no pruning)
+- mask_filters: entry filters (and their values) evaluated on each entry
+                fill, see Strategy::mask_filters() (not owned;
+                nullptr: no annotation)
+*/
+struct BacktestRequest {
+    DataFeed *datafeed {nullptr};
+    parameters_t strategy_params {};
+    bool random_noise {false};
+    bool print_progress {false};
+    uint64_t run_index {0};
+    bool keep_transactions {true};
+    unsigned metrics {metric_record};
+    const PruningRules *pruning {nullptr};
+    const param_ranges_t *mask_filters {nullptr};
+};
+
+/*!
+Entry fill of a backtest annotated with its entry filters
+(BacktestRequest::mask_filters).
+
+- entry_time: time of entry fill
+- side: side of position opened ("LONG", "SHORT")
+- passes: whether each filter value allows the entry, in order of
+          filters and values of BacktestRequest::mask_filters
+*/
+struct EntryFilterMask {
+    DateTime entry_time {};
+    std::string side {""};
+    std::vector<char> passes {};
+};
+
+/*!
+Output of a single backtest run by BTfast::run().
+
+- account: account with transaction history and equity of the run
+- bar_counter: number of bars parsed
+- day_counter: number of days parsed
+- first_date_parsed: first date parsed from datafeed
+- last_date_parsed: last date parsed from datafeed
+- pruned: whether the run was stopped early by a pruning rule
+          (metrics and counters are partial)
+- pruned_by: index of the pruning rule which stopped the run
+- entry_masks: entry fills annotated with entry filters
+               (only if BacktestRequest::mask_filters is set)
+- masks_inexact: whether a position was open, or an entry was filled,
+                 on the first bar of a session (only checked if
+                 BacktestRequest::mask_filters is set: entry masks are
+                 then not exact)
+*/
+struct BacktestResult {
+    Account account;
+    int bar_counter {0};
+    int day_counter {0};
+    Date first_date_parsed {};
+    Date last_date_parsed {};
+    bool pruned {false};
+    int pruned_by {-1};
+    std::vector<EntryFilterMask> entry_masks {};
+    bool masks_inexact {false};
+};
+
 // ------------------------------------------------------------------------- //
 // Main class for all run modes.
 
@@ -77,6 +198,15 @@ class BTfast {
 
     bool random_noise_ {false};
 
+    BacktestCache *cache_ {nullptr};
+    const PruningRules *pruning_ {nullptr};
+    param_deps_t param_deps_ {};
+    std::string ga_selection_ {"roulette"};
+    bool ga_steady_state_ {false};
+    bool filter_mask_ {false};
+    bool combined_is_oos_ {false};
+    int factory_pruning_ {0};
+
     // Member variables used for Market Overview
     // End-of-Day prices (Date, Close price)
     std::vector<std::pair<Date, double>> eod_prices_ {};
@@ -87,6 +217,11 @@ class BTfast {
     // Daily range H-L (in USD)
     std::vector<double> hl_range_ {};
 
+    // Store summary 'metrics' and counters/dates of 'result' into 'record'
+    static void fill_record( BacktestRecord &record,
+                             const TradeMetrics &metrics,
+                             const BacktestResult &result );
+
 
 
     public:
@@ -104,24 +239,53 @@ class BTfast {
 
         // Initialize variables and class instances for a new backtest
         void initialize_backtest(std::deque<Event> &events_queue,
-                                 std::unique_ptr<DataFeed> &datafeed_ptr,
+                                 DataFeed *datafeed_ptr,
                                  std::unique_ptr<ExecutionHandler> &execution_ptr,
                                  std::unique_ptr<Strategy> &strategy_ptr,
                                  PriceCollection &price_coll,
                                  PositionHandler &pos_handler,
                                  SignalHandler &sig_handler,
-                                 const parameters_t& strategy_params );
+                                 const parameters_t& strategy_params,
+                                 uint64_t run_index ) const;
 
         // Parse data without strategy signals
         void run_notrade( Account &account,
                           std::unique_ptr<DataFeed> &datafeed,
                           const parameters_t& strategy_params );
 
-        // Run single backtest
+        // Run single backtest (reentrant: all per-run state is returned)
+        BacktestResult run( const BacktestRequest &request ) const;
+
+        // Run single backtest, and store its counters/dates
+        // into member variables
         void run_backtest( Account &account,
                            std::unique_ptr<DataFeed> &datafeed,
                            const parameters_t& strategy_params );
 
+        // Run single backtest and compute its summary metrics,
+        // through the backtest cache (if enabled)
+        void run_cached_backtest( BacktestRecord &record,
+                                  const BacktestRequest &request,
+                                  bool with_ticks = false ) const;
+
+        // Run single backtest over in-sample data followed by out-of-sample
+        // data, and compute summary metrics of trades exiting up to 'split'
+        // (in-sample) and after it (out-of-sample, starting on 'oos_start')
+        void run_split_backtest( BacktestRecord &record_is,
+                                 BacktestRecord &record_oos,
+                                 const BacktestRequest &request,
+                                 const DateTime &split,
+                                 const Date &oos_start, int is_bars,
+                                 int is_days, bool with_ticks = false ) const;
+
+        // Run backtests over 'search_space' in parallel, store summary
+        // metrics into 'records' (same order as 'search_space')
+        void run_parallel_backtests(
+                                const std::vector<parameters_t> &search_space,
+                                std::vector<BacktestRecord> &records,
+                                const std::unique_ptr<DataFeed> &datafeed,
+                                bool random_noise = false ) const;
+
         // Run exhaustive parallel optimization
         void run_parallel_optimization(
                                 const std::vector<parameters_t> &search_space,
@@ -132,6 +296,18 @@ class BTfast {
                                         std::unique_ptr<DataFeed> &datafeed,
                                         bool sort_results, bool verbose );
 
+        // Run exhaustive parallel optimization over entry filters
+        // 'filter_names', evaluated as masks over trades when possible
+        void run_filter_optimization(
+                                const std::vector<parameters_t> &search_space,
+                                const std::vector<std::string> &filter_names,
+                                        std::vector<strategy_t> &optim_results,
+                                        const std::string &optim_file,
+                                        const std::string &paramfile,
+                                        const std::string &fitness_metric,
+                                        std::unique_ptr<DataFeed> &datafeed,
+                                        bool sort_results, bool verbose );
+
         // Run exhaustive serial optimization
         void run_optimization( const std::vector<parameters_t> &search_space,
                                std::vector<strategy_t> &optim_results,
@@ -141,6 +317,69 @@ class BTfast {
                                std::unique_ptr<DataFeed> &datafeed,
                                bool sort_results, bool verbose );
 
+        // Run successive halving (parallel) optimization
+        void run_halving_optimization(
+                                const std::vector<parameters_t> &search_space,
+                                std::vector<strategy_t> &optim_results,
+                                const std::string &optim_file,
+                                const std::string &paramfile,
+                                const std::string &fitness_metric,
+                                std::unique_ptr<DataFeed> &datafeed,
+                                int eta, int rungs );
+
+        // Run island-model genetic (parallel) optimization
+        void run_island_optimization( std::vector<parameters_t> &search_space,
+                                      std::vector<strategy_t> &optim_results,
+                                      const std::string &optim_file,
+                                      const std::string &paramfile,
+                                      const std::string &fitness_metric,
+                                      std::unique_ptr<DataFeed> &datafeed,
+                                      int population_size, int generations,
+                                      int islands, int migration_interval,
+                                      int migrants );
+
+        // Run NSGA-II multi-objective (parallel) optimization
+        void run_nsga2_optimization( std::vector<parameters_t> &search_space,
+                                     std::vector<strategy_t> &optim_results,
+                                     const std::string &optim_file,
+                                     const std::string &paramfile,
+                                     const std::string &fitness_metric,
+                                     std::unique_ptr<DataFeed> &datafeed,
+                                     int population_size, int generations,
+                            const std::vector<std::string> &objectives );
+
+        // Run sampling (parallel) optimization, without building
+        // the search space
+        void run_sampling_optimization( const param_ranges_t &parameter_ranges,
+                                        std::vector<strategy_t> &optim_results,
+                                        const std::string &optim_file,
+                                        const std::string &paramfile,
+                                        const std::string &fitness_metric,
+                                        std::unique_ptr<DataFeed> &datafeed,
+                                        int samples, const std::string &method,
+                                        int refine_rounds );
+
+        // Run coarse-to-fine (parallel) optimization, without building
+        // the search space
+        void run_refinement_optimization(
+                                    const param_ranges_t &parameter_ranges,
+                                    std::vector<strategy_t> &optim_results,
+                                    const std::string &optim_file,
+                                    const std::string &paramfile,
+                                    const std::string &fitness_metric,
+                                    std::unique_ptr<DataFeed> &datafeed,
+                                    int coarse_factor, int refine_top );
+
+        // Run surrogate-guided (parallel) optimization, without building
+        // the search space
+        void run_surrogate_optimization( const param_ranges_t &parameter_ranges,
+                                         std::vector<strategy_t> &optim_results,
+                                         const std::string &optim_file,
+                                         const std::string &paramfile,
+                                         const std::string &fitness_metric,
+                                         std::unique_ptr<DataFeed> &datafeed,
+                                         int budget, int batch_size );
+
         // Run genetic (parallel) optimization
         void run_genetic_optimization( std::vector<parameters_t> &search_space,
                                        std::vector<strategy_t> &optim_results,
@@ -169,12 +408,27 @@ class BTfast {
         const std::array<double, 7>& co_range_dow() const { return(co_range_dow_); }
         const std::vector<double>& hl_range() const { return(hl_range_); }
         const std::vector<std::pair<Date, double>>& eod_prices() const { return(eod_prices_); }
+        const param_deps_t& param_dependencies() const { return(param_deps_); }
+        bool combined_is_oos() const { return(combined_is_oos_); }
+        int factory_pruning() const { return(factory_pruning_); }
 
         // Setters
         void set_random_noise( bool value ) { random_noise_ = value; }
         void set_first_date_parsed( Date d ) { first_date_parsed_ = d; }
         void set_last_date_parsed( Date d ) { last_date_parsed_ = d; }
         void set_day_counter( int c ) { day_counter_ = c; }
+        void set_cache( BacktestCache *cache ) { cache_ = cache; }
+        void set_pruning( const PruningRules *rules ) { pruning_ = rules; }
+        void set_param_dependencies( const param_deps_t &deps ) { param_deps_ = deps; }
+        void set_genetic_options( const std::string &selection,
+                                  bool steady_state ) {
+            ga_selection_ = selection;
+            ga_steady_state_ = steady_state;
+        }
+        void set_filter_mask( bool value ) { filter_mask_ = value; }
+        void set_combined_is_oos( bool value ) { combined_is_oos_ = value; }
+        void set_factory_pruning( int value ) { factory_pruning_ = value; }
+        void set_parsed_info( const BacktestRecord &record );
 
 };
 
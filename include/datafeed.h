@@ -44,6 +44,7 @@ class DataFeed {
         // Pure virtual functions (overridden by derived objects)
         virtual std::string type() const = 0;
         virtual std::string data_file() const = 0;
+        virtual std::string data_file_path() const = 0;
         virtual int csv_format() const = 0;
         virtual Date start_date() const = 0;
         virtual Date end_date() const = 0;
@@ -59,6 +60,14 @@ class DataFeed {
         virtual void set_data_file(std::string f) = 0;
 
         virtual std::unique_ptr<DataFeed> clone() const = 0;
+
+        // True if streamed bars already include random noise
+        virtual bool random_noise() const { return(false); }
+
+        // First/last date of the bars to stream (start/end date,
+        // if not known without parsing)
+        virtual Date first_date() const { return( start_date() ); }
+        virtual Date last_date() const { return( end_date() ); }
 };
 
 
@@ -53,11 +53,14 @@ class HistoricalBarsCSV : public DataFeed {
         // Functions overriding the base class pure virtual functions
         std::string type() const override { return(type_); }
         std::string data_file() const override { return(data_file_); }
+        std::string data_file_path() const override { return(data_file_path_); }
         int csv_format() const override { return(csv_format_); }
         Date start_date() const override { return(start_date_); }
         Date end_date() const override { return(end_date_); }
         bool continue_parsing() const override { return(continue_parsing_); }
         int tot_bars() const override { return(1); } // not defined
+        Date first_date() const override;
+        Date last_date() const override;
         void open_data_connection() override;
         void close_data_connection() override;
         void reset_cursor() override;
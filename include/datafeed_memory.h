@@ -0,0 +1,174 @@
+#ifndef DATAFEED_MEMORY_H
+#define DATAFEED_MEMORY_H
+
+#include "datafeed.h"
+
+#include <cstdint>      // uint8_t, uint64_t
+#include <map>          // std::map
+#include <vector>       // std::vector
+
+/*!
+Bars parsed from a datafeed, stored column-wise in memory.
+Filled once by load_bar_series, then shared (read-only) by all
+HistoricalBarsMemory datafeeds streaming it.
+*/
+struct BarSeries {
+    std::vector<DateTime> timestamps {};
+    std::vector<double> open {};
+    std::vector<double> high {};
+    std::vector<double> low {};
+    std::vector<double> close {};
+    std::vector<int> volume {};
+
+    size_t size() const { return( timestamps.size() ); }
+};
+
+
+/*!
+Stream historical bars from a BarSeries in memory (no file parsing),
+optionally adding gaussian noise to each bar.
+
+The noise of all bars of the run is generated in bulk when the connection
+is opened (utils_random::bulk_bar_noise), into the column buffers
+noise_z_, noise_field_. Bars are identical to those of the source
+datafeed with random noise added by PriceCollection, for the same run index.
+
+Type, data file, format and dates are those of the source datafeed
+(the bars are the same), so that results of backtests on this datafeed
+are interchangeable with those on the source (e.g. in BacktestCache).
+A window of the series (e.g. in-sample/out-of-sample windows of
+walk-forward optimization) is streamed after set_window(), or after
+changing start/end dates: the series is still shared, only the range of
+streamed bars changes.
+
+Member Variables:
+- series_: bar series (shared among copies)
+- type_, data_file_, data_file_path_, csv_format_, start_date_, end_date_:
+    taken from source datafeed
+- random_noise_: switch to add random noise to bars
+- run_index_: index of the run, identifying its noise streams
+- noise_z_: standard gaussian number of each bar
+- noise_field_: OHLC field changed by noise, for each bar (1,2,3,4 = O,H,L,C)
+- begin_, end_: range [begin_, end_) of bars of the series to stream
+- cursor_: index of next bar to stream
+- continue_parsing_: switch to control parsing
+*/
+
+
+class HistoricalBarsMemory : public DataFeed {
+
+    std::shared_ptr<const BarSeries> series_ {nullptr};
+    std::string type_ {""};
+    std::string data_file_ {""};
+    std::string data_file_path_ {""};
+    int csv_format_ {1};
+    Date start_date_ {};
+    Date end_date_ {};
+    bool random_noise_ {false};
+    uint64_t run_index_ {0};
+    std::vector<double> noise_z_ {};
+    std::vector<uint8_t> noise_field_ {};
+    size_t begin_ {0};
+    size_t end_ {0};
+    size_t cursor_ {0};
+    bool continue_parsing_ {true};
+
+
+    public:
+        // Constructor
+        HistoricalBarsMemory( const DataFeed &source,
+                              std::shared_ptr<const BarSeries> series,
+                              bool random_noise = false,
+                              uint64_t run_index = 0 );
+
+        bool random_noise() const override { return(random_noise_); }
+
+        // Stream only bars with date in [first, last] (also set as
+        // start/end dates of the datafeed)
+        void set_window( const Date &first, const Date &last );
+
+    private:
+        // Functions overriding the base class pure virtual functions
+        std::string type() const override { return(type_); }
+        std::string data_file() const override { return(data_file_); }
+        std::string data_file_path() const override { return(data_file_path_); }
+        int csv_format() const override { return(csv_format_); }
+        Date start_date() const override { return(start_date_); }
+        Date end_date() const override { return(end_date_); }
+        bool continue_parsing() const override { return(continue_parsing_); }
+        int tot_bars() const override { return( (int) (end_ - begin_) ); }
+        Date first_date() const override;
+        Date last_date() const override;
+        void open_data_connection() override;
+        void close_data_connection() override;
+        void reset_cursor() override;
+        void stream_next_bar() override;
+
+        void set_start_date(Date d) override { set_window( d, end_date_ ); }
+        void set_end_date(Date d) override { set_window( start_date_, d ); }
+        // Not allowed (exit): bars of another file are not in memory
+        void set_data_file(std::string f) override;
+
+        std::unique_ptr<DataFeed> clone() const override;
+};
+
+
+// ------------------------------------------------------------------------- //
+/*! Parse all bars of 'datafeed' (on a copy) into a new BarSeries
+*/
+std::shared_ptr<const BarSeries> load_bar_series( const DataFeed &datafeed );
+
+
+/*!
+Pool of bar series shared by the jobs of a batch (run mode 9), so that
+jobs on the same data parse them only once.
+
+Series are keyed by data file, format, symbol, timeframe and dates of the
+datafeed. When the series in the pool take more than memory_budget_ bytes,
+the least recently used ones which are not streamed by any datafeed
+are released.
+
+Member Variables:
+- memory_budget_: max memory of series in the pool, in bytes (0: no limit)
+- entries_: series in the pool (by key), with their memory and last use
+- clock_: counter of requests (time of last use of entries)
+- loads_, hits_: series parsed from file, and taken from the pool
+*/
+class BarSeriesPool {
+
+    struct Entry {
+        std::shared_ptr<const BarSeries> series {nullptr};
+        size_t bytes {0};
+        size_t last_use {0};
+    };
+
+    size_t memory_budget_ {0};
+    std::map<std::string, Entry> entries_ {};
+    size_t clock_ {0};
+    int loads_ {0};
+    int hits_ {0};
+
+    // Release least recently used series not in use, down to budget
+    void evict();
+
+    public:
+        // Constructor
+        BarSeriesPool( size_t memory_budget = 0 );
+
+        // Series of 'datafeed' (parsed on first request)
+        std::shared_ptr<const BarSeries> get( const DataFeed &datafeed );
+        // Release all series not in use
+        void clear();
+        // Memory of series in the pool, in bytes
+        size_t memory_used() const;
+        // Print series parsed/reused and memory on stdout
+        void print_statistics() const;
+
+        // Key of series of 'datafeed'
+        static std::string key( const DataFeed &datafeed );
+        // Approximate memory of 'series', in bytes
+        static size_t memory_size( const BarSeries &series );
+};
+
+
+#endif
@@ -4,6 +4,7 @@
 #include "events.h"
 
 
+#include <cstdint>      // uint64_t
 #include <deque>        // std::deque
 #include <memory>       // std::unique_ptr
 
@@ -51,6 +52,7 @@ class ExecutionHandler {
     assign unique_ptr to that object.
 */
 void select_execution( std::unique_ptr<ExecutionHandler>& execution_ptr,
-                        bool include_commissions, int slippage );
+                        bool include_commissions, int slippage,
+                        uint64_t run_index );
 
 #endif
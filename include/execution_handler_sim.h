@@ -2,6 +2,7 @@
 #define EXECUTION_HANDLER_SIM_H
 
 #include "execution_handler.h"
+#include "utils_random.h"       // RandomStream
 
 
 /*!
@@ -10,6 +11,7 @@ Class providing simulated (ideal) execution, without broker.
 Member Variables
 - include_commissions_: switch to include commission costs in fill event
 - slippage_: max number of ticks for slippage on entry/exit
+- rng_: random stream of the run (tickets, slippage)
 
 */
 
@@ -19,13 +21,14 @@ class SimulatedExecution : public ExecutionHandler {
 
     bool include_commissions_{false};
     int slippage_ {0};
+    mutable utils_random::RandomStream rng_;
     //bool with_commissions_ {false};
 
 
     public:
         // Constructor
         SimulatedExecution( bool include_commissions = false,
-                            int slippage = 0 );
+                            int slippage = 0, uint64_t run_index = 0 );
 
 
     private:
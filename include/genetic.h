@@ -1,7 +1,13 @@
 #ifndef GENETIC_H
 #define GENETIC_H
 
+#include "backtest_cache.h" // BacktestRecord
 #include "btfast.h"
+#include "strategy_index.h" // ParamValuesHash
+#include "utils_random.h"   // RandomStream
+
+#include <atomic>           // std::atomic
+#include <unordered_map>    // std::unordered_map
 
 
 /*!
@@ -14,6 +20,17 @@
 using gene_t = single_param_t;
 // Chromosome: vector of genes, e.g. [ ("p1", 2), ("p2", 7), ... ]
 using chromosome_t = parameters_t;
+// Fitness of chromosomes already evaluated, by gene values
+// (of canonical chromosome, see utils_params::canonical_parameters)
+using fitness_memo_t = std::unordered_map<std::vector<int>, double,
+                                          ParamValuesHash>;
+
+// ------------------------------------------------------------------------- //
+/*! Key of 'chromosome' in fitness memo: gene values of its canonical
+    representative (equivalent chromosomes have the same key)
+*/
+std::vector<int> chromosome_key( const chromosome_t &chromosome,
+                                 const param_deps_t &deps );
 
 // ------------------------------------------------------------------------- //
 /*! Class representing single individual in population
@@ -33,19 +50,23 @@ class Individual {
 
     public:
         Individual(chromosome_t chromosome = {});
-        std::string tostring();
+        std::string tostring() const;
 
-        void compute_individual_fitness(BTfast &btf,
+        void compute_individual_fitness(const BTfast &btf,
                                         std::unique_ptr<DataFeed> &datafeed,
                                         std::string metric,
-                                        std::vector<strategy_t> &optim_results);
-        void single_crossover(Individual &parent2, double crossover_rate );
-        void uniform_crossover(Individual &parent2);
-        void mutate(const std::vector<chromosome_t> &search_space);
+                                        BacktestRecord &record );
+        void single_crossover(Individual &parent2, double crossover_rate,
+                              utils_random::RandomStream &rng );
+        void uniform_crossover(Individual &parent2,
+                               utils_random::RandomStream &rng );
+        void mutate(const std::vector<chromosome_t> &search_space,
+                    utils_random::RandomStream &rng );
         void set_probability( double p ) { probability_ = p; };
+        void set_fitness( double f ) { fitness_ = f; };
         void set_chromosome(int i, gene_t new_gene){chromosome_[i] = new_gene;}
 
-        chromosome_t chromosome() const { return(chromosome_); }
+        const chromosome_t& chromosome() const { return(chromosome_); }
         double fitness() const { return(fitness_); }
         double probability() const { return(probability_); }
 };
@@ -54,11 +75,20 @@ class Individual {
 // ------------------------------------------------------------------------- //
 /*! Class representing collection of individuals
 
+Selection of parents (selection_):
+- "tournament": best of tournament_size_ individuals drawn at random,
+                O(tournament_size_) per selection, any sign of fitness
+- "roulette": fitness-proportionate selection, O(1) per selection
+              with the alias table built by set_probabilities()
+
 Member Variables
 - population_size_: number of individuals in population
 - fitness_metrc_: performance metric to maximize
+- selection_: selection method ("roulette", default, or "tournament")
+- tournament_size_: number of individuals in each tournament
 - population_: collection (vector) of individuals
 - total_fitness_: sum of fitness of all individuals in population
+- alias_prob_, alias_index_: alias table of probabilities (roulette)
 
 */
 
@@ -66,33 +96,80 @@ class Population {
 
     int population_size_{100};
     std::string fitness_metric_ {"AvgTrade"};
+    std::string selection_ {"roulette"};
+    int tournament_size_ {3};
     std::vector<Individual> population_;
     double total_fitness_{0};
+    std::vector<double> alias_prob_ {};
+    std::vector<int> alias_index_ {};
 
     public:
-        Population( int population_size, std::string fitness_metric );
+        Population( int population_size, std::string fitness_metric,
+                    std::string selection = "roulette" );
 
-        void initialize_population(std::vector<chromosome_t> &search_space);
-        void print_population();
+        void initialize_population(std::vector<chromosome_t> &search_space,
+                                   utils_random::RandomStream &rng );
+        void print_population() const;
         bool sort_by_fitness(const Individual& a, const Individual& b);
         void sort();
         void set_total_fitness();
         void set_probabilities();
 
-        void compute_population_fitness(BTfast &btf,
+        void compute_population_fitness(const BTfast &btf,
                                         std::unique_ptr<DataFeed> &datafeed,
-                                        std::vector<strategy_t> &optim_results);
-        Individual select();
+                                        std::vector<strategy_t> &optim_results,
+                                        fitness_memo_t &memo );
+        void update_selection();
+        const Individual& select( utils_random::RandomStream &rng ) const;
+        Individual breed( const std::vector<chromosome_t> &search_space,
+                          double mutation_rate,
+                          utils_random::RandomStream &rng ) const;
+        bool replace_worst( const Individual &offspring );
+        Population next_generation(
+                            const std::vector<chromosome_t> &search_space,
+                            double mutation_rate, int elite_num,
+                            utils_random::RandomStream &rng ) const;
         void mutate( const std::vector<chromosome_t> &search_space,
-                     double mutation_rate, int exclude_first = 2 );
+                     double mutation_rate, int exclude_first,
+                     utils_random::RandomStream &rng );
 
-        void insert_individual(Individual &ind){ population_.push_back(ind); }
+        void insert_individual(const Individual &ind){ population_.push_back(ind); }
         double total_fitness() const { return(total_fitness_); }
-        std::vector<Individual> population() const { return(population_); }
+        const std::string& fitness_metric() const { return(fitness_metric_); }
+        const std::vector<Individual>& population() const { return(population_); }
 
 };
 
 
+// ------------------------------------------------------------------------- //
+/*! Lock-free single-slot mailbox of migrants between islands
+    (island model of genetic optimization).
+
+    Written by one island (post) and read by another one (collect),
+    without blocking: the slot is claimed with a compare-and-swap on state_,
+    and a post (collect) fails if the slot is busy or full (empty).
+    A failed post drops the migrants, so fast islands never wait for slow
+    ones.
+
+Member Variables
+- state_: 0 = empty, 1 = being written, 2 = full, 3 = being read
+- migrants_: individuals posted
+*/
+
+class Mailbox {
+
+    std::atomic<int> state_ {0};
+    std::vector<Individual> migrants_ {};
+
+    public:
+        // Post 'migrants' if mailbox empty (return false otherwise)
+        bool post( const std::vector<Individual> &migrants );
+        // Move migrants into 'migrants' if mailbox full
+        // (return false otherwise)
+        bool collect( std::vector<Individual> &migrants );
+};
+
+
 
 
 #endif
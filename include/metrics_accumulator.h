@@ -0,0 +1,147 @@
+#ifndef METRICS_ACCUMULATOR_H
+#define METRICS_ACCUMULATOR_H
+
+#include "transaction.h"
+
+
+// ------------------------------------------------------------------------- //
+/*! Groups of performance metrics, as bit flags.
+    Each run mode declares the groups it consumes, and only those
+    (with their prerequisites, see metric_prerequisites) are computed,
+    by MetricsAccumulator and Performance.
+*/
+enum MetricGroup : unsigned {
+    metric_basic = 1,       // ntrades, net P/L, avg trade/ticks, wins/losses,
+                            // win %, profit factor, expectancy
+    metric_dispersion = 2,  // std of trades/ticks, z-score
+    metric_drawdown = 4,    // drawdowns, NP/MDD, TS index, min capital
+    metric_years = 8,       // number of years, profitable years
+    metric_growth = 16,     // CAGR, MAR
+    metric_streaks = 32,    // max consecutive wins/losses
+    metric_rsquared = 64,   // R^2 of equity line
+    metric_sides = 128,     // separate metrics of long/short trades
+                            // (Performance only)
+
+    // metrics written in optimization results (utils_optim)
+    metric_optim = metric_basic | metric_dispersion | metric_drawdown,
+    // metrics stored in BacktestRecord (optimization + validation)
+    metric_record = metric_optim | metric_years,
+    // full performance report
+    metric_all = 255
+};
+
+// ------------------------------------------------------------------------- //
+/*! Groups in 'needed' together with all their prerequisites
+    (all groups require basic metrics; growth requires years and drawdown)
+*/
+inline unsigned metric_prerequisites( unsigned needed )
+{
+    if( needed & metric_growth ){
+        needed |= metric_years | metric_drawdown;
+    }
+    return( needed | metric_basic );
+}
+
+
+/*!
+Summary metrics of a list of trades, in fixed layout.
+Same definitions as the corresponding entries of Performance maps
+(trades with 0 contracts are discarded).
+*/
+struct TradeMetrics {
+    int ntrades {0};
+    int nwins {0};
+    double net_pl {0.0};
+    double avg_trade {0.0};
+    double std_trade {0.0};
+    double avg_ticks {0.0};
+    double std_ticks {0.0};
+    double gross_profit {0.0};
+    double gross_loss {0.0};
+    double max_profit {0.0};
+    double max_loss {0.0};
+    double avg_profit {0.0};
+    double avg_loss {0.0};
+    double win_perc {0.0};
+    double profit_factor {0.0};
+    double expectancy {0.0};
+    double max_dd {0.0};
+    double netpl_maxdd {0.0};
+    double zscore {0.0};
+    int nyears {0};
+    int profitable_yrs {0};
+};
+
+
+/*!
+Online (single-pass) accumulator of trade metrics, updated on each
+closed trade, so that metrics are available at the end of a backtest
+without storing or copying the transaction history.
+
+Mean/variance of profits and ticks use Welford's update (the means
+themselves are taken from running sums, as utils_math::mean),
+drawdown is tracked on the running cumulative P/L, yearly average ticks
+on the running sums of the current year.
+Only the groups in needed_ are updated (others are left to 0).
+
+Member Variables
+- needed_: groups of metrics to compute (MetricGroup flags)
+- ntrades_, nwins_: number of trades, of winning trades
+- sum_pl_, mean_pl_, m2_pl_: sum, Welford mean and sum of squared
+                             deviations of profits
+- sum_ticks_, mean_ticks_, m2_ticks_: same, for ticks
+- gross_profit_, gross_loss_: sum of profits (> 0), losses (<= 0)
+- max_profit_, max_loss_: largest profit, loss
+- cumul_pl_, max_cumul_pl_: cumulative P/L, its maximum
+- max_dd_: max drawdown (negative value)
+- year_: year of last trade exit
+- year_sum_ticks_, year_ntrades_: sum of ticks, number of trades in year_
+- nyears_closed_, profitable_yrs_closed_: number of years (profitable years)
+                                          before year_
+*/
+
+// ------------------------------------------------------------------------- //
+// Class for MetricsAccumulator
+
+class MetricsAccumulator {
+
+    unsigned needed_ {metric_record};
+    int ntrades_ {0};
+    int nwins_ {0};
+    double sum_pl_ {0.0};
+    double mean_pl_ {0.0};
+    double m2_pl_ {0.0};
+    double sum_ticks_ {0.0};
+    double mean_ticks_ {0.0};
+    double m2_ticks_ {0.0};
+    double gross_profit_ {0.0};
+    double gross_loss_ {0.0};
+    double max_profit_ {0.0};
+    double max_loss_ {0.0};
+    double cumul_pl_ {0.0};
+    double max_cumul_pl_ {0.0};
+    double max_dd_ {0.0};
+    int year_ {0};
+    double year_sum_ticks_ {0.0};
+    int year_ntrades_ {0};
+    int nyears_closed_ {0};
+    int profitable_yrs_closed_ {0};
+
+    public:
+        // constructor
+        MetricsAccumulator( unsigned needed = metric_record );
+
+        // Update metrics with new closed trade
+        void add_trade( const Transaction &trade );
+
+        // Metrics of all trades added so far
+        TradeMetrics metrics() const;
+
+        // Getters
+        unsigned needed() const { return(needed_); }
+        int ntrades() const { return(ntrades_); }
+        double max_loss() const { return(max_loss_); }
+};
+
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef PERFORMANCE_H
 #define PERFORMANCE_H
 
+#include "metrics_accumulator.h"  // MetricGroup
 #include "transaction.h"
 
 #include <unordered_map> // std::unordered_map
@@ -48,10 +49,11 @@ class Performance {
         Performance( double initial_balance, //int ndays,
                      std::vector<Transaction> transactions);
 
-        void compute_metrics();
+        void compute_metrics( unsigned needed = metric_all );
         void compute_metrics(
                         const std::vector<Transaction> &transactions,
-                        std::unordered_map<std::string,double> &metrics );
+                        std::unordered_map<std::string,double> &metrics,
+                        unsigned needed );
 
         void drawdown( const std::vector<double> &profits,
                        const std::vector<Date>& dates_vec,
@@ -3,6 +3,7 @@
 
 #include "events.h"
 
+#include <cstdint>          // uint32_t, uint64_t
 #include <unordered_map>    // std::unordered_map
 #include <deque>
 
@@ -21,8 +22,11 @@ Member Variables:
 - timeframe_: timeframe
 - max_bars_back_: max number of bars in deque, for each symbol/tf.
 - random_noise_: switch to control random noise added to data
+- run_index_: index of the run, identifying its noise streams
+- bar_index_: number of bars received (one noise stream per bar)
 - bar_collection_: nested unordered_map { "symbol_name", {"tf", deque<Event>} }
 - delta_: time difference (in hours,mins) of 1 timeframe bar
+- sessions_: number of session ("D") bars started
 - [tf_list_: list of requested timeframes]
 
 
@@ -39,15 +43,19 @@ class PriceCollection {
     std::string timeframe_ {""};
     int max_bars_back_{100};
     bool random_noise_ {false};
+    uint64_t run_index_ {0};
+    uint32_t bar_index_ {0};
     std::unordered_map< std::string,
         std::unordered_map< std::string, std::deque<Event> > > bar_collection_;
     Time delta_ {};
+    int sessions_ {0};
 
 
     public:
         // constructor
         PriceCollection( const Instrument &symbol, std::string timeframe,
-                        int max_bars_back, bool random_noise);
+                        int max_bars_back, bool random_noise,
+                        uint64_t run_index );
 
 
         // Actions on new incoming bar event
@@ -64,6 +72,7 @@ class PriceCollection {
         int max_bars_back() const { return(max_bars_back_); }
         std::string symbol_name() const { return(symbol_name_); }
         std::string timeframe() const { return(timeframe_); }
+        int sessions() const { return(sessions_); }
 
 
         const std::unordered_map< std::string,
@@ -0,0 +1,110 @@
+#ifndef PRUNING_H
+#define PRUNING_H
+
+#include "datetime.h"               // Date
+#include "metrics_accumulator.h"    // TradeMetrics
+
+#include <functional>   // std::function
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+
+/*!
+Running state of a backtest, passed to pruning predicates.
+
+- metrics: metrics of the trades closed so far (optimization metrics)
+- days_elapsed: calendar days from the first bar parsed
+- days_remaining: calendar days from the last bar parsed to the end of data
+                  (estimated, see PruningRules)
+- sessions_elapsed: sessions (days) parsed, including the current one
+- open_trades: number of open positions
+- max_trades_per_session: max number of trades the strategy can open in a
+                          session (Strategy::max_trades_per_session,
+                          0: no limit)
+*/
+struct PruningState {
+    TradeMetrics metrics {};
+    int days_elapsed {0};
+    int days_remaining {0};
+    int sessions_elapsed {0};
+    int open_trades {0};
+    int max_trades_per_session {0};
+};
+
+// Predicate returning true if a backtest can be stopped
+using pruning_predicate_t = std::function<bool(const PruningState&)>;
+
+
+/*!
+Set of pruning predicates registered by a run mode, checked by BTfast::run
+on the running metrics of a backtest: as soon as one of them is true,
+the backtest is stopped and its result marked as pruned.
+
+Only backtests whose result is discarded if they fail a selection
+(e.g. strategy generation) should be pruned: metrics of pruned backtests
+are partial.
+
+Rules are either bounds (min_trades: the backtest is stopped only if it
+cannot pass, whatever the remaining data) or heuristic projections of
+running rates (min_npmdd: may stop backtests which would recover later).
+
+Predicates are checked every check_days_ days parsed, after
+min_days_ days (so that running rates are meaningful).
+The end of data is given by the run mode (e.g. DataFeed::last_date):
+if it is later than the actual one, remaining days are overestimated,
+which only makes pruning more conservative.
+
+Member Variables
+- rules_: (name, predicate) of each rule
+- data_end_: last date of data
+- check_days_: number of days parsed between two checks
+- min_days_: number of days parsed before the first check
+*/
+
+// ------------------------------------------------------------------------- //
+// Class for PruningRules
+
+class PruningRules {
+
+    std::vector<std::pair<std::string, pruning_predicate_t>> rules_ {};
+    Date data_end_ {};
+    int check_days_ {20};
+    int min_days_ {365};
+
+    public:
+        // constructor
+        PruningRules( const Date &data_end, int check_days = 20,
+                      int min_days = 365 );
+
+        // Register new rule
+        void add( const std::string &name, pruning_predicate_t predicate );
+
+        // Index of first rule true on 'state' (-1 if none)
+        int check( const PruningState &state ) const;
+
+        // Getters
+        bool empty() const { return( rules_.empty() ); }
+        const std::string& rule_name( int i ) const { return(rules_[i].first); }
+        const Date& data_end() const { return(data_end_); }
+        int check_days() const { return(check_days_); }
+        int min_days() const { return(min_days_); }
+
+        // ----------------------------------------------------------------- //
+        // Common rules
+
+        // Bound: number of trades cannot exceed 'min_trades' by the end of
+        // data, even with the max number of trades in every remaining
+        // session (never true if the strategy has no such max)
+        static pruning_predicate_t min_trades( double min_trades );
+
+        // Heuristic: NP/MDD cannot exceed 'min_npmdd' by the end of data:
+        // running max drawdown already requires more net profit than
+        // reachable with 'slack' (> 1) times the current gross profit rate
+        // and no more losses
+        static pruning_predicate_t min_npmdd( double min_npmdd,
+                                              double slack = 1.5 );
+};
+
+
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef RANDOM_FOREST_H
+#define RANDOM_FOREST_H
+
+#include <cstdint>      // uint64_t
+#include <vector>       // std::vector
+
+
+/*!
+Random forest regressor (no external dependencies), used as surrogate
+model of the fitness of parameter combinations.
+
+Each tree is a regression tree (CART, least squares splits) grown on a
+bootstrap sample of the training points, considering a random subset of
+features at each split, down to leaves of at least min_leaf_ points.
+Prediction: mean and standard deviation of the predictions of the trees
+(the spread among trees measures the uncertainty of the surrogate).
+
+Trees are grown in parallel. Tree t draws from its own random stream
+(sampling domain, run index given to fit(), substream t), so the forest
+does not depend on the number of threads.
+
+Member Variables
+- trees_: nodes of each tree (root = node 0)
+- num_trees_: number of trees
+- min_leaf_: minimum number of training points in each leaf
+*/
+
+// ------------------------------------------------------------------------- //
+// Class for RandomForest
+
+class RandomForest {
+
+    // Node of regression tree: internal (feature >= 0) or leaf (feature -1)
+    struct Node {
+        int feature {-1};
+        double threshold {0.0};     // go left if x[feature] <= threshold
+        int left {-1};
+        int right {-1};
+        double value {0.0};         // prediction of leaf
+    };
+
+    std::vector<std::vector<Node>> trees_ {};
+    int num_trees_ {50};
+    int min_leaf_ {2};
+
+    public:
+        // constructor
+        RandomForest( int num_trees = 50, int min_leaf = 2 );
+
+        // Grow trees on training points 'x' (one row per point) with
+        // targets 'y'. 'run_index': index of random streams
+        void fit( const std::vector<std::vector<double>> &x,
+                  const std::vector<double> &y, uint64_t run_index );
+
+        // Mean and standard deviation of tree predictions at point 'x'
+        void predict( const std::vector<double> &x,
+                      double &mean, double &stdev ) const;
+};
+
+
+
+#endif
@@ -2,6 +2,7 @@
 #define RUN_MODES_H
 
 #include "btfast.h"
+#include "utils_fileio.h"   // OptimizerSettings
 
 
 /*!
@@ -38,7 +39,7 @@ void mode_single_bt( BTfast &btf,
                          const std::string &optim_file,
                          const std::string &param_file,
                          const std::string &fitness_metric,
-                         int population_size, int generations );
+                         const OptimizerSettings &optimizer );
 
 // ------------------------------------------------------------------------- //
 // Validation for Single Strategy (Backtest + Validation)
@@ -52,6 +53,7 @@ void mode_single_validation( BTfast &btf,
                              const std::string &data_dir,
                              const std::string &data_file_oos,
                              int max_variation_pct, int num_noise_tests,
+                             int validation_target,
                              const std::string &noise_file );
 
 
@@ -70,6 +72,7 @@ void mode_factory( BTfast &btf,
                    const std::string &data_dir,
                    const std::string &data_file_oos,
                    int max_variation_pct, int num_noise_tests,
+                   int validation_target,
                    const std::string &noise_file );
 
 // ------------------------------------------------------------------------- //
@@ -87,6 +90,7 @@ void mode_factory_sequential( BTfast &btf,
                              const std::string &data_dir,
                              const std::string &data_file_oos,
                              int max_variation_pct, int num_noise_tests,
+                             int validation_target,
                              const std::string &noise_file );
 
 
@@ -109,4 +113,21 @@ void mode_noise( BTfast &btf,
                  const std::string &param_file,
                  const std::string &fitness_metric );
 
+// ------------------------------------------------------------------------- //
+// Bootstrap of Trades for Single Strategy
+void mode_bootstrap( BTfast &btf,
+                     std::unique_ptr<DataFeed> &datafeed,
+                     const param_ranges_t &parameter_ranges,
+                     int num_resamples, int block_size,
+                     const std::string &bootstrap_file );
+
+// ------------------------------------------------------------------------- //
+// Walk-forward Optimization (Parallel windows)
+void mode_walkforward( BTfast &btf,
+                       std::unique_ptr<DataFeed> &datafeed,
+                       param_ranges_t &parameter_ranges,
+                       const std::string &fitness_metric,
+                       int windows, int is_ratio, bool anchored,
+                       const std::string &walkforward_file );
+
 #endif
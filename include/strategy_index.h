@@ -0,0 +1,96 @@
+#ifndef STRATEGY_INDEX_H
+#define STRATEGY_INDEX_H
+
+#include "btfast.h"         // strategy_t, parameters_t
+
+
+#include <string>           // std::string
+#include <unordered_map>    // std::unordered_map
+#include <vector>           // std::vector
+
+
+/*!
+Class providing hashed lookup of optimization results by parameter values,
+to find neighbours of a strategy (same parameters, except one or two of them
+set to a given value) in O(1) instead of scanning the whole result vector.
+
+All strategies are assumed to share the same parameter names and order
+(as for the results of a single optimization). Rows whose parameters do not
+match the layout of the first row are not indexed.
+If several rows have the same parameters, the first one is returned.
+
+The index stores row numbers into 'strategies_': the vector must outlive
+the index and must not be modified after the index has been built.
+
+Member Variables
+- strategies_: vector of strategies (optimization results) being indexed
+- param_names_: parameter names (common to all indexed strategies)
+- index_: map from parameter values to row number in strategies_
+*/
+
+
+// ------------------------------------------------------------------------- //
+/*! Hash of vector of parameter values (combine as in boost::hash_combine)
+*/
+struct ParamValuesHash {
+    size_t operator()( const std::vector<int> &values ) const;
+};
+
+
+// ------------------------------------------------------------------------- //
+// Class for StrategyIndex
+
+class StrategyIndex {
+
+    const std::vector<strategy_t> &strategies_;
+
+    std::vector<std::string> param_names_ {};
+    std::unordered_map<std::vector<int>, size_t, ParamValuesHash> index_ {};
+
+    // Parameter values of 'strat', in the indexed order.
+    // Return false if 'strat' does not match the indexed layout
+    bool parameter_values( const strategy_t &strat,
+                           std::vector<int> &values ) const;
+    bool parameter_values( const parameters_t &params,
+                           std::vector<int> &values ) const;
+
+    // Position of parameter 'par_name' in param_names_ (-1 if not found)
+    int parameter_position( const std::string &par_name ) const;
+
+    public:
+        // constructor
+        StrategyIndex( const std::vector<strategy_t> &strategies );
+
+        // Row of strategy with parameter values 'values' (nullptr if absent)
+        const strategy_t* find( const std::vector<int> &values ) const;
+
+        // Row of strategy with same parameters as 'strat' (nullptr if absent)
+        const strategy_t* find( const strategy_t &strat ) const;
+
+        // Row of strategy with parameters 'params' (nullptr if absent)
+        const strategy_t* find( const parameters_t &params ) const;
+
+        // Row of strategy equal to 'strat' except with parameter 'par_name'
+        // set to 'value' (nullptr if absent)
+        const strategy_t* find_with( const strategy_t &strat,
+                                     const std::string &par_name,
+                                     int value ) const;
+
+        // Row of strategy equal to 'strat' except with parameters
+        // 'par_name_1', 'par_name_2' set to 'value_1', 'value_2'
+        // (nullptr if absent)
+        const strategy_t* find_with( const strategy_t &strat,
+                                     const std::string &par_name_1,
+                                     int value_1,
+                                     const std::string &par_name_2,
+                                     int value_2 ) const;
+
+        // Getters
+        size_t size() const { return(index_.size()); }
+        const std::vector<std::string>& param_names() const
+                                                { return(param_names_); }
+};
+
+
+
+#endif
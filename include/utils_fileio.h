@@ -5,7 +5,53 @@
 #include "datetime.h"
 
 #include <string>           // std::string
-
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+
+// Settings (Name, Value) overriding those of configuration file,
+// e.g. [ ("SYMBOL_NAME", "GC"), ("RUN_MODE", "4") ]
+using setting_overrides_t = std::vector<std::pair<std::string, std::string>>;
+
+/*!
+Settings of the optimization algorithms (run modes 2x, factory),
+read from configuration file.
+
+- population_size: number of individuals in population (GA, NSGA-II)
+- generations: max number of generations (GA, NSGA-II)
+- halving_eta: inverse fraction of candidates kept at each rung
+               (successive halving)
+- halving_rungs: number of rungs (successive halving)
+- islands: number of islands (island GA)
+- migration_interval: generations between migrations (island GA)
+- migrants: individuals sent by each island at each migration (island GA)
+- pareto_objectives: metrics maximized (NSGA-II)
+- samples: number of combinations sampled (sampling optimization)
+- sampling_method: "sobol" or "lhs" (sampling optimization)
+- sampling_refine: rounds of adaptive refinement (sampling optimization)
+- coarse_factor: stride of coarse grid (coarse-to-fine optimization)
+- refine_top: best combinations refined at each level
+              (coarse-to-fine optimization)
+- surrogate_budget: total number of backtests (surrogate optimization)
+- surrogate_batch: backtests of each iteration (surrogate optimization)
+*/
+struct OptimizerSettings {
+    int population_size {100};
+    int generations {10};
+    int halving_eta {3};
+    int halving_rungs {3};
+    int islands {4};
+    int migration_interval {5};
+    int migrants {2};
+    std::vector<std::string> pareto_objectives { "Ntrades", "AvgTicks",
+                                                 "NP/MDD", "Z-score" };
+    int samples {1000};
+    std::string sampling_method {"sobol"};
+    int sampling_refine {0};
+    int coarse_factor {4};
+    int refine_top {3};
+    int surrogate_budget {200};
+    int surrogate_batch {20};
+};
 
 // Set of Utility functions for file input/output
 
@@ -16,6 +62,7 @@ namespace utils_fileio {
     // --------------------------------------------------------------------- //
     /*! Read input settings from configuration XML file
         and store them into variables passed by reference.
+        Settings in 'overrides' replace those in the file.
     */
     void read_config_file( std::string config_file, std::string &main_dir,
                         int &run_mode,
@@ -27,13 +74,28 @@ namespace utils_fileio {
                         bool &print_progress,
                         bool &print_performance_report, bool &print_trade_list,
                         bool &write_trades_to_file, std::string &fitness_metric,
-                        int &population_size, int &generations,
+                        OptimizerSettings &optimizer,
                         int &max_bars_back, double &initial_balance,
                         std::string &position_size_type,
                         int &num_contracts, double &risk_fraction,
                         bool &include_commissions, int &slippage,
                         std::string &data_file_oos,
-                        int &max_variation_pct, int &num_noise_tests );
+                        int &max_variation_pct, int &num_noise_tests,
+                        int &validation_target, int &random_seed,
+                        int &backtest_cache, int &bootstrap_resamples,
+                        int &bootstrap_block_size,
+                        std::string &ga_selection, bool &ga_steady_state,
+                        bool &filter_mask,
+                        int &wf_windows, int &wf_is_ratio, bool &wf_anchored,
+                        bool &combined_is_oos, int &factory_pruning,
+                        std::string &batch_file, int &batch_memory_mb,
+                        const setting_overrides_t &overrides = {} );
+
+    // --------------------------------------------------------------------- //
+    /*! Read jobs of a batch from XML batch file: settings overridden
+        by each job
+    */
+    std::vector<setting_overrides_t> read_batch_file( std::string batch_file );
 
     // --------------------------------------------------------------------- //
     /*! Read parameter values/ranges from  XML parameter file
@@ -41,6 +103,12 @@ namespace utils_fileio {
     */
     param_ranges_t read_param_file( std::string paramfile );
 
+    // --------------------------------------------------------------------- //
+    /*! Read dependencies among parameters (<ActiveIf> nodes)
+        from XML parameter file
+    */
+    param_deps_t read_param_dependencies( std::string paramfile );
+
 
     // --------------------------------------------------------------------- //
     /*! Copy (append) content of file 'inputfile' to file 'outputfile'
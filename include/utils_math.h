@@ -49,17 +49,6 @@ namespace utils_math {
     /*! Standard deviation of vector (unbiased sample std, with 1/(N-1))
     */
     double stdev( const std::vector<double> &v );
-
-    // ------------------------------------------------------------------------- //
-    /*! Compute the ranks of each element in 'v' and store it in 'ranks'
-    */
-    void ranks( const std::vector<double> &v, std::vector<double> &ranks );
-
-    // --------------------------------------------------------------------- //
-    /*! Mann-Whitney U test of two samples. Returns the two-sided p-value.
-    */
-    double mannwhitney( const std::vector<double> &v,
-                         const std::vector<double> &w );
 }
 
 
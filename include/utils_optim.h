@@ -2,6 +2,7 @@
 #define UTILS_OPTIM_H
 
 #include "btfast.h"         // strategy_t alias
+#include "backtest_cache.h" // BacktestRecord
 #include "performance.h"
 //#include "position_handler.h"
 
@@ -19,6 +20,11 @@ namespace utils_optim {
                                 const Performance& perform,
                                 const parameters_t& parameters ) ;
 
+    // Same as above, with performance metrics stored in 'record'
+    void append_to_optim_results(std::vector<strategy_t> &optim,
+                                const BacktestRecord& record,
+                                const parameters_t& parameters ) ;
+
     // Binary predicate function to compare two strategy_t objects
     bool equal_strategies( const strategy_t &a, const strategy_t &b );
     // Binary predicate function to compare the metrics of two strategy_t objects    
@@ -48,6 +54,23 @@ namespace utils_optim {
     // --------------------------------------------------------------------- //
     // Sort optimizaiton results by fitness metric
     void sort_by_metric( std::vector<strategy_t> &optim, std::string metric );
+
+    // --------------------------------------------------------------------- //
+    // Pareto optimization (all objectives maximized).
+    // 'objectives': objective values of each solution (one row per solution)
+
+    // True if solution 'a' dominates solution 'b'
+    bool dominates( const std::vector<double> &a, const std::vector<double> &b );
+
+    // Non-dominated sorting: indices of solutions in each front
+    // (front 0 = Pareto front)
+    std::vector<std::vector<int>> nondominated_fronts(
+                        const std::vector<std::vector<double>> &objectives );
+
+    // Crowding distance of each solution in 'front' (same order)
+    std::vector<double> crowding_distance(
+                        const std::vector<std::vector<double>> &objectives,
+                        const std::vector<int> &front );
 }
 
 
@@ -2,6 +2,7 @@
 #define UTILS_PARAMS_H
 
 #include "btfast.h"         // strategy_t, parameters_t, param_ranges_t
+#include "strategy_index.h" // StrategyIndex
 
 
 //#include <queue>            // std::queue
@@ -71,6 +72,44 @@ namespace utils_params {
     */
     std::vector<parameters_t> cartesian_product( param_ranges_t &v );
 
+    // --------------------------------------------------------------------- //
+    /*!  Combination of grid 'v' at position 'index' (index[i] = position
+         of value of i-th parameter in its range), without building
+         the Cartesian product:
+
+            v = [ ("p1", [10]), ("p2", [2,4,6,8]) ], index = [0, 2]
+            -> [ ("p1", 10), ("p2", 6) ]
+    */
+    parameters_t parameters_from_indices( const param_ranges_t &v,
+                                          const std::vector<int> &index );
+
+    // --------------------------------------------------------------------- //
+    /*!  Inverse of parameters_from_indices: position in grid 'v' of the
+         values of 'params' (-1 if a value is not in its range)
+    */
+    std::vector<int> indices_from_parameters( const param_ranges_t &v,
+                                              const parameters_t &params );
+
+    // --------------------------------------------------------------------- //
+    /*!  Canonical representative of combination 'params': each parameter
+         inactive according to 'deps' is set to its inactive value
+         (equivalent combinations have the same representative)
+    */
+    parameters_t canonical_parameters( const parameters_t &params,
+                                       const param_deps_t &deps );
+
+    // --------------------------------------------------------------------- //
+    /*!  Split 'search_space' into classes of equivalent combinations
+         (same canonical representative, according to 'deps').
+         Representatives are stored into 'canonical' (in order of first
+         appearance), and the class of each combination into 'class_index'
+         (search_space[i] is equivalent to canonical[class_index[i]])
+    */
+    void canonical_search_space( const std::vector<parameters_t> &search_space,
+                                 const param_deps_t &deps,
+                                 std::vector<parameters_t> &canonical,
+                                 std::vector<size_t> &class_index );
+
     // --------------------------------------------------------------------- //
     /*!  Extract only the parameter values from all strategies in 'source'
          (ignoring the entries with performance metrics)
@@ -211,6 +250,24 @@ namespace utils_params {
                                         strategy_t ref_strat,
                                         const std::vector<strategy_t> &source );
 
+    // --------------------------------------------------------------------- //
+    /*!  Same as no_filter_strategy() above, with hashed lookup in 'index'
+         (built over the strategies to be searched) instead of linear scan.
+    */
+    strategy_t no_filter_strategy( const std::string &filter_name,
+                                   const strategy_t &ref_strat,
+                                   const StrategyIndex &index );
+
+    // --------------------------------------------------------------------- //
+    /*!  Same as no_two_filters_strategy() above, with hashed lookup in
+         'index' (built over the strategies to be searched)
+         instead of linear scan.
+    */
+    strategy_t no_two_filters_strategy( const std::string &filter_name_1,
+                                        const std::string &filter_name_2,
+                                        const strategy_t &ref_strat,
+                                        const StrategyIndex &index );
+
     // --------------------------------------------------------------------- //
     /*!  Extract parameter range vector from all strategies in 'source'
          name 'par_name' and replace parameter vector in 'dest'
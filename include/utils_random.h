@@ -3,21 +3,203 @@
 
 #include "events.h"
 
-#include <random>           // std::mt19937
+#include <array>            // std::array
+#include <cstddef>          // size_t
+#include <cstdint>          // uint32_t, uint64_t, uint8_t
+#include <utility>          // std::swap
+#include <vector>           // std::vector
 
 // Set of Utility functions for random numbers
 
 
 namespace utils_random {
 
-    /*! Standard mersenne twister random generator (global)
+    // --------------------------------------------------------------------- //
+    /*! Domains of random streams: streams of different domains are
+        independent, even with same run/substream indices
+    */
+    enum StreamDomain : uint32_t {
+        noise_domain = 1,       // random noise added to bars
+        execution_domain = 2,   // slippage and tickets of simulated execution
+        genetic_domain = 3,     // genetic operators
+        stats_domain = 4,       // resampling in statistical tests
+        sampling_domain = 5     // sampling of parameter space
+    };
+
+
+    // --------------------------------------------------------------------- //
+    /*! Philox4x32 constants
+    */
+    constexpr uint32_t philox_m0 { 0xD2511F53 };
+    constexpr uint32_t philox_m1 { 0xCD9E8D57 };
+    constexpr uint32_t philox_w0 { 0x9E3779B9 };
+    constexpr uint32_t philox_w1 { 0xBB67AE85 };
+
+    // --------------------------------------------------------------------- //
+    /*! Philox4x32-10 block function: 10 rounds on counter 'x' (in place)
+        with key (k0, k1). Branch-free, so that loops over many counters
+        can be vectorized.
+    */
+    inline void philox4x32_10( uint32_t x[4], uint32_t k0, uint32_t k1 )
+    {
+        for( int round = 0; round < 10; round++ ){
+            uint64_t p0 { (uint64_t) philox_m0 * x[0] };
+            uint64_t p1 { (uint64_t) philox_m1 * x[2] };
+            uint32_t y0 { (uint32_t) (p1 >> 32) ^ x[1] ^ k0 };
+            uint32_t y2 { (uint32_t) (p0 >> 32) ^ x[3] ^ k1 };
+            x[0] = y0;
+            x[1] = (uint32_t) p1;
+            x[2] = y2;
+            x[3] = (uint32_t) p0;
+            k0 += philox_w0;
+            k1 += philox_w1;
+        }
+    }
+
+    // --------------------------------------------------------------------- //
+    /*! Counter-based random stream (Philox4x32-10 generator).
+
+        Each stream is identified by (seed, domain, run index, substream)
+        and is stateless apart from its counter: no state is shared among
+        streams, so each backtest (or each bar of a backtest) can derive
+        its own independent stream, and results do not depend on the
+        number of threads nor on the order of execution.
+
+        Satisfies the UniformRandomBitGenerator requirements.
+
+        Member Variables
+        - key_: key of Philox generator (from seed and domain)
+        - counter_: counter of Philox generator
+                    [block index, substream, run index (low), run index (high)]
+        - block_: last output block (4 random 32-bit integers)
+        - pos_: position of next output in block_
+    */
+    class RandomStream {
+
+        std::array<uint32_t, 2> key_ {};
+        std::array<uint32_t, 4> counter_ {};
+        std::array<uint32_t, 4> block_ {};
+        int pos_ {4};
+
+        public:
+            using result_type = uint32_t;
+
+            // constructor
+            RandomStream( uint64_t seed, uint32_t domain,
+                          uint64_t run_index, uint32_t substream );
+
+            // Next random 32-bit integer
+            uint32_t operator()();
+
+            static constexpr uint32_t min() { return(0); }
+            static constexpr uint32_t max() { return(UINT32_MAX); }
+    };
+
+
+    // --------------------------------------------------------------------- //
+    /*! Sobol low-discrepancy sequence in [0,1)^dims (dims <= max_dims),
+        generated in Gray-code order, with direction numbers of
+        Joe & Kuo (new-joe-kuo-6.21201). The first point (origin) is skipped.
+        A random digital shift (XOR of each coordinate with a random
+        32-bit integer) can be applied, to randomize the sequence while
+        keeping its low discrepancy.
+
+        Member Variables
+        - directions_: direction numbers of each dimension (32 bits)
+        - shift_: digital shift of each dimension (0 if not randomized)
+        - x_: current point (32-bit integer coordinates)
+        - index_: index of current point
+    */
+    class SobolSequence {
+
+        std::vector<std::array<uint32_t, 32>> directions_ {};
+        std::vector<uint32_t> shift_ {};
+        std::vector<uint32_t> x_ {};
+        uint32_t index_ {0};
+
+        public:
+            static constexpr size_t max_dims {21};
+
+            // constructor ('rng' = nullptr: no digital shift)
+            SobolSequence( size_t dims, RandomStream *rng = nullptr );
+
+            // Next point of sequence, into 'u' (size dims)
+            void next( std::vector<double> &u );
+    };
+
+
+    // --------------------------------------------------------------------- //
+    /*! Latin hypercube sample of 'n' points in [0,1)^dims: in each
+        dimension, each of the 'n' strata [k/n, (k+1)/n) contains exactly
+        one point (random position within stratum)
+    */
+    std::vector<std::vector<double>> latin_hypercube( size_t n, size_t dims,
+                                                      RandomStream &rng );
+
+
+    // --------------------------------------------------------------------- //
+    /*! Set/get global seed of all random streams.
+        Seed 0 means non-reproducible seed (from std::random_device).
+    */
+    void set_global_seed( uint64_t seed );
+    uint64_t global_seed();
+
+    // --------------------------------------------------------------------- //
+    /*! Random real number uniformly distributed in [0,1)
+    */
+    double uniform01( RandomStream &rng );
+
+    // --------------------------------------------------------------------- //
+    /*! Random integer uniformly distributed in [a,b]
+    */
+    int uniform_int( RandomStream &rng, int a, int b );
+
+    // --------------------------------------------------------------------- //
+    /*! Random real number from normal distribution N(mean, stdev^2)
+        (Box-Muller transform)
+    */
+    double gaussian( RandomStream &rng, double mean, double stdev );
+
+    // --------------------------------------------------------------------- //
+    /*! Random permutation of 'v' (Fisher-Yates shuffle)
+    */
+    template <typename T>
+    void shuffle( std::vector<T> &v, RandomStream &rng )
+    {
+        for( int i = (int) v.size() - 1; i > 0; i-- ){
+            std::swap( v[i], v[uniform_int( rng, 0, i )] );
+        }
+    }
+
+    // --------------------------------------------------------------------- //
+    /*! Noise of bar 'bar_index' in run 'run_index' (noise domain):
+        standard gaussian number 'z' and OHLC field to change
+        ('field' = 1,2,3,4 for open, high, low, close).
+        Both come from the first block of stream
+        (global seed, noise_domain, run_index, bar_index).
+    */
+    void bar_noise( uint64_t run_index, uint32_t bar_index,
+                    double &z, int &field );
+
+    // --------------------------------------------------------------------- //
+    /*! Noise of all bars [0, nbars) of run 'run_index', in bulk,
+        into preallocated column buffers 'z' and 'field' (size nbars).
+        Same values as bar_noise() for each bar.
+    */
+    void bulk_bar_noise( uint64_t run_index, size_t nbars,
+                         double *z, uint8_t *field );
+
+    // --------------------------------------------------------------------- //
+    /*! Add gaussian noise to bar, given standard gaussian number 'z'
+        and OHLC field to change (as from bar_noise)
     */
-    extern std::mt19937 rand_generator;
+    void add_gaussian_noise( Event &bar, double z, int field );
 
     // --------------------------------------------------------------------- //
-    /*! Add gaussian noise to bar
+    /*! Add gaussian noise to bar 'bar_index' of run 'run_index'
     */
-    void add_gaussian_noise( Event &bar );
+    void add_gaussian_noise( Event &bar, uint64_t run_index,
+                             uint32_t bar_index );
 }
 
 
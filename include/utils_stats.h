@@ -0,0 +1,52 @@
+#ifndef UTILS_STATS_H
+#define UTILS_STATS_H
+
+#include <cstdint>  // uint64_t
+#include <vector>   // std::vector
+
+// Set of rank statistics and nonparametric tests of two samples.
+// All functions sort at most once per sample (O(n log n)) and reuse
+// per-thread scratch buffers across calls (no allocation after warm-up);
+// they are safe to call concurrently from different threads.
+
+
+namespace utils_stats {
+
+    // --------------------------------------------------------------------- //
+    /*! Ranks (1-based) of each element in 'v', stored into 'ranks'.
+        Tied elements get the average of their ranks.
+        Return the tie term sum_t (t^3 - t), over groups of t tied elements.
+    */
+    double ranks( const std::vector<double> &v, std::vector<double> &ranks );
+
+    // --------------------------------------------------------------------- //
+    /*! Mann-Whitney U test of two samples, with tie correction of the
+        variance of U (normal approximation). Returns the two-sided p-value.
+    */
+    double mannwhitney( const std::vector<double> &v,
+                        const std::vector<double> &w );
+
+    // --------------------------------------------------------------------- //
+    /*! Two-sample Kolmogorov-Smirnov test. Returns the p-value
+        (asymptotic Kolmogorov distribution, with Stephens correction),
+        and stores the statistic D = max|F_v - F_w| into 'statistic',
+        if not null.
+    */
+    double kolmogorov_smirnov( const std::vector<double> &v,
+                               const std::vector<double> &w,
+                               double *statistic = nullptr );
+
+    // --------------------------------------------------------------------- //
+    /*! Two-sided permutation test of the difference of means of two samples,
+        with 'num_permutations' random relabelings.
+        Returns the p-value (count + 1) / (num_permutations + 1).
+        Random relabelings come from stream 'run_index' of the stats domain
+        (same p-value for same global seed and run index).
+    */
+    double permutation_test( const std::vector<double> &v,
+                             const std::vector<double> &w,
+                             int num_permutations, uint64_t run_index = 0 );
+}
+
+
+#endif
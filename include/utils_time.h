@@ -36,6 +36,11 @@ namespace utils_time {
     */
     Date actual_end_date( const std::string &input_end_date );
 
+    // --------------------------------------------------------------------- //
+    /*! Date 'ndays' calendar days after 'date' (before, if 'ndays' < 0)
+    */
+    Date add_days( const Date &date, int ndays );
+
 }
 
 
@@ -1,9 +1,12 @@
 #ifndef VALIDATION_H
 #define VALIDATION_H
 
+#include "backtest_cache.h"     // BacktestRecord
 #include "btfast.h"     // strategy_t alias
 #include "instruments.h"
+#include "strategy_index.h"     // StrategyIndex
 
+#include <atomic>   // std::atomic
 #include <vector>   // std::vector
 
 /*!
@@ -22,7 +25,22 @@ Member Variables
 - fitness_metric: performance metric used to compare OOS with IS
 - max_variation_: max variation of performance metric allowed by stability test
 - num_noise_tests_: number of randomization tests when adding noise
+- validation_target_: stop validating new strategies once this number of
+                      strategies passed full validation (0: no limit)
 - noise_file_: file to store results of randomization tests
+- generation_index_: hashed lookup of generation results (all rows
+                     generated in-process by the run mode, if given to the
+                     constructor, otherwise empty) by parameter values,
+                     to reuse them as neighbours in profitability and
+                     stability tests
+- reused_backtests_, total_backtests_: neighbours taken from generation
+                                       results, and all neighbours needed
+- datafeed_combined_: in-memory datafeed over in-sample data followed by
+                      out-of-sample data (if BTfast::combined_is_oos()),
+                      to run IS and OOS backtests as a single one
+- split_time_: time of last in-sample bar of datafeed_combined_
+- oos_start_: date of first out-of-sample bar of datafeed_combined_
+- is_bars_, is_days_: number of bars and days of in-sample data
 
 [- date_i_: initial selected date to parse]
 [- date_f_: final selected date to parse]
@@ -48,12 +66,77 @@ class Validation {
     //std::string data_file_oos_path_ {""};
     double max_variation_ { 0.3 };
     int num_noise_tests_;
+    int validation_target_ {0};
     const std::string &noise_file_;
+    StrategyIndex generation_index_;
+    mutable std::atomic<long long> reused_backtests_ {0};
+    mutable std::atomic<long long> total_backtests_ {0};
+    std::unique_ptr<DataFeed> datafeed_combined_ {nullptr};
+    DateTime split_time_ {};
+    Date oos_start_ {};
+    int is_bars_ {0};
+    int is_days_ {0};
 
     //Date date_i_ {};
     //Date date_f_ {};
     //double OOSfraction_ {0.0};
 
+    // Backtests over one optimization parameter of a strategy (profitability
+    // test), as range [begin, end) of a search space
+    struct ProfitabilityBlock {
+        std::string optim_param_name {""};
+        size_t begin {0};
+        size_t end {0};
+    };
+
+    // Instantiate OOS datafeed (same settings as datafeed_, on data_file_oos_)
+    void make_datafeed_oos( std::unique_ptr<DataFeed> &datafeed_oos ) const;
+
+    // Instantiate datafeed_combined_ (IS data followed by OOS data)
+    void make_datafeed_combined();
+
+    // Run IS and OOS backtests of 'strat_params' as a single backtest
+    // on datafeed_combined_
+    void run_combined_backtest( const parameters_t &strat_params,
+                                BacktestRecord &record_is,
+                                BacktestRecord &record_oos,
+                                bool with_ticks ) const;
+
+    // Run IS and OOS backtests of all 'input_strategies' in parallel
+    void run_IS_OOS_backtests( const std::vector<strategy_t> &input_strategies,
+                               std::vector<BacktestRecord> &records_is,
+                               std::vector<BacktestRecord> &records_oos,
+                               bool with_ticks ) const;
+
+    // Append backtests of profitability test of 'strat' to 'search_space'
+    void append_profitability_space( const strategy_t &strat,
+                                std::vector<parameters_t> &search_space,
+                                std::vector<ProfitabilityBlock> &blocks ) const;
+
+    // Results of backtests of 'search_space' (in order), taken from
+    // generation results when available, otherwise run in parallel
+    void reuse_or_run_backtests( const std::vector<parameters_t> &search_space,
+                                 std::vector<strategy_t> &results ) const;
+
+    // Single strategy tests (reentrant, no output on stdout)
+    bool OOS_metrics_passed( const strategy_t &strat,
+                             const DataFeed &datafeed_oos ) const;
+    bool OOS_consistency_passed( const strategy_t &strat,
+                                 const DataFeed &datafeed_oos ) const;
+    bool profitability_passed( const strategy_t &strat ) const;
+    bool stability_passed( const strategy_t &strat ) const;
+    bool noise_passed( const strategy_t &strat ) const;
+
+    // Number of consecutive validation tests passed by 'strat'
+    int validation_chain( const strategy_t &strat,
+                          const DataFeed &datafeed_oos ) const;
+    // Validation pipeline (strategies stream through all tests)
+    void validation_pipeline( const std::vector<strategy_t> &input_strategies,
+                        std::vector<std::vector<strategy_t>> &passed_tests );
+    // Validation by stages (all strategies complete each test before the next)
+    void validation_stages( const std::vector<strategy_t> &input_strategies,
+                        std::vector<std::vector<strategy_t>> &passed_tests );
+
 
     public:
         // constructor
@@ -67,7 +150,10 @@ class Validation {
                     const std::string &data_dir,
                     const std::string &data_file_oos,
                     int max_variation_pct, int num_noise_tests,
-                    const std::string &noise_file );
+                    int validation_target,
+                    const std::string &noise_file,
+                    const std::vector<strategy_t> *generation_results
+                                                                = nullptr );
 
         // full validation process
         void run_validation();
@@ -84,13 +170,19 @@ class Validation {
         void OOS_metrics_test( const std::vector<strategy_t> &input_strategies,
                                std::vector<strategy_t> &output_strategies );
 
+        bool OOS_metrics_conditions( const BacktestRecord &performance_is,
+                                const BacktestRecord &performance_oos ) const;
+
         void OOS_consistency_test( const std::vector<strategy_t> &input_strategies,
                                    std::vector<strategy_t> &output_strategies );
+        bool OOS_consistency_conditions( const BacktestRecord &record_is,
+                                    const BacktestRecord &record_oos ) const;
 
         void profitability_test( const std::vector<strategy_t> &input_strategies,
                                  std::vector<strategy_t> &output_strategies );
-        bool check_profitability( const parameters_t& strat_params,
-                                  const std::string &optim_param_name );
+        bool profitability_conditions(
+                                const std::vector<strategy_t> &results,
+                                size_t begin, size_t end ) const;
 
         void stability_test( const std::vector<strategy_t> &input_strategies,
                              std::vector<strategy_t> &output_strategies );
@@ -98,6 +190,10 @@ class Validation {
         void noise_test( const std::vector<strategy_t> &input_strategies,
                          std::vector<strategy_t> &output_strategies,
                          bool write_to_file );
+        void run_noise_backtests( const strategy_t &strat,
+                                  std::vector<strategy_t> &noise_results ) const;
+        bool noise_conditions( const std::vector<strategy_t> &noise_results,
+                               bool print_levels ) const;
 
 
         //void selection_conditions_OOS( const std::vector<strategy_t> &OOS_run);
@@ -19,11 +19,14 @@ Account::Account(double initial_balance)
 
 
 //-------------------------------------------------------------------------- //
-/*! Add new trade to transaction history
+/*! Add new trade to transaction history (if kept) and update metrics
 */
 void Account::add_transaction_to_history(Transaction new_trade)
 {
-    transactions_.push_back(new_trade);
+    metrics_.add_trade(new_trade);
+    if( keep_transactions_ ){
+        transactions_.push_back(new_trade);
+    }
 }
 
 
@@ -168,20 +171,11 @@ void Account::write_equity_to_file( std::string fname ) const
 //-------------------------------------------------------------------------- //
 /*! Compute  largest losing trade in transactions (negative value)
     Useful for position sizing.
+    (Taken from metrics, available also when transactions are not kept)
 */
 double Account::largest_loss() const
 {
-    if( transactions_.empty() ){
-        return(0.0);
-    }
-    double max_loss {0.0};
-
-    for( const Transaction& tr: transactions_ ){
-        if( tr.net_pl() < max_loss ){
-            max_loss = tr.net_pl();
-        }
-    }
-    return(max_loss);
+    return( metrics_.max_loss() );
 }
 
 //-------------------------------------------------------------------------- //
@@ -192,6 +186,7 @@ void Account::reset( double initial_balance )
     initial_balance_ = initial_balance;
     balance_ = initial_balance;
     transactions_ = std::vector<Transaction> {};
+    metrics_ = MetricsAccumulator { metrics_.needed() };
 }
 
 
@@ -0,0 +1,321 @@
+#include "backtest_cache.h"
+
+#include <iostream>         // std::cout
+#include <sys/stat.h>       // stat, mkdir
+#include <utility>          // std::move
+
+
+namespace {
+
+    // FNV-1a 64-bit hash
+    const uint64_t fnv_offset { 14695981039346656037ULL };
+    const uint64_t fnv_prime { 1099511628211ULL };
+
+    uint64_t fnv1a( const void *data, size_t n, uint64_t h = fnv_offset )
+    {
+        const unsigned char *p { static_cast<const unsigned char*>(data) };
+        for( size_t i = 0; i < n; i++ ){
+            h ^= p[i];
+            h *= fnv_prime;
+        }
+        return(h);
+    }
+
+    uint64_t fnv1a( const std::string &s, uint64_t h )
+    {
+        // include terminating character, to separate consecutive strings
+        return( fnv1a( s.c_str(), s.size() + 1, h ) );
+    }
+
+    // Hash of parameter names and values
+    uint64_t params_hash( const parameters_t &params )
+    {
+        uint64_t h { fnv_offset };
+        for( const auto& p : params ){
+            h = fnv1a( p.first, h );
+            h = fnv1a( &p.second, sizeof(p.second), h );
+        }
+        return(h);
+    }
+
+    // Parameter values, in order (names fixed by the strategy of the context)
+    std::vector<int> param_values( const parameters_t &params )
+    {
+        std::vector<int> values {};
+        values.reserve( params.size() );
+        for( const auto& p : params ){
+            values.push_back( p.second );
+        }
+        return(values);
+    }
+
+    // Write/read a Date as three ints
+    void write_date( FILE *f, const Date &d )
+    {
+        int ymd[3] { d.year(), d.month(), d.day() };
+        fwrite( ymd, sizeof(int), 3, f );
+    }
+    bool read_date( FILE *f, Date &d )
+    {
+        int ymd[3] {};
+        if( fread( ymd, sizeof(int), 3, f ) != 3 ){
+            return(false);
+        }
+        d = Date { ymd[0], ymd[1], ymd[2] };
+        return(true);
+    }
+}
+
+// Build version of the program, part of the cache key
+// (results of a different build are never reused).
+// Set by the Makefile to a checksum of all sources (src, include,
+// Strategies); builds outside the Makefile fall back to the compile time
+// of this file, which misses edits of other files rebuilt separately.
+#ifndef BTFAST_BUILD_VERSION
+#define BTFAST_BUILD_VERSION __DATE__ " " __TIME__
+#endif
+
+// Version of the file format of records, part of the cache key
+// (files written in a different format are never read)
+#define BTFAST_CACHE_FORMAT "2"
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor
+*/
+BacktestCache::BacktestCache( const std::string &cache_dir, bool store_ticks )
+: cache_dir_{cache_dir}, store_ticks_{store_ticks}
+{
+    // create cache directory, if not existing
+    mkdir( cache_dir_.c_str(), 0755 );
+}
+
+// ------------------------------------------------------------------------- //
+/*! Destructor: close all cache files
+*/
+BacktestCache::~BacktestCache()
+{
+    for( auto& f : files_ ){
+        if( f.second != NULL ){
+            fclose( f.second );
+        }
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Hash of the content of file 'path'.
+    Computed once per file, and recomputed only if size/mtime change.
+    Set 'size' to file size in bytes.
+    The file is stat'ed without locking; only the table of hashes is locked
+    (and the file read, the first time).
+*/
+uint64_t BacktestCache::file_content_hash( const std::string &path,
+                                           long long &size )
+{
+    struct stat st {};
+    if( stat( path.c_str(), &st ) != 0 ){
+        size = 0;
+        return( fnv1a( path, fnv_offset ) );
+    }
+    size = (long long) st.st_size;
+    std::lock_guard<std::mutex> lock {hash_mtx_};
+    auto it = file_hashes_.find( path );
+    if( it != file_hashes_.end() && it->second.size == size
+        && it->second.mtime == (long long) st.st_mtime ){
+        return( it->second.hash );
+    }
+
+    uint64_t h { fnv_offset };
+    FILE *f { fopen( path.c_str(), "rb" ) };
+    if( f != NULL ){
+        std::vector<char> buffer( 1 << 20 );
+        size_t n {0};
+        while( (n = fread( buffer.data(), 1, buffer.size(), f )) > 0 ){
+            h = fnv1a( buffer.data(), n, h );
+        }
+        fclose(f);
+    }
+    file_hashes_[path] = FileHash { size, (long long) st.st_mtime, h };
+    return(h);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Context of a backtest on 'datafeed': hash of data content, date range,
+    build version and execution settings ('settings' string, provided by
+    BTfast, includes strategy name), and size of data file in bytes.
+    Computed once per backtest (before lookup, reused by store), without
+    holding the lock on the records.
+*/
+BacktestCache::Context BacktestCache::context( const DataFeed &datafeed,
+                                               const std::string &settings )
+{
+    long long data_size {0};
+    uint64_t h { file_content_hash( datafeed.data_file_path(), data_size ) };
+    h = fnv1a( datafeed.type(), h );
+    h = fnv1a( std::to_string( datafeed.csv_format() ), h );
+    h = fnv1a( datafeed.start_date().tostring(), h );
+    h = fnv1a( datafeed.end_date().tostring(), h );
+    h = fnv1a( std::string { BTFAST_BUILD_VERSION }, h );
+    h = fnv1a( std::string { BTFAST_CACHE_FORMAT }, h );
+    h = fnv1a( settings, h );
+    return( Context { h, data_size } );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Records of context 'ctx'. The first time a context is used, its records
+    are loaded from file and the file is opened for appending new records.
+
+    File format (binary), sequence of records:
+        params hash (uint64), number of parameters (int),
+        parameter values (int), 10 metrics (double), 4 counters (int),
+        2 dates (3 int each), number of ticks (int), ticks (double).
+    Later records override earlier ones with the same params hash.
+*/
+std::unordered_map<uint64_t, BacktestCache::CachedRecord>&
+BacktestCache::context_records( uint64_t ctx )
+{
+    auto it = contexts_.find( ctx );
+    if( it != contexts_.end() ){
+        return( it->second );
+    }
+
+    std::unordered_map<uint64_t, CachedRecord> &records { contexts_[ctx] };
+    char fname[32];
+    snprintf( fname, sizeof(fname), "%016llx.bin", (unsigned long long) ctx );
+    std::string path { cache_dir_ + "/" + fname };
+
+    FILE *f { fopen( path.c_str(), "rb" ) };
+    if( f != NULL ){
+        uint64_t key {0};
+        int nparams {0};
+        double m[10] {};
+        int c[4] {};
+        int nticks {0};
+        while( fread( &key, sizeof(key), 1, f ) == 1 ){
+            CachedRecord cached {};
+            BacktestRecord &rec { cached.record };
+            if( fread( &nparams, sizeof(int), 1, f ) != 1 || nparams < 0 ){
+                break;
+            }
+            cached.param_values.resize( nparams );
+            if( fread( cached.param_values.data(), sizeof(int), nparams, f )
+                    != (size_t) nparams
+                || fread( m, sizeof(double), 10, f ) != 10
+                || fread( c, sizeof(int), 4, f ) != 4
+                || !read_date( f, rec.first_date_parsed )
+                || !read_date( f, rec.last_date_parsed )
+                || fread( &nticks, sizeof(int), 1, f ) != 1 ){
+                break;  // truncated record (e.g. interrupted run)
+            }
+            rec.ntrades = m[0];
+            rec.avgticks = m[1];
+            rec.winperc = m[2];
+            rec.profitfactor = m[3];
+            rec.npmdd = m[4];
+            rec.expectancy = m[5];
+            rec.zscore = m[6];
+            rec.netpl = m[7];
+            rec.avgtrade = m[8];
+            rec.stdticks = m[9];
+            rec.nyears = c[0];
+            rec.profitable_yrs = c[1];
+            rec.bar_counter = c[2];
+            rec.day_counter = c[3];
+            rec.has_ticks = nticks >= 0;
+            if( nticks > 0 ){
+                rec.ticks.resize( nticks );
+                if( fread( rec.ticks.data(), sizeof(double), nticks, f )
+                        != (size_t) nticks ){
+                    break;
+                }
+            }
+            records[key] = std::move( cached );
+        }
+        fclose(f);
+    }
+    files_[ctx] = fopen( path.c_str(), "ab" );
+    if( files_[ctx] == NULL ){
+        std::cout << ">>> WARNING: cannot write backtest cache file "
+                  << path << " (BacktestCache)\n";
+    }
+    return( records );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Search for backtest of context 'ctx' in cache. Return true if found
+    (with list of ticks, if 'with_ticks'), and copy it into 'record'.
+*/
+bool BacktestCache::lookup( const Context &ctx, const parameters_t &params,
+                            bool with_ticks, BacktestRecord &record )
+{
+    std::lock_guard<std::mutex> lock {mtx_};
+    auto &records = context_records( ctx.hash );
+    lookups_++;
+    auto it = records.find( params_hash(params) );
+    if( it == records.end()
+        || it->second.param_values != param_values(params)    // collision
+        || ( with_ticks && !it->second.record.has_ticks ) ){
+        return(false);
+    }
+    hits_++;
+    bytes_saved_ += ctx.data_size;
+    record = it->second.record;
+    return(true);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Store backtest result of context 'ctx' into cache (memory and file)
+*/
+void BacktestCache::store( const Context &ctx, const parameters_t &params,
+                           const BacktestRecord &record )
+{
+    std::lock_guard<std::mutex> lock {mtx_};
+    auto &records = context_records( ctx.hash );
+    uint64_t key { params_hash(params) };
+
+    CachedRecord &cached { records[key] };
+    cached.param_values = param_values(params);
+    cached.record = record;
+    const BacktestRecord &rec { cached.record };
+
+    FILE *f { files_[ctx.hash] };
+    if( f == NULL ){
+        return;
+    }
+    double m[10] { rec.ntrades, rec.avgticks, rec.winperc, rec.profitfactor,
+                   rec.npmdd, rec.expectancy, rec.zscore, rec.netpl,
+                   rec.avgtrade, rec.stdticks };
+    int c[4] { rec.nyears, rec.profitable_yrs,
+               rec.bar_counter, rec.day_counter };
+    int nticks { rec.has_ticks ? (int) rec.ticks.size() : -1 };
+    int nparams { (int) cached.param_values.size() };
+    fwrite( &key, sizeof(key), 1, f );
+    fwrite( &nparams, sizeof(int), 1, f );
+    fwrite( cached.param_values.data(), sizeof(int), nparams, f );
+    fwrite( m, sizeof(double), 10, f );
+    fwrite( c, sizeof(int), 4, f );
+    write_date( f, rec.first_date_parsed );
+    write_date( f, rec.last_date_parsed );
+    fwrite( &nticks, sizeof(int), 1, f );
+    if( nticks > 0 ){
+        fwrite( rec.ticks.data(), sizeof(double), nticks, f );
+    }
+    fflush(f);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Print hit ratio and bytes saved on stdout
+*/
+void BacktestCache::print_statistics() const
+{
+    double hit_ratio { lookups_ > 0 ? 100.0 * hits_ / (double) lookups_ : 0.0 };
+    printf( "\nBacktest cache: %lld hits / %lld lookups (%.1f%%), "
+            "%.1f MB of data parsing saved\n",
+            hits_, lookups_, hit_ratio, bytes_saved_ / (1024.0 * 1024.0) );
+}
@@ -0,0 +1,212 @@
+#include "bootstrap.h"
+
+#include "utils_math.h"     // percentile, mean, stdev
+#include "utils_random.h"   // RandomStream, uniform_int
+
+#include <algorithm>        // std::min
+#include <cmath>            // std::sqrt, std::abs, std::cbrt
+#include <cstdio>           // printf
+#include <iostream>         // std::cout
+#include <numeric>          // std::iota
+
+
+namespace {
+
+    // Names of metrics computed on each resample (as in optimization results)
+    const char *bootstrap_metric_names[4] { "NP/MDD", "MaxDD",
+                                            "Z-score", "AvgTicks" };
+
+    // Number of leading metrics depending on the order of trades
+    // (NP/MDD, MaxDD): the only ones varying under "shuffle"
+    const int path_dependent_metrics {2};
+
+    // Substream of resampling streams, for each method
+    uint32_t method_substream( const std::string &method )
+    {
+        if( method == "iid" ){
+            return(1);
+        }
+        else if( method == "block" ){
+            return(2);
+        }
+        else if( method == "shuffle" ){
+            return(3);
+        }
+        std::cout << ">>> ERROR: invalid bootstrap method " << method
+                  << " (Bootstrap)\n";
+        exit(1);
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor: extract P/L and ticks of trades from 'transactions'
+*/
+Bootstrap::Bootstrap( const std::vector<Transaction> &transactions,
+                      int num_resamples, int block_size, double confidence )
+: num_resamples_{num_resamples}, block_size_{block_size},
+  confidence_{confidence}
+{
+    for( const Transaction &tr: transactions ){
+        if( tr.quantity() > 0 ){
+            profits_.push_back( tr.net_pl() );
+            ticks_.push_back( tr.ticks() );
+        }
+    }
+    if( block_size_ <= 0 ){
+        block_size_ = std::max( 1, (int) std::lround(
+                                        std::cbrt( (double) profits_.size() ) ) );
+    }
+    if( num_resamples_ <= 0 || confidence_ <= 0.0 || confidence_ >= 1.0 ){
+        std::cout << ">>> ERROR: invalid number of resamples or "
+                  << "confidence level (Bootstrap)\n";
+        exit(1);
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Metrics of trade sequence (pl, tk) of n trades, into 'metrics':
+    NP/MDD, MaxDD, Z-score, AvgTicks (same definitions as Performance).
+
+    Sums and squared deviations are SIMD reductions; cumulative sum and
+    running drawdown are a single branch-free pass.
+*/
+void Bootstrap::sequence_metrics( const double *pl, const double *tk,
+                                  size_t n, double metrics[4] )
+{
+    double sum_pl {0.0};
+    double sum_tk {0.0};
+    #pragma omp simd reduction(+:sum_pl,sum_tk)
+    for( size_t i = 0; i < n; i++ ){
+        sum_pl += pl[i];
+        sum_tk += tk[i];
+    }
+    double mean_pl { sum_pl / n };
+    double ss_pl {0.0};
+    #pragma omp simd reduction(+:ss_pl)
+    for( size_t i = 0; i < n; i++ ){
+        ss_pl += ( pl[i] - mean_pl ) * ( pl[i] - mean_pl );
+    }
+    double std_pl { n > 1 ? std::sqrt( ss_pl / (n - 1) ) : 0.0 };
+
+    // Cumulative P/L and max drawdown
+    double cumul {0.0};
+    double peak {0.0};
+    double max_dd {0.0};
+    for( size_t i = 0; i < n; i++ ){
+        cumul += pl[i];
+        peak = std::max( peak, cumul );
+        max_dd = std::min( max_dd, cumul - peak );
+    }
+
+    metrics[0] = max_dd != 0.0 ? sum_pl / std::abs(max_dd) : 0.0;
+    metrics[1] = max_dd;
+    metrics[2] = ( std_pl > 0.0 && n >= 30 ) ? std::sqrt( (double) n )
+                                               * mean_pl / std_pl : 0.0;
+    metrics[3] = sum_tk / n;
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Run 'num_resamples_' resamples of trades with 'method' ("iid", "block",
+    "shuffle") in parallel, and store the confidence intervals of
+    NP/MDD, MaxDD, Z-score, AvgTicks into 'intervals'.
+    With "shuffle", Z-score and AvgTicks are the same on every permutation
+    (degenerate intervals): only NP/MDD and MaxDD are reported.
+*/
+void Bootstrap::run( const std::string &method,
+                     std::vector<BootstrapInterval> &intervals ) const
+{
+    intervals.clear();
+    size_t n { profits_.size() };
+    if( n == 0 ){
+        std::cout << ">>> WARNING: no trades to resample (Bootstrap)\n";
+        return;
+    }
+    uint32_t substream { method_substream( method ) };
+    size_t block { std::min( (size_t) block_size_, n ) };
+
+    // Values of each metric over all resamples
+    std::vector<std::vector<double>> values( 4,
+                                std::vector<double>( num_resamples_ ) );
+
+    #pragma omp parallel
+    {
+        // Per-thread buffers, reused across resamples
+        std::vector<size_t> index( n );
+        std::vector<double> pl( n );
+        std::vector<double> tk( n );
+        double metrics[4] {};
+
+        #pragma omp for schedule(static)
+        for( int r = 0; r < num_resamples_; r++ ){
+
+            utils_random::RandomStream rng { utils_random::global_seed(),
+                                             utils_random::stats_domain,
+                                             (uint64_t) r, substream };
+            // Indices of resampled trades
+            if( substream == 1 ){               // iid
+                for( size_t i = 0; i < n; i++ ){
+                    index[i] = utils_random::uniform_int( rng, 0, (int) n-1 );
+                }
+            }
+            else if( substream == 2 ){          // circular blocks
+                for( size_t i = 0; i < n; i += block ){
+                    size_t start = utils_random::uniform_int( rng, 0, (int) n-1 );
+                    size_t len { std::min( block, n - i ) };
+                    for( size_t k = 0; k < len; k++ ){
+                        index[i+k] = ( start + k ) % n;
+                    }
+                }
+            }
+            else{                               // permutation
+                std::iota( index.begin(), index.end(), 0 );
+                utils_random::shuffle( index, rng );
+            }
+
+            // Gather resampled trades into contiguous buffers
+            for( size_t i = 0; i < n; i++ ){
+                pl[i] = profits_[index[i]];
+                tk[i] = ticks_[index[i]];
+            }
+            sequence_metrics( pl.data(), tk.data(), n, metrics );
+            for( int m = 0; m < 4; m++ ){
+                values[m][r] = metrics[m];
+            }
+        }
+    }
+
+    // Metrics of original sequence
+    double original[4] {};
+    sequence_metrics( profits_.data(), ticks_.data(), n, original );
+
+    int nmetrics { substream == 3 ? path_dependent_metrics : 4 };
+    for( int m = 0; m < nmetrics; m++ ){
+        BootstrapInterval ci {};
+        ci.metric = bootstrap_metric_names[m];
+        ci.value = original[m];
+        ci.mean = utils_math::mean( values[m] );
+        ci.std_error = utils_math::stdev( values[m] );
+        ci.lower = utils_math::percentile( values[m], (1 - confidence_) / 2 );
+        ci.upper = utils_math::percentile( values[m], (1 + confidence_) / 2 );
+        intervals.push_back( ci );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Print intervals on stdout
+*/
+void Bootstrap::print_intervals( const std::string &method,
+                            const std::vector<BootstrapInterval> &intervals )
+{
+    printf("\n    Resampling: %s\n", method.c_str());
+    printf("    %-10s %12s %12s %12s %12s %12s\n", "Metric", "Original",
+           "Mean", "Std Error", "Lower", "Upper");
+    for( const auto& ci: intervals ){
+        printf("    %-10s %12.2f %12.2f %12.2f %12.2f %12.2f\n",
+               ci.metric.c_str(), ci.value, ci.mean, ci.std_error,
+               ci.lower, ci.upper);
+    }
+}
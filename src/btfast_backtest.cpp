@@ -1,9 +1,15 @@
 #include "btfast.h"
 
+#include "backtest_cache.h" // BacktestCache, BacktestRecord
+#include "datafeed_memory.h" // HistoricalBarsMemory, load_bar_series
+#include "metrics_accumulator.h" // MetricsAccumulator, TradeMetrics
 #include "position_sizer.h"
+#include "pruning.h"        // PruningRules
+#include "utils_params.h"   // canonical_parameters
 #include "utils_print.h"    // print_progress
 #include "utils_trade.h"    // FeaturesExtraction
 
+#include <algorithm>        // std::min
 #include <array>            // std::array
 #include <iostream>         // std::cout
 //#include <string>           // std::string
@@ -13,13 +19,14 @@
 */
 void BTfast::initialize_backtest (
                                  std::deque<Event> &events_queue,
-                                 std::unique_ptr<DataFeed> &datafeed_ptr,
+                                 DataFeed *datafeed_ptr,
                                  std::unique_ptr<ExecutionHandler> &execution_ptr,
                                  std::unique_ptr<Strategy> &strategy_ptr,
                                  PriceCollection &price_coll,
                                  PositionHandler &pos_handler,
                                  SignalHandler &sig_handler,
-                                 const parameters_t& strategy_params )
+                                 const parameters_t& strategy_params,
+                                 uint64_t run_index ) const
 {
     // Clear bars in PriceCollection object
     price_coll.clear_bars();
@@ -36,7 +43,8 @@ void BTfast::initialize_backtest (
 
     // Initialize object for simulated execution, derived from ExecutionHandler,
     // and wrap it into the smart pointer 'execution_ptr'
-    select_execution( execution_ptr, include_commissions_, slippage_ );
+    select_execution( execution_ptr, include_commissions_, slippage_,
+                      run_index );
     // Link events queue to Execution Handler
     execution_ptr->set_events_queue(&events_queue);
 
@@ -57,18 +65,39 @@ void BTfast::initialize_backtest (
 
 
 //-------------------------------------------------------------------------- //
-/*! Run single backtest
-    account: reference to a Account object initialized just before
-             running run_backtest().
-    datafeed: smart pointer to DataFeed object
-    strategy_params (const ref): combination of strategy parameters.
+/*! Run single backtest.
+    Reentrant: BTfast members are only read, and all per-run state
+    (account, counters, dates) is returned. Concurrent runs on the same
+    BTfast object are safe, provided each uses its own datafeed.
+
+    If pruning rules are given in the request, they are checked at the
+    start of a new day (every PruningRules::check_days() days), and the
+    run is stopped as soon as one of them is true (result marked as pruned).
 
+    request: datafeed, strategy parameters and per-run switches
+    Return: account with transaction history, counters and dates of the run
 */
 
-void BTfast::run_backtest( Account &account,
-                           std::unique_ptr<DataFeed> &datafeed,
-                           const parameters_t& strategy_params )
+BacktestResult BTfast::run( const BacktestRequest &request ) const
 {
+    DataFeed *datafeed { request.datafeed };
+    const parameters_t &strategy_params { request.strategy_params };
+    if( datafeed == nullptr ){
+        std::cout<< ">>> ERROR: null datafeed in backtest request (run).\n";
+        exit(1);
+    }
+    // Initialize result of the run (account, counters, dates)
+    BacktestResult result { Account { initial_balance_ } };
+    Account &account { result.account };
+    account.set_keep_transactions( request.keep_transactions );
+    const PruningRules *pruning { request.pruning };
+    if( pruning != nullptr && pruning->empty() ){
+        pruning = nullptr;
+    }
+    // pruning rules read optimization metrics
+    account.set_needed_metrics( pruning == nullptr ? request.metrics
+                                        : request.metrics | metric_optim );
+
     // Initalize Events Queue
     std::deque<Event> events_queue;
     // Initialize smart pointer to object derived from ExecutionHandler base class
@@ -76,9 +105,12 @@ void BTfast::run_backtest( Account &account,
     // Initialize smart pointer to object derived from Strategy base class
     std::unique_ptr<Strategy> strategy {nullptr};
     // Initialize Price Collection
-    // (maps containing lists of bars for each symbol/tf)
-    PriceCollection price_collection { symbol_, timeframe_,
-                                       max_bars_back_, random_noise_ };
+    // (maps containing lists of bars for each symbol/tf).
+    // Noise is added here, unless already added by the datafeed
+    PriceCollection price_collection { symbol_, timeframe_, max_bars_back_,
+                                       request.random_noise
+                                        && !datafeed->random_noise(),
+                                       request.run_index };
     // Initialize Position Handler
     PositionHandler position_handler { account };
     // Initialize Position Sizer
@@ -103,11 +135,13 @@ void BTfast::run_backtest( Account &account,
     // Initialize actual initial/final dates parsed from file
     Date first_date_parsed {};
     Date last_date_parsed {};
+    // Whether latest bar parsed started a new session
+    bool session_start {false};
 
     // Initialize all components for backtest
     initialize_backtest( events_queue, datafeed, execution_handler, strategy,
                          price_collection, position_handler, signal_handler,
-                         strategy_params);
+                         strategy_params, request.run_index );
 
     //--- Start loop 
     while ( datafeed->continue_parsing() ) {
@@ -138,16 +172,43 @@ void BTfast::run_backtest( Account &account,
                     else{
                         if( !(event.timestamp().date() == last_date_parsed )){
                             day_count += 1; // update counter of days parsed
+                            // Check pruning rules on trades closed so far
+                            if( pruning != nullptr
+                                && day_count > pruning->min_days()
+                                && day_count % pruning->check_days() == 0 ){
+                                PruningState state {
+                                    account.metrics().metrics(),
+                                    event.timestamp().date().DaysDiff(
+                                                        first_date_parsed ),
+                                    pruning->data_end().DaysDiff(
+                                            event.timestamp().date() ) - 1,
+                                    day_count,
+                                    (int) position_handler.open_positions()
+                                                                    .size(),
+                                    strategy->max_trades_per_session() };
+                                result.pruned_by = pruning->check( state );
+                                if( result.pruned_by >= 0 ){
+                                    result.pruned = true;
+                                    break;  // stop before this bar
+                                }
+                            }
                         }
                         last_date_parsed = event.timestamp().date();
                     }
-                    if( print_progress_ ){   // print progress
+                    if( request.print_progress ){   // print progress
                         utils_print::print_progress( bar_count );
                     }
                     //---
 
                     // Update bar collections with latest bar
+                    int sessions { price_collection.sessions() };
                     price_collection.on_bar(event);
+                    session_start = price_collection.sessions() != sessions;
+                    // Position carried into new session (filter masks)
+                    if( request.mask_filters != nullptr && session_start
+                        && !position_handler.open_positions().empty() ){
+                        result.masks_inexact = true;
+                    }
                     // Update open positions and account status
                     position_handler.on_bar(event);
                     // Compute strategy signals, store them into signals array
@@ -168,6 +229,27 @@ void BTfast::run_backtest( Account &account,
                     // Update account with new fill
                     position_handler.on_fill(event);
 
+                    // Annotate entry with entry filters (filter masks)
+                    if( request.mask_filters != nullptr
+                        && ( event.action() == "BUY"
+                             || event.action() == "SELLSHORT" ) ){
+                        // Entry signal from previous session
+                        if( session_start ){
+                            result.masks_inexact = true;
+                        }
+                        EntryFilterMask mask { event.timestamp(),
+                                    event.action() == "BUY" ? "LONG" : "SHORT",
+                                    std::vector<char> {} };
+                        for( const auto& filter: *request.mask_filters ){
+                            for( int value: filter.second ){
+                                mask.passes.push_back(
+                                    strategy->mask_filter_passes( filter.first,
+                                                value, price_collection ) );
+                            }
+                        }
+                        result.entry_masks.push_back( std::move(mask) );
+                    }
+
                     //<<<
                     /*
                     // Extract market features before entry and write them to file
@@ -193,10 +275,254 @@ void BTfast::run_backtest( Account &account,
 
     //price_collection.print_bars();
 
+    // Set counters/dates of the run
+    result.bar_counter = bar_count;
+    result.day_counter = day_count;
+    result.first_date_parsed = first_date_parsed;
+    result.last_date_parsed  = last_date_parsed;
+
+    return(result);
+}
+
+
+//-------------------------------------------------------------------------- //
+/*! Run single backtest (wrapper of run() ), and store its counters/dates
+    into member variables (read by run modes for printing).
+    Not reentrant: use run() for concurrent backtests.
+
+    account: reference to a Account object initialized just before
+             running run_backtest().
+    datafeed: smart pointer to DataFeed object
+    strategy_params (const ref): combination of strategy parameters.
+*/
+
+void BTfast::run_backtest( Account &account,
+                           std::unique_ptr<DataFeed> &datafeed,
+                           const parameters_t& strategy_params )
+{
+    BacktestResult result { run( BacktestRequest { datafeed.get(),
+                                                   strategy_params,
+                                                   random_noise_,
+                                                   print_progress_ } ) };
+    account = result.account;
+
     // Set member variables
-    bar_counter_ = bar_count;
-    day_counter_ = day_count;
-    first_date_parsed_ = first_date_parsed;
-    last_date_parsed_  = last_date_parsed;
+    bar_counter_ = result.bar_counter;
+    day_counter_ = result.day_counter;
+    first_date_parsed_ = result.first_date_parsed;
+    last_date_parsed_  = result.last_date_parsed;
+}
+
+
 
+//-------------------------------------------------------------------------- //
+/*! Run single backtest and compute its summary metrics into 'record'.
+    If the backtest cache is enabled, the result is taken from the cache
+    when available, otherwise the backtest is run and its result stored.
+    Backtests with random components (noise, slippage) are never cached.
+    Equivalent parameter combinations (parameter dependencies) share the
+    same cache entry.
+
+    Reentrant (as run() ).
+
+    record: summary metrics, counters and dates of the backtest (output)
+    request: datafeed, strategy parameters and per-run switches
+    with_ticks: switch to fill the list of ticks of each trade
+*/
+void BTfast::run_cached_backtest( BacktestRecord &record,
+                                  const BacktestRequest &request,
+                                  bool with_ticks ) const
+{
+    bool use_cache { cache_ != nullptr && !request.random_noise
+                     && slippage_ == 0 };
+
+    // Context (data, execution settings) and parameters of the cache key
+    BacktestCache::Context context {};
+    parameters_t key_params {};
+    if( use_cache ){
+        std::string settings { strategy_name_ + "|" + symbol_.name()
+                    + "|" + timeframe_
+                    + "|" + std::to_string(max_bars_back_)
+                    + "|" + std::to_string(initial_balance_)
+                    + "|" + ps_type_
+                    + "|" + std::to_string(num_contracts_)
+                    + "|" + std::to_string(risk_fraction_)
+                    + "|" + std::to_string(include_commissions_)
+                    + "|" + std::to_string(slippage_) };
+
+        key_params = utils_params::canonical_parameters(
+                                        request.strategy_params, param_deps_ );
+        context = cache_->context( *request.datafeed, settings );
+        if( cache_->lookup( context, key_params, with_ticks, record ) ){
+            return;
+        }
+    }
+
+    // Run backtest (transaction history kept only if ticks are needed)
+    bool keep_ticks { with_ticks || ( use_cache && cache_->store_ticks() ) };
+    BacktestRequest run_request { request };
+    run_request.keep_transactions = keep_ticks;
+    // cached records are complete, whatever the caller needs
+    if( use_cache ){
+        run_request.metrics |= metric_record;
+    }
+    BacktestResult result { run( run_request ) };
+    const Account &account { result.account };
+
+    // Performance metrics, accumulated during the backtest
+    fill_record( record, account.metrics().metrics(), result );
+    record.ticks.clear();
+    record.has_ticks = keep_ticks;
+    if( record.has_ticks ){
+        for( const auto& tr: account.transactions() ){
+            record.ticks.push_back( tr.ticks() );
+        }
+    }
+
+    // pruned records depend on the pruning rules: not stored
+    if( use_cache && !result.pruned ){
+        cache_->store( context, key_params, record );
+    }
+}
+
+
+//-------------------------------------------------------------------------- //
+/*! Store summary 'metrics' and counters/dates of 'result' into 'record'
+    (list of ticks left unchanged)
+*/
+void BTfast::fill_record( BacktestRecord &record, const TradeMetrics &metrics,
+                          const BacktestResult &result )
+{
+    record.ntrades = metrics.ntrades;
+    record.avgticks = metrics.avg_ticks;
+    record.winperc = metrics.win_perc;
+    record.profitfactor = metrics.profit_factor;
+    record.npmdd = metrics.netpl_maxdd;
+    record.expectancy = metrics.expectancy;
+    record.zscore = metrics.zscore;
+    record.netpl = metrics.net_pl;
+    record.avgtrade = metrics.avg_trade;
+    record.stdticks = metrics.std_ticks;
+    record.nyears = metrics.nyears;
+    record.profitable_yrs = metrics.profitable_yrs;
+    record.bar_counter = result.bar_counter;
+    record.day_counter = result.day_counter;
+    record.first_date_parsed = result.first_date_parsed;
+    record.last_date_parsed = result.last_date_parsed;
+    record.pruned = result.pruned;
+}
+
+
+//-------------------------------------------------------------------------- //
+/*! Run single backtest over in-sample data followed by out-of-sample data
+    (request.datafeed, e.g. HistoricalBarsMemory over both), and compute
+    summary metrics of trades exiting up to 'split' (last in-sample bar)
+    into 'record_is', and of those exiting after it into 'record_oos'.
+    Out-of-sample trades start from the state reached in-sample (no
+    warm-up at the boundary). Not cached.
+    Reentrant (as run() ).
+
+    oos_start: date of first out-of-sample session
+               (first date parsed of 'record_oos')
+    is_bars, is_days: number of bars and days of in-sample data
+                      (out-of-sample counters are the remaining ones)
+    with_ticks: switch to fill the list of ticks of each trade
+*/
+void BTfast::run_split_backtest( BacktestRecord &record_is,
+                                 BacktestRecord &record_oos,
+                                 const BacktestRequest &request,
+                                 const DateTime &split,
+                                 const Date &oos_start, int is_bars,
+                                 int is_days, bool with_ticks ) const
+{
+    BacktestRequest split_request { request };
+    split_request.keep_transactions = true;
+    BacktestResult result { run( split_request ) };
+
+    MetricsAccumulator metrics_is { split_request.metrics };
+    MetricsAccumulator metrics_oos { split_request.metrics };
+    record_is.ticks.clear();
+    record_oos.ticks.clear();
+    for( const auto& tr: result.account.transactions() ){
+        bool in_sample { tr.exit_time() <= split };
+        ( in_sample ? metrics_is : metrics_oos ).add_trade( tr );
+        if( with_ticks ){
+            ( in_sample ? record_is : record_oos ).ticks.push_back(
+                                                                tr.ticks() );
+        }
+    }
+    fill_record( record_is, metrics_is.metrics(), result );
+    fill_record( record_oos, metrics_oos.metrics(), result );
+    record_is.has_ticks = with_ticks;
+    record_oos.has_ticks = with_ticks;
+
+    // Split counters/dates at 'split'
+    record_is.bar_counter = std::min( is_bars, result.bar_counter );
+    record_is.day_counter = std::min( is_days, result.day_counter );
+    record_is.last_date_parsed = split.date();
+    record_oos.first_date_parsed = oos_start;
+    record_oos.bar_counter = result.bar_counter - record_is.bar_counter;
+    record_oos.day_counter = result.day_counter - record_is.day_counter;
+}
+
+
+//-------------------------------------------------------------------------- //
+/*! Run backtests over all 'search_space' combinations in parallel,
+    each on its own copy of 'datafeed', and store their summary metrics
+    into 'records' (same order as 'search_space').
+    Reentrant (as run() ).
+
+    random_noise: switch to add random noise to price data in all runs
+    Run index of each backtest is its position in 'search_space'.
+
+    With random noise, data are parsed only once into memory, and each run
+    streams them with its own noise, generated in bulk
+    (HistoricalBarsMemory).
+*/
+void BTfast::run_parallel_backtests(
+                                const std::vector<parameters_t> &search_space,
+                                std::vector<BacktestRecord> &records,
+                                const std::unique_ptr<DataFeed> &datafeed,
+                                bool random_noise ) const
+{
+    records.clear();
+    records.resize( search_space.size() );
+
+    // Bars shared by all noisy runs
+    std::shared_ptr<const BarSeries> series {nullptr};
+    if( random_noise && !search_space.empty() ){
+        series = load_bar_series( *datafeed );
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for( size_t i = 0; i < search_space.size(); i++ ){
+        // Make a copy of DataFeed object and wrap it into a new unique_ptr
+        // (in-memory datafeed with noise of run i, if random_noise)
+        std::unique_ptr<DataFeed> datafeed_copy {nullptr};
+        if( random_noise ){
+            datafeed_copy = std::make_unique<HistoricalBarsMemory>(
+                                                *datafeed, series, true, i );
+        }
+        else{
+            datafeed_copy = datafeed.get()->clone();
+        }
+
+        run_cached_backtest( records[i],
+                             BacktestRequest { datafeed_copy.get(),
+                                               search_space[i],
+                                               random_noise, false, i } );
+    }
+}
+
+
+//-------------------------------------------------------------------------- //
+/*! Store counters/dates of a backtest into member variables
+    (read by run modes for printing)
+*/
+void BTfast::set_parsed_info( const BacktestRecord &record )
+{
+    bar_counter_ = record.bar_counter;
+    day_counter_ = record.day_counter;
+    first_date_parsed_ = record.first_date_parsed;
+    last_date_parsed_ = record.last_date_parsed;
 }
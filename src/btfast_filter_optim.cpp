@@ -0,0 +1,277 @@
+#include "btfast.h"         // parameters_t, strategy_t
+
+#include "backtest_cache.h" // BacktestRecord
+#include "metrics_accumulator.h" // MetricsAccumulator, TradeMetrics
+#include "strategy_index.h" // ParamValuesHash
+#include "utils_fileio.h"   // write_strategies_to_file
+#include "utils_optim.h"    // append_to_optim_results, sort_by_metric
+#include "utils_time.h"     // current_datetime_str
+
+#include <algorithm>        // std::find, std::lower_bound, std::sort, std::unique
+#include <iostream>         // std::cout
+#include <mutex>            // std::mutex
+#include <unordered_map>    // std::unordered_map
+
+
+//-------------------------------------------------------------------------- //
+/*! Run Parallelized Exhaustive Optimization over 'search_space'
+    combinations, which differ (also) by the values of the entry filters
+    'filter_names' (value 0 = filter off).
+    Results stored into 'optim_results' and written to 'optim_file'
+    (same output as run_parallel_optimization).
+
+    With filter masks enabled (set_filter_mask), the strategy without
+    the filters (all of them set to 0) is backtested only once for each
+    combination of the other parameters, annotating each entry with the
+    filter values allowing it (Strategy::mask_filter_passes). The metrics
+    of each filter setting are then computed on the trades allowed by it,
+    without running its backtest.
+    Full backtests (run_parallel_optimization) are run instead if:
+        - filter masks are disabled,
+        - any filter is not declared in Strategy::mask_filters()
+          (filters changing the path of trades, e.g. time windows),
+        - position size depends on account equity ("fixed_fractional"),
+        - random slippage or pruning rules are active.
+    For a single base combination, full backtests of its combinations are
+    run if its masks are not exact: a position was carried into a new
+    session, an entry was filled on the first bar of a session (signal
+    of the previous one), or a trade has no entry mask (entry fill not
+    annotated).
+
+    search_space: combination of parameters to run optimization over (input)
+    filter_names: names of entry filter parameters varied in 'search_space'
+    optim_results: vector where storing optimization results (metrics + params)
+    paramfile: XML file with strategy parameter ranges/value.
+    optim_file: file where optimization results are written
+    fitness_metric: used to sort optimization results in descending order
+    datafeed: smart pointer to DataFeed object
+*/
+
+void BTfast::run_filter_optimization(
+                                const std::vector<parameters_t> &search_space,
+                                const std::vector<std::string> &filter_names,
+                                        std::vector<strategy_t> &optim_results,
+                                        const std::string &optim_file,
+                                        const std::string &paramfile,
+                                        const std::string &fitness_metric,
+                                        std::unique_ptr<DataFeed> &datafeed,
+                                        bool sort_results, bool verbose )
+{
+    //--- Check whether filters can be evaluated as masks
+    std::string full_backtests_reason {""};
+    if( !filter_mask_ ){
+        full_backtests_reason = "disabled";
+    }
+    else if( ps_type_ == "fixed_fractional" ){
+        full_backtests_reason = "position size depends on equity";
+    }
+    else if( slippage_ > 0 || pruning_ != nullptr ){
+        full_backtests_reason = "random slippage or pruning";
+    }
+    else{
+        std::unique_ptr<Strategy> strategy {nullptr};
+        select_strategy( strategy, strategy_name_, symbol_, timeframe_,
+                         max_bars_back_ );
+        std::vector<std::string> maskable { strategy->mask_filters() };
+        for( const std::string &name: filter_names ){
+            if( std::find( maskable.begin(), maskable.end(), name )
+                                                        == maskable.end() ){
+                full_backtests_reason = name + " changes trade paths";
+                break;
+            }
+        }
+    }
+    if( !full_backtests_reason.empty() || search_space.empty() ){
+        if( verbose && filter_mask_ ){
+            std::cout << "Filter masks not used (" << full_backtests_reason
+                      << "): running full backtests\n";
+        }
+        run_parallel_optimization( search_space, optim_results, optim_file,
+                                   paramfile, fitness_metric, datafeed,
+                                   sort_results, verbose );
+        return;
+    }
+    //---
+
+    //--- Filters present in search space, and their values
+    // (layout of parameters taken from first combination)
+    const parameters_t &first { search_space.front() };
+    std::vector<size_t> filter_pos {};      // position in combinations
+    param_ranges_t mask_ranges {};          // values of each filter
+    std::vector<size_t> offset {};          // position in entry masks
+    size_t num_flags {0};
+    for( const std::string &name: filter_names ){
+        for( size_t j = 0; j < first.size(); j++ ){
+            if( first[j].first == name ){
+                std::vector<int> values {};
+                for( const parameters_t &params: search_space ){
+                    values.push_back( params[j].second );
+                }
+                std::sort( values.begin(), values.end() );
+                values.erase( std::unique( values.begin(), values.end() ),
+                              values.end() );
+                filter_pos.push_back( j );
+                offset.push_back( num_flags );
+                num_flags += values.size();
+                mask_ranges.push_back( std::make_pair( name, values ) );
+                break;
+            }
+        }
+    }
+
+    //--- Base combinations (filters off), and combinations of each base
+    std::vector<parameters_t> bases {};
+    std::vector<std::vector<size_t>> members {};
+    std::unordered_map<std::vector<int>, size_t, ParamValuesHash> base_index {};
+    for( size_t i = 0; i < search_space.size(); i++ ){
+        parameters_t base { search_space[i] };
+        for( size_t pos: filter_pos ){
+            base[pos].second = 0;
+        }
+        std::vector<int> values {};
+        for( const auto &p: base ){
+            values.push_back( p.second );
+        }
+        auto it = base_index.emplace( values, bases.size() ).first;
+        if( it->second == bases.size() ){
+            bases.push_back( base );
+            members.push_back( std::vector<size_t> {} );
+        }
+        members[it->second].push_back( i );
+    }
+    if( verbose ){
+        std::cout << "Filter masks: running " << bases.size()
+                  << " backtests for " << search_space.size()
+                  << " combinations\n";
+    }
+
+    // Results of each combination, in the same order as 'search_space'
+    std::vector<BacktestRecord> records ( search_space.size() );
+    std::mutex mtx;
+    int iter {0};
+    int inexact {0};    // base combinations with masks not exact
+
+    //--- Start loop over base combinations
+    #pragma omp parallel for schedule(dynamic) reduction(+:inexact)
+    for( size_t g = 0; g < bases.size(); g++ ){
+
+        if( verbose ){
+            mtx.lock();
+            iter++;        // Increment iteration
+            std::cout << utils_time::current_datetime_str() + " | "
+                      << "(Parallel) Running optimization " << iter << " / "
+                      << bases.size() << " (filter masks)\n";
+            mtx.unlock();
+        }
+
+        // Backtest of base combination, with entries annotated by filters
+        std::unique_ptr<DataFeed> datafeed_copy = datafeed.get()->clone();
+        BacktestResult result { run( BacktestRequest { datafeed_copy.get(),
+                                                       bases[g],
+                                                       false, false, g,
+                                                       true, metric_optim,
+                                                       nullptr,
+                                                       &mask_ranges } ) };
+        const std::vector<Transaction> &trades {
+                                            result.account.transactions() };
+
+        // Entry mask of each trade (matched by entry time and side)
+        std::vector<const EntryFilterMask*> trade_mask ( trades.size(),
+                                                         nullptr );
+        std::vector<bool> used ( result.entry_masks.size(), false );
+        size_t first_unused {0};
+        for( size_t t = 0; t < trades.size(); t++ ){
+            for( size_t m = first_unused; m < used.size(); m++ ){
+                const EntryFilterMask &mask { result.entry_masks[m] };
+                if( !used[m] && mask.entry_time == trades[t].entry_time()
+                    && mask.side == trades[t].side() ){
+                    trade_mask[t] = &mask;
+                    used[m] = true;
+                    break;
+                }
+            }
+            while( first_unused < used.size() && used[first_unused] ){
+                first_unused++;
+            }
+        }
+
+        // Masks not exact: full backtests of the combinations of this base
+        if( result.masks_inexact
+            || std::find( trade_mask.begin(), trade_mask.end(), nullptr )
+                                                        != trade_mask.end() ){
+            inexact++;
+            for( size_t i: members[g] ){
+                std::unique_ptr<DataFeed> member_datafeed {
+                                                datafeed.get()->clone() };
+                run_cached_backtest( records[i],
+                                     BacktestRequest { member_datafeed.get(),
+                                                       search_space[i],
+                                                       false, false, i,
+                                                       false, metric_optim } );
+            }
+            continue;
+        }
+
+        // Metrics of each filter setting, on the trades it allows
+        for( size_t i: members[g] ){
+            // Position in entry masks of filter values of combination i
+            std::vector<size_t> flags {};
+            for( size_t k = 0; k < filter_pos.size(); k++ ){
+                const std::vector<int> &values { mask_ranges[k].second };
+                int value { search_space[i][filter_pos[k]].second };
+                flags.push_back( offset[k]
+                        + ( std::lower_bound( values.begin(), values.end(),
+                                              value ) - values.begin() ) );
+            }
+            MetricsAccumulator accumulator { metric_optim };
+            for( size_t t = 0; t < trades.size(); t++ ){
+                bool allowed {true};
+                for( size_t f: flags ){
+                    allowed = allowed && trade_mask[t]->passes[f];
+                }
+                if( allowed ){
+                    accumulator.add_trade( trades[t] );
+                }
+            }
+            fill_record( records[i], accumulator.metrics(), result );
+        }
+    }
+    //--- End loop over base combinations
+    if( verbose ){
+        if( inexact > 0 ){
+            std::cout << "Filter masks not exact for " << inexact << " / "
+                      << bases.size() << " backtests (trade across sessions, "
+                      << "or entry not annotated): "
+                      << "full backtests run instead\n";
+        }
+        std::cout << "Optimization Done.\n";
+    }
+
+    // Append performance metrics and parameter combinations
+    // to optimization results (in order of search space)
+    for( size_t i = 0; i < search_space.size(); i++ ){
+        utils_optim::append_to_optim_results( optim_results, records[i],
+                                              search_space[i] );
+    }
+    // Store counters/dates of parsed data (for printing)
+    set_parsed_info( records.front() );
+
+    // Sort in descending order of fitness_metric
+    if( sort_results ){
+        utils_optim::sort_by_metric( optim_results, fitness_metric );
+    }
+
+    if( verbose ){
+        // Write optimization results to file 'optim_file' and on stdout
+        int control = utils_fileio::write_strategies_to_file(
+                                                optim_file, paramfile,
+                                                optim_results, strategy_name_,
+                                                symbol_.name(), timeframe_,
+                                                first_date_parsed_,
+                                                last_date_parsed_, verbose );
+        if( control == 1 ){
+            std::cout << "\nOptimization results written on file: "
+                      << optim_file <<"\n";
+        }
+    }
+}
@@ -3,9 +3,114 @@
 #include "genetic.h"    // gene_t, chromosome_t type aliases
 #include "utils_fileio.h"      // write_strategies_to_file
 #include "utils_optim.h"      //  sort_by_metric
+#include "utils_random.h"     // RandomStream, global_seed
 #include "utils_time.h"     // current_datetime_str
 
 #include <iostream>     // std::cout
+#include <unordered_set>    // std::unordered_set
+
+
+namespace {
+
+//-------------------------------------------------------------------------- //
+/*! Steady-state evolution of 'population' (already evaluated), with
+    'evaluations' new offspring evaluated asynchronously by all threads.
+    Each offspring is bred from the current population, evaluated, and
+    replaces the least fit individual if fitter.
+    Offspring already in 'memo' (or being evaluated by another thread)
+    are discarded without evaluation (at most 'max_attempts' breedings).
+    New evaluations are appended to 'optim_results'.
+*/
+
+void steady_state_evolution( const BTfast &btf, Population &population,
+                             fitness_memo_t &memo,
+                             const std::vector<parameters_t> &search_space,
+                             std::vector<strategy_t> &optim_results,
+                             std::unique_ptr<DataFeed> &datafeed,
+                             double mutation_rate, int evaluations )
+{
+    // Offspring bred (evaluated or discarded as duplicates)
+    long attempts {0};
+    long max_attempts { 20L * evaluations };
+    // Offspring evaluated, or being evaluated
+    int started {0};
+    int completed {0};
+    // Keys of offspring being evaluated
+    std::unordered_set<std::vector<int>, ParamValuesHash> pending {};
+
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Start steady-state evolution: " << evaluations
+              << " offspring\n";
+
+    #pragma omp parallel
+    {
+        // Each thread owns a copy of DataFeed
+        std::unique_ptr<DataFeed> datafeed_copy = datafeed.get()->clone();
+
+        while( true ){
+
+            Individual offspring { chromosome_t {} };
+            std::vector<int> key {};
+            bool evaluate {false};
+            bool done {false};
+
+            //-- Breed new offspring from current population
+            #pragma omp critical(steady_state)
+            {
+                if( started >= evaluations || attempts >= max_attempts ){
+                    done = true;
+                }
+                else{
+                    attempts++;
+                    utils_random::RandomStream rng {
+                                            utils_random::global_seed(),
+                                            utils_random::genetic_domain,
+                                            (uint64_t) attempts, 0 };
+                    offspring = population.breed( search_space,
+                                                  mutation_rate, rng );
+                    key = chromosome_key( offspring.chromosome(),
+                                          btf.param_dependencies() );
+                    if( memo.count(key) == 0 && pending.count(key) == 0 ){
+                        pending.insert(key);
+                        started++;
+                        evaluate = true;
+                    }
+                }
+            }
+            if( done ){
+                break;
+            }
+            if( !evaluate ){
+                continue;
+            }
+
+            //-- Evaluate offspring (while other threads breed/evaluate)
+            BacktestRecord record {};
+            offspring.compute_individual_fitness( btf, datafeed_copy,
+                                                  population.fitness_metric(),
+                                                  record );
+
+            //-- Insert offspring into population
+            #pragma omp critical(steady_state)
+            {
+                pending.erase(key);
+                memo[key] = offspring.fitness();
+                utils_optim::append_to_optim_results( optim_results, record,
+                                                      offspring.chromosome() );
+                population.replace_worst( offspring );
+                completed++;
+            }
+        }
+    }
+
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "End   steady-state evolution: " << completed
+              << " offspring evaluated (" << attempts << " bred)\t"
+              << "Best Fitness = " << population.population()[0].fitness()
+              << "\n\n";
+}
+
+} // namespace
 
 
 //-------------------------------------------------------------------------- //
@@ -23,6 +128,20 @@
     population_size: size of population
     generations: number of generations
 
+    Each distinct chromosome (up to equivalent parameters, see
+    ParamDependency) is evaluated only once: fitness of chromosomes
+    reappearing in later generations is taken from a memo.
+
+    Selection of parents (ga_selection_): "roulette" (default) or "tournament".
+
+    Steady-state mode (ga_steady_state_): after the initial population,
+    each thread breeds an offspring from the current population, evaluates
+    it, and replaces the least fit individual if fitter, without waiting
+    for other threads (no barrier between generations). The budget of
+    evaluations is the same as generational mode:
+    population_size * (generations-1). The order of evaluations depends
+    on thread timing, so results are not reproducible across runs with
+    more than one thread, even with RANDOM_SEED.
 */
 
 void BTfast::run_genetic_optimization( std::vector<parameters_t> &search_space,
@@ -33,11 +152,8 @@ void BTfast::run_genetic_optimization( std::vector<parameters_t> &search_space,
                                        std::unique_ptr<DataFeed> &datafeed,
                                        int population_size, int generations )
 {
-    // disable printing number of bars parsed
-    print_progress_ = false;
-
     // Set up probabilities for genetic operations
-    double crossover_rate { 0.9 };
+    // (crossover_rate = 0.9 for single crossover, see next_generation)
     double mutation_rate { 0.1 };
     // Number of consecutive generations with same total fitness causing
     // early exit of GA (0 to disable)
@@ -67,9 +183,17 @@ void BTfast::run_genetic_optimization( std::vector<parameters_t> &search_space,
     std::cout << utils_time::current_datetime_str() + " | "
               << "Start Generation 1 / " << generations << "\n";
 
-    Population population {population_size, fitness_metric};
-    population.initialize_population(search_space);
-    population.compute_population_fitness(*this, datafeed, optim_results);
+    // Random stream of genetic operators (reproducible with RANDOM_SEED)
+    utils_random::RandomStream rng { utils_random::global_seed(),
+                                     utils_random::genetic_domain, 0, 0 };
+
+    // Fitness of chromosomes already evaluated
+    fitness_memo_t memo {};
+
+    Population population {population_size, fitness_metric, ga_selection_};
+    population.initialize_population(search_space, rng);
+    population.compute_population_fitness(*this, datafeed, optim_results,
+                                          memo);
     //population.print_population();
 
     // fitness of best individual in previous and current generations
@@ -82,55 +206,28 @@ void BTfast::run_genetic_optimization( std::vector<parameters_t> &search_space,
               << "Best Fitness = " << best_fitness_curr << "\n\n";
     //--
 
+    if( ga_steady_state_ ){
+        steady_state_evolution( *this, population, memo, search_space,
+                                optim_results, datafeed, mutation_rate,
+                                population_size * (generations - 1) );
+    }
+
     //--- Loop over successive generations
-    for( int generation = 2; generation <= generations; generation++ ){
+    for( int generation = 2; generation <= generations && !ga_steady_state_;
+         generation++ ){
 
         std::cout << utils_time::current_datetime_str() + " | "
                   << "Start Generation " << generation
                   << " / " << generations << "\n";
 
-        Population new_population {population_size, fitness_metric};
+        // Create new population for next generation
+        // (elitism, selection, crossover, mutation)
+        Population new_population { population.next_generation(
+                                        search_space, mutation_rate,
+                                        elite_num, rng ) };
 
-        //--- Create new population for next generation
-        // Elitism
-        // (the 'elite_num' fittest individuals pass unchanged to new generation)
-        for( int j = 0; j < elite_num; j++){
-            new_population.insert_individual( population.population()[j] );
-        }
-
-        while( new_population.population().size() < population_size ){
-
-            // Selection
-            Individual offspring1 { population.select() };
-            Individual offspring2 { population.select() };
-            int selection_trials {0};
-            // enforce that the parents are different (max population_size trials)
-            while( offspring2.chromosome() == offspring1.chromosome()
-                   && selection_trials < population_size ){
-                offspring2 = population.select();
-                selection_trials++;
-            }
-
-            // Crossover
-            /*
-            //- single crossover
-            offspring1.single_crossover( offspring2, crossover_rate );
-            new_population.insert_individual( offspring1 );
-            new_population.insert_individual( offspring2 );
-            //-
-            */
-            //- uniform crossover
-            crossover_rate = 0.0; //dummy
-            offspring1.uniform_crossover( offspring2 );
-            new_population.insert_individual( offspring1 );
-            //-
-        }
-        //---
-
-        // Mutation
-        new_population.mutate( search_space, mutation_rate, elite_num );
-
-        new_population.compute_population_fitness(*this, datafeed, optim_results);
+        new_population.compute_population_fitness(*this, datafeed,
+                                                  optim_results, memo);
         //new_population.print_population();
 
         best_fitness_prev = population.population()[0].fitness() ;
@@ -161,9 +258,18 @@ void BTfast::run_genetic_optimization( std::vector<parameters_t> &search_space,
     }
     //--- End loop over generations
 
+    std::cout << "Distinct chromosomes evaluated: " << memo.size() << "\n";
+
     // Sort in descending order of fitness_metric
     utils_optim::sort_by_metric( optim_results, fitness_metric );
 
+    // Store counters/dates of parsed data (for printing),
+    // from backtest of best individual (already in cache, if enabled)
+    BacktestRecord best_record {};
+    run_cached_backtest( best_record, BacktestRequest { datafeed.get(),
+                                    population.population()[0].chromosome() } );
+    set_parsed_info( best_record );
+
     // Write optimization results to file 'optim_file'
     int control = utils_fileio::write_strategies_to_file(
                                             optim_file, paramfile,
@@ -176,3 +282,4 @@ void BTfast::run_genetic_optimization( std::vector<parameters_t> &search_space,
                   << optim_file <<"\n";
     }
 }
+
@@ -0,0 +1,114 @@
+#include "btfast.h"
+
+#include "utils_params.h"   // extract_parameters_from_all_strategies
+#include "utils_time.h"     // current_datetime_str, add_days
+
+#include <algorithm>        // std::max
+#include <cmath>            // std::pow, std::ceil
+#include <iostream>         // std::cout
+
+
+//-------------------------------------------------------------------------- //
+/*! Run Successive Halving Optimization over 'search_space' combinations.
+    Results stored into 'optim_results' and written to 'optim_file'.
+
+    All combinations are first evaluated on a short span of history,
+    starting at the first date of data. The best 1/eta of them (by
+    fitness_metric) are re-evaluated on a span eta times longer, and so on,
+    up to the full date range in the last of 'rungs' steps:
+        rung k (0, ..., rungs-1): span = full range / eta^(rungs-1-k)
+                                  candidates = N / eta^k
+    Each rung costs about N / eta^(rungs-1) full backtests, so total work
+    is about rungs / eta^(rungs-1) that of exhaustive optimization.
+    Only the survivors of the last rung (on full range) are written to
+    'optim_file'.
+
+    search_space: combination of parameters to run optimization over (input)
+    optim_results: vector where storing optimization results (metrics + params)
+    paramfile: XML file with strategy parameter ranges/value.
+    optim_file: file where optimization results are written
+    fitness_metric: used to sort optimization results in descending order
+    datafeed: smart pointer to DataFeed object
+    eta: inverse of fraction of candidates kept at each rung (>= 2)
+    rungs: number of rungs (>= 1; 1 = exhaustive optimization)
+*/
+
+void BTfast::run_halving_optimization(
+                                const std::vector<parameters_t> &search_space,
+                                std::vector<strategy_t> &optim_results,
+                                const std::string &optim_file,
+                                const std::string &paramfile,
+                                const std::string &fitness_metric,
+                                std::unique_ptr<DataFeed> &datafeed,
+                                int eta, int rungs )
+{
+    if( eta < 2 ){
+        std::cout << ">>> ERROR: HALVING_ETA must be at least 2 "
+                  << "(run_halving_optimization).\n";
+        exit(1);
+    }
+    if( rungs < 1 ){
+        std::cout << ">>> ERROR: HALVING_RUNGS must be at least 1 "
+                  << "(run_halving_optimization).\n";
+        exit(1);
+    }
+
+    // Full date range of data
+    Date first_date { datafeed->first_date() };
+    Date last_date { datafeed->last_date() };
+    int total_days { last_date.DaysDiff( first_date ) };
+
+    std::vector<parameters_t> candidates { search_space };
+    // Work done, in units of full backtests
+    double work {0.0};
+
+    //--- Loop over rungs
+    for( int rung = 0; rung < rungs && !candidates.empty(); rung++ ){
+
+        // Fraction of full range used in this rung
+        double fraction { std::pow( (double) eta, rung - (rungs - 1) ) };
+        work += fraction * candidates.size();
+
+        if( rung == rungs - 1 ){
+            // Last rung: full range, results written to file
+            std::cout << utils_time::current_datetime_str() + " | "
+                      << "Rung " << rung + 1 << " / " << rungs << ": "
+                      << candidates.size() << " candidates on full range\n";
+            run_parallel_optimization( candidates, optim_results, optim_file,
+                                       paramfile, fitness_metric, datafeed,
+                                       true, true );
+            break;
+        }
+
+        // Datafeed restricted to first part of data
+        int span_days { std::max( 1, (int) ( total_days * fraction ) ) };
+        Date rung_end { utils_time::add_days( first_date, span_days - 1 ) };
+        std::unique_ptr<DataFeed> rung_datafeed { datafeed->clone() };
+        rung_datafeed->set_end_date( rung_end );
+
+        std::cout << utils_time::current_datetime_str() + " | "
+                  << "Rung " << rung + 1 << " / " << rungs << ": "
+                  << candidates.size() << " candidates on "
+                  << first_date.tostring() << " --> "
+                  << rung_end.tostring() << "\n";
+
+        // Evaluate candidates (sorted by fitness_metric)
+        std::vector<strategy_t> rung_results {};
+        run_parallel_optimization( candidates, rung_results, "", "",
+                                   fitness_metric, rung_datafeed,
+                                   true, false );
+
+        // Keep best 1/eta of candidates
+        size_t keep { (size_t) std::ceil( candidates.size() / (double) eta ) };
+        if( rung_results.size() > keep ){
+            rung_results.resize( keep );
+        }
+        utils_params::extract_parameters_from_all_strategies( rung_results,
+                                                              candidates );
+    }
+    //--- End loop over rungs
+
+    std::cout << "Successive halving work: " << work
+              << " full backtests (exhaustive: " << search_space.size()
+              << ")\n";
+}
@@ -0,0 +1,291 @@
+#include "btfast.h"
+
+#include "genetic.h"    // Population, Individual, Mailbox, fitness_memo_t
+#include "utils_fileio.h"      // write_strategies_to_file
+#include "utils_optim.h"      //  sort_by_metric
+#include "utils_params.h"     // extract_parameters_from_single_strategy
+#include "utils_random.h"     // RandomStream, global_seed, shuffle
+#include "utils_time.h"     // current_datetime_str
+
+#include <algorithm>        // std::max, std::min
+#include <iostream>         // std::cout
+#include <omp.h>            // openMP
+#include <unordered_set>    // std::unordered_set
+
+
+//-------------------------------------------------------------------------- //
+/*! Run Island-model Genetic Optimization over 'search_space' combinations.
+    Results stored into 'optim_results' and written to 'optim_file'.
+
+    The population of 'population_size' individuals is split into 'islands'
+    sub-populations, which evolve independently (as in
+    run_genetic_optimization) in parallel, each on its own group of
+    threads (fitness of its individuals evaluated in parallel by the group).
+    Every 'migration_interval' generations, each island posts copies of its
+    'migrants' fittest individuals to the next island (ring topology),
+    through a lock-free mailbox, and inserts the migrants received from the
+    previous island in place of its least fit individuals (if fitter).
+    Islands never wait for each other: migrants are dropped if the mailbox
+    of the next island is still full, so results are not reproducible
+    with more than one thread, even with RANDOM_SEED.
+    With more islands than threads, islands are interleaved instead: all of
+    them evolve 'migration_interval' generations (one epoch) in parallel,
+    then migrate together, so that migration takes place among islands
+    sharing a thread.
+
+    search_space: combination of parameters to run optimization over (input)
+            (not const because shuffled)
+    optim_results: vector where storing optimization resus (metrics + params)
+    paramfile: XML file with strategy parameter ranges/value.
+    optim_file: file where optimization results are written
+    fitness_metric: used to sort optimization results in descending order
+    datafeed: smart pointer to DataFeed object
+    population_size: total size of population (all islands)
+    generations: number of generations
+    islands: number of islands (sub-populations)
+    migration_interval: number of generations between migrations
+    migrants: number of individuals sent by each island at each migration
+*/
+
+void BTfast::run_island_optimization( std::vector<parameters_t> &search_space,
+                                      std::vector<strategy_t> &optim_results,
+                                      const std::string &optim_file,
+                                      const std::string &paramfile,
+                                      const std::string &fitness_metric,
+                                      std::unique_ptr<DataFeed> &datafeed,
+                                      int population_size, int generations,
+                                      int islands, int migration_interval,
+                                      int migrants )
+{
+    // Set up probabilities for genetic operations
+    double mutation_rate { 0.1 };
+    // number of elite individuals passing unchanged (in each island)
+    int elite_num {2};
+
+    if( islands < 1 || migration_interval < 1 ){
+        std::cout << ">>> ERROR: ISLANDS and MIGRATION_INTERVAL must be "
+                  << "at least 1 (run_island_optimization).\n";
+        exit(1);
+    }
+    // Size of each island
+    int island_size { population_size / islands };
+    if( island_size <= elite_num || migrants >= island_size ){
+        std::cout << ">>> ERROR: population size per island ("
+                  << island_size << ") must be larger than " << elite_num
+                  << " elite individuals and than MIGRANTS "
+                  << "(run_island_optimization).\n";
+        exit(1);
+    }
+    if( (size_t) island_size*islands*generations > search_space.size() ){
+        std::cout << ">>> ERROR: number of genetic runs "
+                  << island_size*islands*generations
+                  << " must be smaller than exhaustive runs "
+                  << search_space.size()
+                  << ".\nChange RUN_MODE to exhaustive optimization.\n";
+        exit(1);
+    }
+
+    // Each island starts from a different part of the shuffled search space
+    utils_random::RandomStream rng { utils_random::global_seed(),
+                                     utils_random::genetic_domain, 0, 1 };
+    utils_random::shuffle( search_space, rng );
+
+    // Mailbox of each island (migrants from previous island)
+    std::vector<Mailbox> mailboxes ( islands );
+    // Results, fitness memo and best individual of each island
+    std::vector<std::vector<strategy_t>> island_results ( islands );
+    std::vector<fitness_memo_t> memos ( islands );
+    std::vector<Individual> best_individuals ( islands );
+    // Number of migrants posted/dropped
+    int posted {0};
+    int dropped {0};
+
+    // Threads: one group for each island
+    int num_groups { std::min( islands, omp_get_max_threads() ) };
+    int group_size { std::max( 1, omp_get_max_threads() / num_groups ) };
+    int max_levels { omp_get_max_active_levels() };
+    omp_set_max_active_levels( 2 );
+
+    // More islands than threads: islands sharing a thread would run back to
+    // back, each one to the end before the next starts (no migration
+    // between them). Islands are interleaved instead, all evolving one
+    // epoch of 'migration_interval' generations before migrating together.
+    bool interleaved { islands > num_groups };
+    int epoch_length { interleaved ? migration_interval : generations };
+
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Start " << islands << " islands of " << island_size
+              << " individuals (" << num_groups << " x " << group_size
+              << " threads" << ( interleaved ? ", interleaved" : "" )
+              << ")\n";
+
+    // Population and random stream of genetic operators of each island
+    std::vector<Population> populations {};
+    std::vector<utils_random::RandomStream> island_rngs {};
+    for( int island = 0; island < islands; island++ ){
+        populations.emplace_back( island_size, fitness_metric,
+                                  ga_selection_ );
+        island_rngs.emplace_back( utils_random::global_seed(),
+                                  utils_random::genetic_domain,
+                                  (uint64_t) island + 1, 1 );
+    }
+
+    // Post copies of fittest individuals of 'island' to next island
+    auto post_migrants = [&]( int island ){
+        const Population &population { populations[island] };
+        std::vector<Individual> elite {
+                                population.population().begin(),
+                                population.population().begin() + migrants };
+        return( mailboxes[(island + 1) % islands].post( elite ) );
+    };
+    // Insert individuals received from previous island
+    // (not already evaluated in this island)
+    auto receive_migrants = [&]( int island ){
+        std::vector<Individual> received {};
+        if( mailboxes[island].collect( received ) ){
+            for( const Individual &indiv: received ){
+                std::vector<int> key { chromosome_key( indiv.chromosome(),
+                                                       param_deps_ ) };
+                if( memos[island].emplace( key, indiv.fitness() ).second ){
+                    populations[island].replace_worst( indiv );
+                }
+            }
+        }
+    };
+
+    //--- Loop over epochs (a single one, if not interleaved)
+    for( int first = 1; first <= generations; first += epoch_length ){
+        int last { std::min( first + epoch_length - 1, generations ) };
+
+        //-- Loop over islands (in parallel)
+        #pragma omp parallel for num_threads(num_groups) schedule(static,1) \
+                                 reduction(+:posted,dropped)
+        for( int island = 0; island < islands; island++ ){
+
+            // Threads evaluating individuals of this island
+            omp_set_num_threads( group_size );
+
+            Population &population { populations[island] };
+
+            //- Loop over successive generations of the epoch
+            for( int generation = first; generation <= last; generation++ ){
+
+                if( generation == 1 ){
+                    // Initial population (1st generation)
+                    std::vector<parameters_t> island_space {
+                        search_space.begin() + island * island_size,
+                        search_space.begin() + (island + 1) * island_size };
+                    population.initialize_population( island_space,
+                                                      island_rngs[island] );
+                    population.compute_population_fitness( *this, datafeed,
+                                                    island_results[island],
+                                                    memos[island] );
+                    continue;
+                }
+
+                Population new_population { population.next_generation(
+                                                search_space, mutation_rate,
+                                                elite_num,
+                                                island_rngs[island] ) };
+                new_population.compute_population_fitness( *this, datafeed,
+                                                    island_results[island],
+                                                    memos[island] );
+                population = new_population;
+
+                // Migration (without waiting for other islands)
+                if( !interleaved && islands > 1
+                    && generation % migration_interval == 0 ){
+                    if( post_migrants( island ) ){
+                        posted += migrants;
+                    }
+                    else{
+                        dropped += migrants;
+                    }
+                    receive_migrants( island );
+                }
+            }
+            //-
+
+            if( last == generations ){
+                best_individuals[island] = population.population()[0];
+
+                #pragma omp critical
+                {
+                    std::cout << utils_time::current_datetime_str() + " | "
+                              << "End   Island " << island + 1 << " / "
+                              << islands << "\tBest Fitness = "
+                              << best_individuals[island].fitness() << "\n";
+                }
+            }
+        }
+        //--
+
+        // Migration of interleaved islands, all at the end of the epoch
+        // (mailboxes emptied before the next posts: no migrant dropped)
+        if( interleaved && last >= 2 && last % migration_interval == 0 ){
+            for( int island = 0; island < islands; island++ ){
+                if( post_migrants( island ) ){
+                    posted += migrants;
+                }
+                else{
+                    dropped += migrants;
+                }
+            }
+            for( int island = 0; island < islands; island++ ){
+                receive_migrants( island );
+            }
+        }
+    }
+    //--- End loop over epochs
+
+    omp_set_max_active_levels( max_levels );
+
+    // Merge results of all islands
+    // (chromosomes evaluated by more than one island appended once)
+    std::unordered_set<std::vector<int>, ParamValuesHash> merged {};
+    for( const std::vector<strategy_t> &results: island_results ){
+        for( const strategy_t &strategy: results ){
+            parameters_t params {};
+            utils_params::extract_parameters_from_single_strategy( strategy,
+                                                                   params );
+            if( merged.insert( chromosome_key( params, param_deps_ ) ).second ){
+                optim_results.push_back( strategy );
+            }
+        }
+    }
+
+    std::cout << "\nMigrants posted: " << posted << ", dropped: " << dropped
+              << "\nDistinct chromosomes evaluated: " << merged.size()
+              << "\n";
+
+    // Sort in descending order of fitness_metric
+    utils_optim::sort_by_metric( optim_results, fitness_metric );
+
+    // Best individual among all islands
+    int best_island {0};
+    for( int island = 1; island < islands; island++ ){
+        if( best_individuals[island].fitness()
+                > best_individuals[best_island].fitness() ){
+            best_island = island;
+        }
+    }
+
+    // Store counters/dates of parsed data (for printing),
+    // from backtest of best individual (already in cache, if enabled)
+    BacktestRecord best_record {};
+    run_cached_backtest( best_record, BacktestRequest { datafeed.get(),
+                            best_individuals[best_island].chromosome() } );
+    set_parsed_info( best_record );
+
+    // Write optimization results to file 'optim_file'
+    int control = utils_fileio::write_strategies_to_file(
+                                            optim_file, paramfile,
+                                            optim_results, strategy_name_,
+                                            symbol_.name(), timeframe_,
+                                            first_date_parsed_,
+                                            last_date_parsed_, true );
+    if( control == 1 ){
+        std::cout << "\nOptimization results written on file: "
+                  << optim_file <<"\n";
+    }
+}
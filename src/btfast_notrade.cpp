@@ -37,7 +37,7 @@ void BTfast::run_notrade( Account &account,
     // Initialize Price Collection
     // (maps containing lists of bars for each symbol/tf)
     PriceCollection price_collection { symbol_, timeframe_,
-                                       max_bars_back_, false };
+                                       max_bars_back_, false, 0 };
     // Initialize Position Handler
     PositionHandler position_handler { account };
     // Initialize Position Sizer
@@ -51,9 +51,9 @@ void BTfast::run_notrade( Account &account,
 
 
     // Initialize all components for backtest
-    initialize_backtest( events_queue, datafeed, execution_handler, strategy,
+    initialize_backtest( events_queue, datafeed.get(), execution_handler, strategy,
                          price_collection, position_handler, signal_handler,
-                         strategy_params );
+                         strategy_params, 0 );
 
     int bar_count {0};
 
@@ -0,0 +1,266 @@
+#include "btfast.h"
+
+#include "genetic.h"    // Individual, chromosome_key
+#include "utils_fileio.h"      // write_strategies_to_file
+#include "utils_optim.h"      // nondominated_fronts, crowding_distance
+#include "utils_params.h"     // strategy_attribute_by_name
+#include "utils_random.h"     // RandomStream, global_seed, shuffle
+#include "utils_time.h"     // current_datetime_str
+
+#include <algorithm>        // std::find, std::sort
+#include <iostream>         // std::cout
+#include <unordered_map>    // std::unordered_map
+
+
+//-------------------------------------------------------------------------- //
+/*! Run NSGA-II multi-objective (Pareto) Optimization over 'search_space'
+    combinations, maximizing all metrics in 'objectives' (names as in
+    optimization results, e.g. "Ntrades", "AvgTicks", "NP/MDD", "Z-score").
+    The Pareto front of all evaluated combinations is stored into
+    'optim_results' and written to 'optim_file', sorted by fitness_metric.
+
+    Each generation:
+    - parents are selected by binary tournament on (front rank, crowding
+      distance) in the current population,
+    - offspring are bred by uniform crossover and mutation (as in
+      run_genetic_optimization), and evaluated in parallel
+      (distinct combinations not evaluated before),
+    - the next population is made of the best 'population_size'
+      combinations of parents + offspring, by front rank and then by
+      crowding distance (NSGA-II elitist replacement).
+
+    search_space: combination of parameters to run optimization over (input)
+            (not const because shuffled)
+    optim_results: vector where storing optimization resus (metrics + params)
+    paramfile: XML file with strategy parameter ranges/value.
+    optim_file: file where optimization results are written
+    fitness_metric: used to sort optimization results in descending order
+    datafeed: smart pointer to DataFeed object
+    population_size: size of population
+    generations: number of generations
+    objectives: names of metrics to maximize
+*/
+
+void BTfast::run_nsga2_optimization( std::vector<parameters_t> &search_space,
+                                     std::vector<strategy_t> &optim_results,
+                                     const std::string &optim_file,
+                                     const std::string &paramfile,
+                                     const std::string &fitness_metric,
+                                     std::unique_ptr<DataFeed> &datafeed,
+                                     int population_size, int generations,
+                            const std::vector<std::string> &objectives )
+{
+    // Set up probability of mutation
+    double mutation_rate { 0.1 };
+
+    const std::vector<std::string> metric_names { "Ntrades", "AvgTicks",
+                            "WinPerc", "PftFactor", "NP/MDD", "Expectancy",
+                            "Z-score", "NetPL", "AvgTrade", "StdTicks" };
+    if( objectives.empty() ){
+        std::cout << ">>> ERROR: no Pareto objectives "
+                  << "(run_nsga2_optimization).\n";
+        exit(1);
+    }
+    for( const std::string &name: objectives ){
+        if( std::find( metric_names.begin(), metric_names.end(), name )
+                == metric_names.end() ){
+            std::cout << ">>> ERROR: invalid Pareto objective " << name
+                      << " (run_nsga2_optimization).\n";
+            exit(1);
+        }
+    }
+    if( population_size < 2
+        || (size_t) population_size > search_space.size() ){
+        std::cout << ">>> ERROR: population size must be at least 2 and "
+                  << "smaller than search space dimension "
+                  << search_space.size() <<"\n";
+        exit(1);
+    }
+
+    // Random stream of genetic operators (reproducible with RANDOM_SEED)
+    utils_random::RandomStream rng { utils_random::global_seed(),
+                                     utils_random::genetic_domain, 0, 2 };
+
+    // All combinations evaluated: results, parameters, objective values
+    std::vector<strategy_t> evaluated {};
+    std::vector<parameters_t> evaluated_params {};
+    std::vector<std::vector<double>> values {};
+    // Position in 'evaluated' of each distinct (canonical) combination
+    std::unordered_map<std::vector<int>, int, ParamValuesHash> memo {};
+
+    // Evaluate (in parallel) combinations in 'batch' not evaluated before,
+    // return their positions in 'evaluated'
+    auto evaluate = [&]( const std::vector<parameters_t> &batch ){
+        std::vector<int> positions {};
+        std::vector<parameters_t> new_params {};
+        for( const parameters_t &params: batch ){
+            auto inserted = memo.emplace(
+                                chromosome_key( params, param_deps_ ),
+                                (int) ( evaluated.size() + new_params.size() ) );
+            if( inserted.second ){
+                new_params.push_back( params );
+            }
+            positions.push_back( inserted.first->second );
+        }
+        std::vector<strategy_t> results {};
+        run_parallel_optimization( new_params, results, "", "",
+                                   fitness_metric, datafeed, false, false );
+        if( results.size() != new_params.size() ){
+            std::cout << ">>> ERROR: pruned runs in Pareto optimization "
+                      << "(run_nsga2_optimization).\n";
+            exit(1);
+        }
+        for( size_t i = 0; i < results.size(); i++ ){
+            std::vector<double> v {};
+            for( const std::string &name: objectives ){
+                v.push_back( utils_params::strategy_attribute_by_name(
+                                                        name, results[i] ) );
+            }
+            evaluated.push_back( results[i] );
+            evaluated_params.push_back( new_params[i] );
+            values.push_back( v );
+        }
+        return(positions);
+    };
+
+    // Front rank and crowding distance of each member of 'population'
+    // (positions in 'evaluated'); return fronts (positions in 'population')
+    std::vector<int> rank {};
+    std::vector<double> crowding {};
+    auto rank_population = [&]( const std::vector<int> &population ){
+        std::vector<std::vector<double>> pop_values {};
+        for( int p: population ){
+            pop_values.push_back( values[p] );
+        }
+        std::vector<std::vector<int>> fronts {
+                            utils_optim::nondominated_fronts( pop_values ) };
+        rank.assign( population.size(), 0 );
+        crowding.assign( population.size(), 0.0 );
+        for( size_t k = 0; k < fronts.size(); k++ ){
+            std::vector<double> distance {
+                utils_optim::crowding_distance( pop_values, fronts[k] ) };
+            for( size_t j = 0; j < fronts[k].size(); j++ ){
+                rank[fronts[k][j]] = k;
+                crowding[fronts[k][j]] = distance[j];
+            }
+        }
+        return(fronts);
+    };
+
+    // Binary tournament: lower rank, then larger crowding distance
+    auto tournament = [&]( const std::vector<int> &population ){
+        int n { (int) population.size() };
+        int a { utils_random::uniform_int( rng, 0, n-1 ) };
+        int b { utils_random::uniform_int( rng, 0, n-1 ) };
+        if( rank[b] < rank[a]
+            || ( rank[b] == rank[a] && crowding[b] > crowding[a] ) ){
+            a = b;
+        }
+        return( population[a] );
+    };
+
+    //-- Initial population (1st generation)
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Start Generation 1 / " << generations << "\n";
+
+    utils_random::shuffle( search_space, rng );
+    std::vector<int> population { evaluate( std::vector<parameters_t> {
+                                    search_space.begin(),
+                                    search_space.begin() + population_size } ) };
+    rank_population( population );
+
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "End   Generation 1 / " << generations << "\n\n";
+    //--
+
+    //--- Loop over successive generations
+    for( int generation = 2; generation <= generations; generation++ ){
+
+        std::cout << utils_time::current_datetime_str() + " | "
+                  << "Start Generation " << generation
+                  << " / " << generations << "\n";
+
+        // Offspring: selection, crossover, mutation
+        std::vector<parameters_t> offspring {};
+        while( offspring.size() < (size_t) population_size ){
+            int parent1 { tournament( population ) };
+            int parent2 { tournament( population ) };
+            int selection_trials {0};
+            // enforce that the parents are different (max population_size trials)
+            while( parent2 == parent1 && selection_trials < population_size ){
+                parent2 = tournament( population );
+                selection_trials++;
+            }
+            Individual child { evaluated_params[parent1] };
+            Individual other { evaluated_params[parent2] };
+            child.uniform_crossover( other, rng );
+            if( utils_random::uniform01(rng) < mutation_rate ){
+                child.mutate( search_space, rng );
+            }
+            offspring.push_back( child.chromosome() );
+        }
+        std::vector<int> offspring_positions { evaluate( offspring ) };
+
+        // Parents + offspring (distinct combinations)
+        std::vector<int> combined { population };
+        for( int p: offspring_positions ){
+            if( std::find( combined.begin(), combined.end(), p )
+                    == combined.end() ){
+                combined.push_back(p);
+            }
+        }
+
+        // Next population: best fronts, last one by crowding distance
+        std::vector<std::vector<int>> fronts { rank_population( combined ) };
+        population.clear();
+        for( std::vector<int> &front: fronts ){
+            if( population.size() + front.size() > (size_t) population_size ){
+                std::sort( front.begin(), front.end(),
+                           [&crowding]( int a, int b ){
+                               return( crowding[a] > crowding[b] );
+                           } );
+                front.resize( population_size - population.size() );
+            }
+            for( int j: front ){
+                population.push_back( combined[j] );
+            }
+            if( population.size() == (size_t) population_size ){
+                break;
+            }
+        }
+        rank_population( population );
+
+        std::cout << utils_time::current_datetime_str() + " | "
+                  << "End   Generation " << generation
+                  << " / " << generations << "\t"
+                  << "First front: " << fronts[0].size()
+                  << ", evaluated: " << evaluated.size() << "\n\n";
+    }
+    //--- End loop over generations
+
+    // Pareto front of all evaluated combinations
+    std::vector<std::vector<int>> fronts {
+                                utils_optim::nondominated_fronts( values ) };
+    for( int p: fronts[0] ){
+        optim_results.push_back( evaluated[p] );
+    }
+    std::cout << "Pareto front: " << optim_results.size()
+              << " strategies (of " << evaluated.size()
+              << " evaluated)\n";
+
+    // Sort in descending order of fitness_metric
+    utils_optim::sort_by_metric( optim_results, fitness_metric );
+
+    // Write optimization results to file 'optim_file'
+    // (counters/dates of parsed data set by run_parallel_optimization)
+    int control = utils_fileio::write_strategies_to_file(
+                                            optim_file, paramfile,
+                                            optim_results, strategy_name_,
+                                            symbol_.name(), timeframe_,
+                                            first_date_parsed_,
+                                            last_date_parsed_, true );
+    if( control == 1 ){
+        std::cout << "\nOptimization results written on file: "
+                  << optim_file <<"\n";
+    }
+}
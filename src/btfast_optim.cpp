@@ -1,8 +1,10 @@
 #include "btfast.h"         // parameters_t, strategy_t
 
+#include "backtest_cache.h" // BacktestRecord
 #include "utils_fileio.h"   // write_strategies_to_file
 #include "utils_time.h"     // current_datetime_str
 #include "utils_optim.h"    //  append_to_optim_results, sort_by_metric
+#include "utils_params.h"   // canonical_search_space
 
 //#include <algorithm>        // std::for_each
 #include <chrono>           // std::chrono
@@ -30,6 +32,12 @@
     fitness_metric: used to sort optimization results in descending order
     datafeed: smart pointer to DataFeed object
 
+    Backtests are stopped early by the pruning rules set with set_pruning()
+    (if any), and pruned runs are discarded from results.
+
+    With parameter dependencies (set_param_dependencies), only one
+    combination of each class of equivalent ones is run, and its result
+    is copied to all combinations of the class.
 */
 
 void BTfast::run_parallel_optimization(
@@ -41,18 +49,35 @@ void BTfast::run_parallel_optimization(
                                         std::unique_ptr<DataFeed> &datafeed,
                                         bool sort_results, bool verbose )
 {
-    // disable printing number of bars parsed
-    print_progress_ = false;
-
     std::mutex mtx;
     int iter {0};
 
+    // Combinations to run: canonical representatives of equivalent
+    // combinations (if parameter dependencies are declared)
+    std::vector<parameters_t> canonical {};
+    std::vector<size_t> class_index {};
+    bool equivalence { !param_deps_.empty() };
+    if( equivalence ){
+        utils_params::canonical_search_space( search_space, param_deps_,
+                                              canonical, class_index );
+        if( verbose ){
+            std::cout << "Equivalent combinations: running "
+                      << canonical.size() << " / " << search_space.size()
+                      << "\n";
+        }
+    }
+    const std::vector<parameters_t> &runs { equivalence ? canonical
+                                                        : search_space };
+
+    // Results of each run, in the same order as 'runs'
+    std::vector<BacktestRecord> records ( runs.size() );
+
     //--- Start optimization loop
     // *parameter_combination is a single set of parameter values:
     // [ ("p1", 10), ("p2", 2), ... ]
     #pragma omp parallel for
-    for( auto parameter_combination = search_space.begin();
-         parameter_combination < search_space.end();
+    for( auto parameter_combination = runs.begin();
+         parameter_combination < runs.end();
          parameter_combination++ ){
 
     /*std::for_each(  //std::execution::par_unseq,
@@ -69,38 +94,59 @@ void BTfast::run_parallel_optimization(
             std::cout << utils_time::current_datetime_str() + " | "
                       << "(Parallel) Running optimization " << iter << " / "
                       //<< std::distance(search_space.begin(), parameter_combination)+1
-                      << search_space.size() << "\n";
+                      << runs.size() << "\n";
             mtx.unlock();
         }
 
         // Make a copy of DataFeed object and wrap it into a new unique_ptr
         std::unique_ptr<DataFeed> datafeed_copy = datafeed.get()->clone();
 
-        // Initialize Account
-        Account account { initial_balance_ };
-
         // Run backtest (passing strategy parameters of current run)
-        run_backtest( account, datafeed_copy, *parameter_combination );
-
-        // Initialize Performance object
-        Performance performance { initial_balance_,
-                                  std::vector<Transaction> {} };
-        // Load transaction history into performance object
-        performance.set_transactions( account.transactions() );
-        // Compute performance metrics
-        performance.compute_metrics();
-
-        // Append performance metrics and parameter combination
-        // to optimization results
-        //#pragma omp critical
-        utils_optim::append_to_optim_results( optim_results, performance,
-                                              *parameter_combination );
+        // and compute performance metrics (or take them from cache)
+        // (run index = position in search space: random streams
+        // do not depend on thread scheduling).
+        // Only metrics of optimization results are computed
+        size_t run_index = parameter_combination - runs.begin();
+        run_cached_backtest( records[run_index],
+                             BacktestRequest { datafeed_copy.get(),
+                                               *parameter_combination,
+                                               false, false, run_index,
+                                               false, metric_optim,
+                                               pruning_ } );
     }
     //--- End optimization loop
     if( verbose ){
         std::cout << "Optimization Done.\n";
     }
 
+    // Append performance metrics and parameter combinations
+    // to optimization results (in order of search space).
+    // Pruned runs (partial metrics) are discarded
+    int num_pruned {0};
+    for( size_t i = 0; i < search_space.size(); i++ ){
+        const BacktestRecord &record { records[ equivalence ? class_index[i]
+                                                            : i ] };
+        if( record.pruned ){
+            num_pruned++;
+            continue;
+        }
+        utils_optim::append_to_optim_results( optim_results, record,
+                                              search_space[i] );
+    }
+    if( verbose && num_pruned > 0 ){
+        std::cout << "Pruned runs: " << num_pruned << " / "
+                  << search_space.size() << "\n";
+    }
+    // Store counters/dates of parsed data (for printing),
+    // from a complete run if any
+    if( !records.empty() ){
+        size_t i {0};
+        while( i < records.size() - 1 && records[i].pruned ){
+            i++;
+        }
+        set_parsed_info( records[i] );
+    }
+
 
     // Sort in descending order of fitness_metric
     if( sort_results ){
@@ -141,6 +187,8 @@ void BTfast::run_parallel_optimization(
     fitness_metric: used to sort optimization results in descending order
     datafeed: smart pointer to DataFeed object
 
+    Backtests are stopped early by the pruning rules set with set_pruning()
+    (if any), and pruned runs are discarded from results.
 */
 
 void BTfast::run_optimization( const std::vector<parameters_t> &search_space,
@@ -151,9 +199,6 @@ void BTfast::run_optimization( const std::vector<parameters_t> &search_space,
                                std::unique_ptr<DataFeed> &datafeed,
                                bool sort_results, bool verbose )
 {
-    // disable printing number of bars parsed
-    print_progress_ = false;
-
     std::vector<double> iteration_times(5);  // store first 5 iteration times
     int hh {0};
     int mm {0};
@@ -179,24 +224,29 @@ void BTfast::run_optimization( const std::vector<parameters_t> &search_space,
         // Starts computing elapsed time
         t1 = std::chrono::high_resolution_clock::now();
 
-        // Initialize Account
-        Account account { initial_balance_ };
-
         // Run backtest (passing strategy parameters of current run)
-        run_backtest( account, datafeed, parameter_combination );
-
-        // Initialize Performance object
-        Performance performance { initial_balance_,
-                                  std::vector<Transaction> {} };
-        // Load transaction history into performance object
-        performance.set_transactions( account.transactions() );
-        // Compute performance metrics
-        performance.compute_metrics();
-
-        // Append performance metrics and parameter combination
-        // to optimization results
-        utils_optim::append_to_optim_results(optim_results, performance,
-                                             parameter_combination);
+        // and compute performance metrics (or take them from cache)
+        BacktestRecord record {};
+        // (run index = position in search space, as in parallel version)
+        run_cached_backtest( record, BacktestRequest { datafeed.get(),
+                                                       parameter_combination,
+                                                       false, false,
+                                                       (uint64_t) iter - 1,
+                                                       false, metric_optim,
+                                                       pruning_ } );
+        // Pruned runs (partial metrics) are discarded
+        if( !record.pruned ){
+            // Store counters/dates of parsed data (for printing)
+            set_parsed_info( record );
+
+            // Append performance metrics and parameter combination
+            // to optimization results
+            utils_optim::append_to_optim_results(optim_results, record,
+                                                 parameter_combination);
+        }
+        else if( verbose ){
+            std::cout << "Pruned run " << iter << "\n";
+        }
 
 
         //- Compute and print remaining time
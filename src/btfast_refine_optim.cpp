@@ -0,0 +1,182 @@
+#include "btfast.h"
+
+#include "strategy_index.h"   // ParamValuesHash
+#include "utils_fileio.h"     // write_strategies_to_file
+#include "utils_optim.h"      // sort_by_metric
+#include "utils_params.h"     // parameters_from_indices, indices_from_parameters
+#include "utils_time.h"       // current_datetime_str
+
+#include <algorithm>        // std::max, std::min
+#include <iostream>         // std::cout
+#include <unordered_set>    // std::unordered_set
+
+
+//-------------------------------------------------------------------------- //
+/*! Run Coarse-to-fine Optimization over the grid of 'parameter_ranges',
+    without building the Cartesian product.
+    Results stored into 'optim_results' and written to 'optim_file'.
+
+    Level 0 evaluates the coarse grid made of every 'coarse_factor'-th
+    value of each range (plus its last value). At each following level the
+    stride is halved, and only the neighbours at the new stride of the
+    'refine_top' best combinations evaluated so far are evaluated, until
+    the native step (stride 1) is reached. Neighbours are taken one
+    parameter at a time (centre moved by -stride or +stride along a single
+    parameter), not over all combinations of offsets. Combinations already
+    evaluated at previous levels are not evaluated again.
+    For smooth parameters (e.g. stops, fractions), it finds the optimum of
+    exhaustive optimization at a fraction of its cost.
+
+    Cost, with n parameters having a range of size N_i:
+    level 0 runs prod_i ( ceil(N_i / coarse_factor) + 1 ) backtests,
+    each of the floor(log2(coarse_factor)) refinement levels at most
+    refine_top * (2n + 1) (instead of refine_top * 3^n for the full
+    neighbourhood).
+
+    parameter_ranges: range of values of each parameter (input)
+    optim_results: vector where storing optimization results (metrics + params)
+    optim_file: file where optimization results are written
+    paramfile: XML file with strategy parameter ranges/value.
+    fitness_metric: used to sort optimization results in descending order
+    datafeed: smart pointer to DataFeed object
+    coarse_factor: stride of coarse grid, in steps of each range (>= 2)
+    refine_top: number of best combinations refined at each level (>= 1)
+*/
+
+void BTfast::run_refinement_optimization(
+                                    const param_ranges_t &parameter_ranges,
+                                    std::vector<strategy_t> &optim_results,
+                                    const std::string &optim_file,
+                                    const std::string &paramfile,
+                                    const std::string &fitness_metric,
+                                    std::unique_ptr<DataFeed> &datafeed,
+                                    int coarse_factor, int refine_top )
+{
+    if( coarse_factor < 2 || refine_top < 1 ){
+        std::cout << ">>> ERROR: COARSE_FACTOR must be at least 2 and "
+                  << "REFINE_TOP at least 1 (run_refinement_optimization).\n";
+        exit(1);
+    }
+
+    // Size of each range, and of grid
+    size_t nparams { parameter_ranges.size() };
+    std::vector<int> sizes ( nparams );
+    double grid_size {1.0};
+    for( size_t i = 0; i < nparams; i++ ){
+        sizes[i] = (int) parameter_ranges[i].second.size();
+        grid_size *= sizes[i];
+    }
+
+    // Positions in grid of combinations already evaluated (or in batch)
+    std::unordered_set<std::vector<int>, ParamValuesHash> drawn {};
+    // Combinations to evaluate in next batch
+    std::vector<parameters_t> batch {};
+
+    // Add combination at grid position 'index' to batch, if not drawn before
+    auto draw = [&]( const std::vector<int> &index ){
+        if( drawn.insert( index ).second ){
+            batch.push_back( utils_params::parameters_from_indices(
+                                                parameter_ranges, index ) );
+        }
+    };
+
+    //-- Level 0: coarse grid
+    int stride { coarse_factor };
+    // Positions of coarse grid in each range (every stride-th, and last)
+    std::vector<std::vector<int>> coarse ( nparams );
+    for( size_t i = 0; i < nparams; i++ ){
+        for( int k = 0; k < sizes[i]; k += stride ){
+            coarse[i].push_back(k);
+        }
+        if( coarse[i].back() != sizes[i] - 1 ){
+            coarse[i].push_back( sizes[i] - 1 );
+        }
+    }
+    // All positions of coarse grid (odometer over coarse positions)
+    std::vector<size_t> digit ( nparams, 0 );
+    bool done { nparams == 0 };
+    while( !done ){
+        std::vector<int> index ( nparams );
+        for( size_t i = 0; i < nparams; i++ ){
+            index[i] = coarse[i][digit[i]];
+        }
+        draw( index );
+        done = true;
+        for( size_t i = 0; i < nparams; i++ ){
+            if( ++digit[i] < coarse[i].size() ){
+                done = false;
+                break;
+            }
+            digit[i] = 0;
+        }
+    }
+
+    int level {0};
+    while( true ){
+
+        if( !batch.empty() ){
+            std::cout << utils_time::current_datetime_str() + " | "
+                      << "Level " << level << " (stride " << stride << "): "
+                      << "evaluating " << batch.size() << " combinations\n";
+            run_parallel_optimization( batch, optim_results, "", "",
+                                       fitness_metric, datafeed, false, false );
+            batch.clear();
+        }
+        else{
+            std::cout << utils_time::current_datetime_str() + " | "
+                      << "Level " << level << " (stride " << stride << "): "
+                      << "no new combinations\n";
+        }
+
+        if( stride == 1 ){
+            break;
+        }
+
+        //-- Next level: neighbours of best combinations at half stride
+        stride = std::max( 1, stride / 2 );
+        level++;
+
+        utils_optim::sort_by_metric( optim_results, fitness_metric );
+        for( size_t j = 0; j < (size_t) refine_top
+                           && j < optim_results.size(); j++ ){
+            parameters_t params {};
+            utils_params::extract_parameters_from_single_strategy(
+                                                    optim_results[j], params );
+            std::vector<int> center { utils_params::indices_from_parameters(
+                                                parameter_ranges, params ) };
+            // Centre, and centre moved by -stride, +stride along each
+            // parameter with a range (coordinate-wise: 2n+1 neighbours)
+            draw( center );
+            for( size_t i = 0; i < nparams; i++ ){
+                if( sizes[i] <= 1 ){
+                    continue;
+                }
+                for( int sign: { -1, 1 } ){
+                    std::vector<int> index { center };
+                    index[i] = std::min( sizes[i] - 1, std::max( 0,
+                                            center[i] + sign * stride ) );
+                    draw( index );
+                }
+            }
+        }
+    }
+
+    std::cout << "Refinement Done. Evaluated " << optim_results.size()
+              << " / " << grid_size << " combinations\n";
+
+    // Sort in descending order of fitness_metric
+    utils_optim::sort_by_metric( optim_results, fitness_metric );
+
+    // Write optimization results to file 'optim_file'
+    // (counters/dates of parsed data set by run_parallel_optimization)
+    int control = utils_fileio::write_strategies_to_file(
+                                            optim_file, paramfile,
+                                            optim_results, strategy_name_,
+                                            symbol_.name(), timeframe_,
+                                            first_date_parsed_,
+                                            last_date_parsed_, true );
+    if( control == 1 ){
+        std::cout << "\nOptimization results written on file: "
+                  << optim_file <<"\n";
+    }
+}
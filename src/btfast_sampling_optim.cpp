@@ -0,0 +1,203 @@
+#include "btfast.h"
+
+#include "strategy_index.h"   // ParamValuesHash
+#include "utils_fileio.h"     // write_strategies_to_file
+#include "utils_optim.h"      // sort_by_metric
+#include "utils_params.h"     // parameters_from_indices, indices_from_parameters
+#include "utils_random.h"     // RandomStream, SobolSequence, latin_hypercube
+#include "utils_time.h"       // current_datetime_str
+
+#include <algorithm>        // std::max, std::min
+#include <iostream>         // std::cout
+#include <unordered_set>    // std::unordered_set
+
+
+//-------------------------------------------------------------------------- //
+/*! Run Sampling Optimization: evaluate 'samples' combinations of the grid
+    of 'parameter_ranges', drawn directly in index space (position of the
+    value of each parameter in its range), without building the Cartesian
+    product. For grids too large for exhaustive optimization.
+    Results stored into 'optim_results' and written to 'optim_file'.
+
+    Sampling methods:
+    - "sobol": Sobol low-discrepancy sequence, with random digital shift
+               (at most SobolSequence::max_dims parameters with a range)
+    - "lhs": Latin hypercube (each value of each parameter sampled about
+             the same number of times)
+
+    Adaptive refinement ('refine_rounds' > 0): each round draws samples/2
+    new combinations around the best 10% of those evaluated so far
+    (uniformly within a box of half-width 1/4 of each range in the first
+    round, halved at each following round).
+
+    Combinations are evaluated in parallel, each distinct combination once.
+
+    parameter_ranges: range of values of each parameter (input)
+    optim_results: vector where storing optimization results (metrics + params)
+    optim_file: file where optimization results are written
+    paramfile: XML file with strategy parameter ranges/value.
+    fitness_metric: used to sort optimization results in descending order
+    datafeed: smart pointer to DataFeed object
+    samples: number of combinations sampled (before refinement)
+    method: sampling method ("sobol", "lhs")
+    refine_rounds: number of rounds of adaptive refinement (0 = none)
+*/
+
+void BTfast::run_sampling_optimization( const param_ranges_t &parameter_ranges,
+                                        std::vector<strategy_t> &optim_results,
+                                        const std::string &optim_file,
+                                        const std::string &paramfile,
+                                        const std::string &fitness_metric,
+                                        std::unique_ptr<DataFeed> &datafeed,
+                                        int samples, const std::string &method,
+                                        int refine_rounds )
+{
+    if( samples < 1 ){
+        std::cout << ">>> ERROR: SAMPLES must be at least 1 "
+                  << "(run_sampling_optimization).\n";
+        exit(1);
+    }
+    if( method != "sobol" && method != "lhs" ){
+        std::cout << ">>> ERROR: invalid SAMPLING_METHOD " << method
+                  << " (run_sampling_optimization).\n";
+        exit(1);
+    }
+
+    // Parameters with a range (sampled dimensions), and size of grid
+    std::vector<size_t> dims {};
+    double grid_size {1.0};
+    for( size_t i = 0; i < parameter_ranges.size(); i++ ){
+        size_t n { parameter_ranges[i].second.size() };
+        grid_size *= n;
+        if( n > 1 ){
+            dims.push_back(i);
+        }
+    }
+    if( method == "sobol" && dims.size() > utils_random::SobolSequence::max_dims ){
+        std::cout << ">>> ERROR: Sobol sampling supports at most "
+                  << utils_random::SobolSequence::max_dims
+                  << " parameters with a range: use lhs "
+                  << "(run_sampling_optimization).\n";
+        exit(1);
+    }
+    // Number of distinct combinations that can be drawn
+    size_t max_samples { grid_size < 1e18 ? (size_t) grid_size : (size_t) 1e18 };
+
+    std::cout << "Grid size: " << grid_size << " combinations. "
+              << "Sampling " << samples << " (" << method << ")\n";
+
+    // Random stream of sampling (reproducible with RANDOM_SEED)
+    utils_random::RandomStream rng { utils_random::global_seed(),
+                                     utils_random::sampling_domain, 0, 0 };
+
+    // Positions in grid of combinations already drawn
+    std::unordered_set<std::vector<int>, ParamValuesHash> drawn {};
+    // Combinations to evaluate in next batch
+    std::vector<parameters_t> batch {};
+
+    // Add combination at grid position 'index' to batch, if not drawn before
+    auto draw = [&]( const std::vector<int> &index ){
+        if( drawn.insert( index ).second ){
+            batch.push_back( utils_params::parameters_from_indices(
+                                                parameter_ranges, index ) );
+        }
+    };
+    // Grid position of point 'u' in [0,1)^dims
+    auto to_index = [&]( const std::vector<double> &u ){
+        std::vector<int> index ( parameter_ranges.size(), 0 );
+        for( size_t k = 0; k < dims.size(); k++ ){
+            int n { (int) parameter_ranges[dims[k]].second.size() };
+            index[dims[k]] = std::min( n - 1, (int) ( u[k] * n ) );
+        }
+        return(index);
+    };
+    // Evaluate batch (in parallel), append results to optim_results
+    auto evaluate = [&]( const std::string &stage ){
+        std::cout << utils_time::current_datetime_str() + " | "
+                  << stage << ": evaluating " << batch.size()
+                  << " combinations\n";
+        run_parallel_optimization( batch, optim_results, "", "",
+                                   fitness_metric, datafeed, false, false );
+        batch.clear();
+    };
+
+    //-- Initial sample
+    size_t target { std::min( (size_t) samples, max_samples ) };
+    if( method == "sobol" ){
+        utils_random::SobolSequence sequence { dims.size(), &rng };
+        std::vector<double> u {};
+        // (duplicates on small ranges: at most 4*samples points)
+        for( size_t i = 0; i < 4 * target && drawn.size() < target; i++ ){
+            sequence.next( u );
+            draw( to_index( u ) );
+        }
+    }
+    else{
+        for( const std::vector<double> &u:
+                utils_random::latin_hypercube( target, dims.size(), rng ) ){
+            draw( to_index( u ) );
+        }
+    }
+    evaluate( "Initial sample" );
+
+    //-- Adaptive refinement around best combinations
+    for( int round = 1; round <= refine_rounds
+                        && drawn.size() < max_samples; round++ ){
+
+        utils_optim::sort_by_metric( optim_results, fitness_metric );
+        size_t num_best { std::max( (size_t) 1, optim_results.size() / 10 ) };
+        std::vector<std::vector<int>> best {};
+        for( size_t i = 0; i < num_best && i < optim_results.size(); i++ ){
+            parameters_t params {};
+            utils_params::extract_parameters_from_single_strategy(
+                                                    optim_results[i], params );
+            best.push_back( utils_params::indices_from_parameters(
+                                                parameter_ranges, params ) );
+        }
+
+        // Half-width of box around best combinations, in each dimension
+        std::vector<int> radius ( parameter_ranges.size(), 0 );
+        for( size_t d: dims ){
+            int n { (int) parameter_ranges[d].second.size() };
+            radius[d] = std::max( 1, n >> (round + 1) );
+        }
+
+        size_t new_samples { std::max( (size_t) 1, target / 2 ) };
+        size_t start { drawn.size() };
+        for( size_t i = 0; i < 4 * new_samples
+                           && drawn.size() - start < new_samples; i++ ){
+            std::vector<int> index { best[ i % best.size() ] };
+            for( size_t d: dims ){
+                int n { (int) parameter_ranges[d].second.size() };
+                index[d] = std::min( n - 1, std::max( 0,
+                                index[d] + utils_random::uniform_int( rng,
+                                                -radius[d], radius[d] ) ) );
+            }
+            draw( index );
+        }
+        if( batch.empty() ){
+            break;
+        }
+        evaluate( "Refinement " + std::to_string(round) + " / "
+                  + std::to_string(refine_rounds) );
+    }
+
+    std::cout << "Sampling Done. Evaluated " << optim_results.size()
+              << " / " << grid_size << " combinations\n";
+
+    // Sort in descending order of fitness_metric
+    utils_optim::sort_by_metric( optim_results, fitness_metric );
+
+    // Write optimization results to file 'optim_file'
+    // (counters/dates of parsed data set by run_parallel_optimization)
+    int control = utils_fileio::write_strategies_to_file(
+                                            optim_file, paramfile,
+                                            optim_results, strategy_name_,
+                                            symbol_.name(), timeframe_,
+                                            first_date_parsed_,
+                                            last_date_parsed_, true );
+    if( control == 1 ){
+        std::cout << "\nOptimization results written on file: "
+                  << optim_file <<"\n";
+    }
+}
@@ -0,0 +1,282 @@
+#include "btfast.h"
+
+#include "random_forest.h"    // RandomForest
+#include "strategy_index.h"   // ParamValuesHash
+#include "utils_fileio.h"     // write_strategies_to_file
+#include "utils_optim.h"      // sort_by_metric
+#include "utils_params.h"     // parameters_from_indices, indices_from_parameters
+#include "utils_random.h"     // RandomStream, SobolSequence, latin_hypercube
+#include "utils_time.h"       // current_datetime_str
+
+#include <algorithm>        // std::max, std::min, std::partial_sort
+#include <cmath>            // std::erfc, std::exp, std::sqrt
+#include <iostream>         // std::cout
+#include <numeric>          // std::iota
+#include <unordered_set>    // std::unordered_set
+
+
+//-------------------------------------------------------------------------- //
+/*! Run Surrogate-guided Optimization over the grid of 'parameter_ranges',
+    without building the Cartesian product.
+    Results stored into 'optim_results' and written to 'optim_file'.
+
+    A random forest (RandomForest) is fitted to the fitness of the
+    combinations evaluated so far (grid positions -> fitness_metric).
+    Each iteration evaluates in parallel the 'batch_size' candidate
+    combinations with largest expected improvement (EI) over the best
+    fitness found, with mean and uncertainty of the surrogate given by
+    mean and spread of the trees:
+        EI = (mu - best) * Phi(z) + sigma * phi(z),  z = (mu - best) / sigma
+    Candidates are all combinations not yet evaluated, for grids up to
+    max_pool combinations, or else a random pool of max_pool combinations
+    (half uniform, half around the best ones).
+    The first batch (about 1/4 of 'budget') is a Sobol (or Latin
+    hypercube, for more than 21 parameters with a range) sample.
+    Stops after 'budget' backtests.
+
+    parameter_ranges: range of values of each parameter (input)
+    optim_results: vector where storing optimization results (metrics + params)
+    optim_file: file where optimization results are written
+    paramfile: XML file with strategy parameter ranges/value.
+    fitness_metric: used to sort optimization results in descending order
+    datafeed: smart pointer to DataFeed object
+    budget: total number of backtests
+    batch_size: number of backtests of each iteration
+*/
+
+void BTfast::run_surrogate_optimization( const param_ranges_t &parameter_ranges,
+                                         std::vector<strategy_t> &optim_results,
+                                         const std::string &optim_file,
+                                         const std::string &paramfile,
+                                         const std::string &fitness_metric,
+                                         std::unique_ptr<DataFeed> &datafeed,
+                                         int budget, int batch_size )
+{
+    // Max number of candidates scored at each iteration
+    const size_t max_pool {20000};
+
+    if( budget < 1 || batch_size < 1 ){
+        std::cout << ">>> ERROR: SURROGATE_BUDGET and SURROGATE_BATCH must "
+                  << "be at least 1 (run_surrogate_optimization).\n";
+        exit(1);
+    }
+    // Name of fitness metric in optimization results
+    std::string fitness_column { fitness_metric == "ProfitFactor"
+                                 ? "PftFactor" : fitness_metric };
+
+    // Parameters with a range (features of surrogate), and size of grid
+    size_t nparams { parameter_ranges.size() };
+    std::vector<size_t> dims {};
+    std::vector<int> sizes ( nparams );
+    double grid_size {1.0};
+    for( size_t i = 0; i < nparams; i++ ){
+        sizes[i] = (int) parameter_ranges[i].second.size();
+        grid_size *= sizes[i];
+        if( sizes[i] > 1 ){
+            dims.push_back(i);
+        }
+    }
+    size_t max_samples { grid_size < 1e18 ? (size_t) grid_size : (size_t) 1e18 };
+    size_t total { std::min( (size_t) budget, max_samples ) };
+
+    std::cout << "Grid size: " << grid_size << " combinations. "
+              << "Budget: " << total << " backtests\n";
+
+    // Random stream of candidate pools (reproducible with RANDOM_SEED)
+    utils_random::RandomStream rng { utils_random::global_seed(),
+                                     utils_random::sampling_domain, 0, 0 };
+
+    // Positions in grid of combinations already evaluated (or in batch)
+    std::unordered_set<std::vector<int>, ParamValuesHash> drawn {};
+    std::vector<parameters_t> batch {};
+    // Training set of surrogate: features and fitness of evaluated ones
+    std::vector<std::vector<double>> features {};
+    std::vector<double> fitness {};
+    std::vector<std::vector<int>> evaluated_index {};
+
+    auto draw = [&]( const std::vector<int> &index ){
+        if( drawn.insert( index ).second ){
+            batch.push_back( utils_params::parameters_from_indices(
+                                                parameter_ranges, index ) );
+        }
+    };
+    // Features of grid position: positions of parameters with a range
+    auto to_features = [&]( const std::vector<int> &index ){
+        std::vector<double> f ( dims.size() );
+        for( size_t k = 0; k < dims.size(); k++ ){
+            f[k] = index[dims[k]];
+        }
+        return(f);
+    };
+    // Evaluate batch (in parallel), add results to training set
+    auto evaluate = [&]( const std::string &stage ){
+        std::cout << utils_time::current_datetime_str() + " | "
+                  << stage << ": evaluating " << batch.size()
+                  << " combinations\n";
+        std::vector<strategy_t> results {};
+        run_parallel_optimization( batch, results, "", "",
+                                   fitness_metric, datafeed, false, false );
+        for( const strategy_t &strategy: results ){
+            parameters_t params {};
+            utils_params::extract_parameters_from_single_strategy( strategy,
+                                                                   params );
+            std::vector<int> index { utils_params::indices_from_parameters(
+                                                parameter_ranges, params ) };
+            features.push_back( to_features( index ) );
+            fitness.push_back( utils_params::strategy_attribute_by_name(
+                                                fitness_column, strategy ) );
+            evaluated_index.push_back( index );
+            optim_results.push_back( strategy );
+        }
+        batch.clear();
+    };
+    // Grid position of point 'u' in [0,1)^dims
+    auto to_index = [&]( const std::vector<double> &u ){
+        std::vector<int> index ( nparams, 0 );
+        for( size_t k = 0; k < dims.size(); k++ ){
+            index[dims[k]] = std::min( sizes[dims[k]] - 1,
+                                       (int) ( u[k] * sizes[dims[k]] ) );
+        }
+        return(index);
+    };
+
+    //-- Initial design (space-filling sample)
+    size_t initial { std::min( total, std::max( (size_t) batch_size,
+                                                total / 4 ) ) };
+    if( dims.size() <= utils_random::SobolSequence::max_dims ){
+        utils_random::SobolSequence sequence { dims.size(), &rng };
+        std::vector<double> u {};
+        for( size_t i = 0; i < 4 * initial && drawn.size() < initial; i++ ){
+            sequence.next( u );
+            draw( to_index( u ) );
+        }
+    }
+    else{
+        for( const std::vector<double> &u:
+                utils_random::latin_hypercube( initial, dims.size(), rng ) ){
+            draw( to_index( u ) );
+        }
+    }
+    evaluate( "Initial design" );
+
+    //-- Surrogate-guided iterations
+    RandomForest forest {};
+    int iteration {0};
+    while( drawn.size() < total ){
+
+        iteration++;
+        forest.fit( features, fitness, iteration );
+        double best { *std::max_element( fitness.begin(), fitness.end() ) };
+
+        // Candidate pool
+        std::vector<std::vector<int>> pool {};
+        if( grid_size <= max_pool ){
+            // all combinations not evaluated (odometer over grid)
+            std::vector<int> index ( nparams, 0 );
+            bool done {false};
+            while( !done ){
+                if( drawn.count( index ) == 0 ){
+                    pool.push_back( index );
+                }
+                done = true;
+                for( size_t i = 0; i < nparams; i++ ){
+                    if( ++index[i] < sizes[i] ){
+                        done = false;
+                        break;
+                    }
+                    index[i] = 0;
+                }
+            }
+        }
+        else{
+            // best combinations evaluated so far
+            std::vector<size_t> order ( fitness.size() );
+            std::iota( order.begin(), order.end(), 0 );
+            size_t num_best { std::min( order.size(), (size_t) 10 ) };
+            std::partial_sort( order.begin(), order.begin() + num_best,
+                               order.end(), [&fitness]( size_t a, size_t b ){
+                                   return( fitness[a] > fitness[b] );
+                               } );
+            for( size_t i = 0; i < max_pool; i++ ){
+                std::vector<int> index ( nparams, 0 );
+                if( i % 2 == 0 ){
+                    for( size_t d: dims ){
+                        index[d] = utils_random::uniform_int( rng, 0,
+                                                              sizes[d] - 1 );
+                    }
+                }
+                else{
+                    index = evaluated_index[ order[ (i / 2) % num_best ] ];
+                    for( size_t d: dims ){
+                        int radius { std::max( 1, sizes[d] / 8 ) };
+                        index[d] = std::min( sizes[d] - 1, std::max( 0,
+                                    index[d] + utils_random::uniform_int( rng,
+                                                        -radius, radius ) ) );
+                    }
+                }
+                if( drawn.count( index ) == 0 ){
+                    pool.push_back( index );
+                }
+            }
+        }
+        if( pool.empty() ){
+            break;
+        }
+
+        // Expected improvement of each candidate (in parallel)
+        std::vector<double> ei ( pool.size() );
+        #pragma omp parallel for
+        for( size_t i = 0; i < pool.size(); i++ ){
+            double mu {0.0};
+            double sigma {0.0};
+            forest.predict( to_features( pool[i] ), mu, sigma );
+            double improvement { mu - best };
+            if( sigma < 1e-12 ){
+                ei[i] = std::max( 0.0, improvement );
+                continue;
+            }
+            double z { improvement / sigma };
+            double cdf { 0.5 * std::erfc( -z / std::sqrt(2.0) ) };
+            double pdf { std::exp( -0.5 * z * z ) / std::sqrt( 2.0 * M_PI ) };
+            ei[i] = improvement * cdf + sigma * pdf;
+        }
+
+        // Batch: candidates with largest EI
+        size_t q { std::min( { (size_t) batch_size, total - drawn.size(),
+                               pool.size() } ) };
+        std::vector<size_t> order ( pool.size() );
+        std::iota( order.begin(), order.end(), 0 );
+        std::partial_sort( order.begin(), order.begin() + q, order.end(),
+                           [&ei]( size_t a, size_t b ){
+                               return( ei[a] > ei[b] );
+                           } );
+        for( size_t i = 0; i < q; i++ ){
+            draw( pool[order[i]] );
+        }
+        if( batch.empty() ){
+            break;
+        }
+        evaluate( "Iteration " + std::to_string(iteration)
+                  + " (best fitness " + std::to_string(best) + ")" );
+    }
+
+    std::cout << "Surrogate optimization Done. Evaluated "
+              << optim_results.size() << " / " << grid_size
+              << " combinations\n";
+
+    // Sort in descending order of fitness_metric
+    utils_optim::sort_by_metric( optim_results, fitness_metric );
+
+    // Write optimization results to file 'optim_file'
+    // (counters/dates of parsed data set by run_parallel_optimization)
+    int control = utils_fileio::write_strategies_to_file(
+                                            optim_file, paramfile,
+                                            optim_results, strategy_name_,
+                                            symbol_.name(), timeframe_,
+                                            first_date_parsed_,
+                                            last_date_parsed_, true );
+    if( control == 1 ){
+        std::cout << "\nOptimization results written on file: "
+                  << optim_file <<"\n";
+    }
+}
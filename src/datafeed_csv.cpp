@@ -6,6 +6,36 @@
 
 
 
+namespace {
+
+    // --------------------------------------------------------------------- //
+    /*! Parse date at the beginning of a line of CSV file in 'csv_format'.
+        Return false if not valid
+    */
+    bool parse_date( const char *line, int csv_format, Date &date )
+    {
+        int y {0}, m {0}, d {0};
+        int nread {0};
+        switch( csv_format ){
+            case 1:         // MM/DD/YYYY,...
+            case 2:
+                nread = sscanf(line, "%2d/%2d/%4d", &m, &d, &y);
+                break;
+            case 3:         // YYYY-MM-DD,...
+                nread = sscanf(line, "%4d-%2d-%2d", &y, &m, &d);
+                break;
+            default:
+                break;
+        }
+        if( nread != 3 ){
+            return(false);
+        }
+        date = Date {y, m, d};
+        return(true);
+    }
+}
+
+
 // ------------------------------------------------------------------------- //
 /*! Constructor
 */
@@ -161,9 +191,12 @@ void HistoricalBarsCSV::stream_next_bar()
 
 
         // select date range
+        // (bars are in chronological order: stop after end date)
         DateTime timestamp {y,m,d,hh,mm};
-        if( timestamp.date() >= start_date_
-            && timestamp.date() <= end_date_ ){
+        if( timestamp.date() > end_date_ ){
+            continue_parsing_ = false;
+        }
+        else if( timestamp.date() >= start_date_ ){
             // create new bar event
             Event new_bar { symbol_, timestamp, timeframe_,
                             op, hi, lo, cl, volume };
@@ -178,6 +211,67 @@ void HistoricalBarsCSV::stream_next_bar()
 }
 
 
+// ------------------------------------------------------------------------- //
+/*! Date of first bar in date range: date of first data line of the CSV
+    file, or start date if later
+*/
+Date HistoricalBarsCSV::first_date() const
+{
+    FILE *f { fopen(data_file_path_.c_str(), "r") };
+    if( f == NULL ){
+        return(start_date_);
+    }
+    char buffer[200] {};
+    fscanf(f, "%*[^\n]\n");            // skip first line
+    char *line { fgets(buffer, 200, f) };
+    fclose(f);
+
+    Date first {};
+    if( line == NULL || !parse_date( buffer, csv_format_, first ) ){
+        return(start_date_);
+    }
+    return( first > start_date_ ? first : start_date_ );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Date of last bar in date range: date of last line of the CSV file
+    (read from the end of file, without parsing it), or end date
+    if earlier
+*/
+Date HistoricalBarsCSV::last_date() const
+{
+    FILE *f { fopen(data_file_path_.c_str(), "r") };
+    if( f == NULL ){
+        return(end_date_);
+    }
+    // read last 200 chars of file (more than 1 line)
+    char buffer[201] {};
+    fseek(f, 0, SEEK_END);
+    long size { ftell(f) };
+    long offset { size > 200 ? size - 200 : 0 };
+    fseek(f, offset, SEEK_SET);
+    size_t n { fread(buffer, 1, 200, f) };
+    fclose(f);
+    buffer[n] = '\0';
+
+    // start of last non-empty line
+    int i { (int) n - 1 };
+    while( i >= 0 && (buffer[i] == '\n' || buffer[i] == '\r') ){
+        i--;
+    }
+    while( i >= 0 && buffer[i] != '\n' ){
+        i--;
+    }
+
+    Date last {};
+    if( !parse_date( buffer + i + 1, csv_format_, last ) ){
+        return(end_date_);
+    }
+    return( last < end_date_ ? last : end_date_ );
+}
+
+
 // ------------------------------------------------------------------------- //
 /*! Clone object and wrap it into unique ptr
 */
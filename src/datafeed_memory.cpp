@@ -0,0 +1,308 @@
+#include "datafeed_memory.h"
+
+#include "utils_random.h"   // bulk_bar_noise, add_gaussian_noise
+
+#include <cstdio>       // printf
+#include <iostream>     // std::cout
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor: stream 'series', described as datafeed 'source'
+*/
+HistoricalBarsMemory::HistoricalBarsMemory(
+                                    const DataFeed &source,
+                                    std::shared_ptr<const BarSeries> series,
+                                    bool random_noise, uint64_t run_index )
+: DataFeed{ source.symbol(), source.timeframe() },
+  series_{series},
+  type_{source.type()}, data_file_{source.data_file()},
+  data_file_path_{source.data_file_path()},
+  csv_format_{source.csv_format()},
+  start_date_{source.start_date()}, end_date_{source.end_date()},
+  random_noise_{random_noise}, run_index_{run_index}
+{
+    if( series_ == nullptr ){
+        std::cout << ">>> ERROR: null bar series (HistoricalBarsMemory).\n";
+        exit(1);
+    }
+    end_ = series_->size();
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Stream only bars with date in [first, last] (bars are in time order)
+*/
+void HistoricalBarsMemory::set_window( const Date &first, const Date &last )
+{
+    const std::vector<DateTime> &t { series_->timestamps };
+    begin_ = 0;
+    while( begin_ < t.size() && t[begin_].date() < first ){
+        begin_++;
+    }
+    end_ = begin_;
+    while( end_ < t.size() && t[end_].date() <= last ){
+        end_++;
+    }
+    start_date_ = first;
+    end_date_ = last;
+    reset_cursor();
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! The bars in memory are those of the source data file: changing file
+    would stream them under another name (and cache key).
+    Take a new datafeed from BarSeriesPool instead.
+*/
+void HistoricalBarsMemory::set_data_file( std::string f )
+{
+    std::cout << ">>> ERROR: cannot change data file of in-memory datafeed "
+              << "from " << data_file_path_ << " to " << f
+              << " (HistoricalBarsMemory).\n";
+    exit(1);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Open connection: generate noise of all bars in bulk (if requested)
+*/
+void HistoricalBarsMemory::open_data_connection()
+{
+    if( random_noise_ ){
+        noise_z_.resize( series_->size() );
+        noise_field_.resize( series_->size() );
+        utils_random::bulk_bar_noise( run_index_, series_->size(),
+                                      noise_z_.data(), noise_field_.data() );
+    }
+    reset_cursor();
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Close connection: release noise buffers
+*/
+void HistoricalBarsMemory::close_data_connection()
+{
+    noise_z_ = std::vector<double> {};
+    noise_field_ = std::vector<uint8_t> {};
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Reset cursor to first bar.
+    Reset continue_parsing_ to true.
+*/
+void HistoricalBarsMemory::reset_cursor()
+{
+    cursor_ = begin_;
+    continue_parsing_ = true;
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Get next bar from memory, until all bars are streamed
+*/
+void HistoricalBarsMemory::stream_next_bar()
+{
+    if( cursor_ < end_ ){
+        const BarSeries &s { *series_ };
+        Event new_bar { symbol_, s.timestamps[cursor_], timeframe_,
+                        s.open[cursor_], s.high[cursor_],
+                        s.low[cursor_], s.close[cursor_], s.volume[cursor_] };
+        if( random_noise_ ){
+            utils_random::add_gaussian_noise( new_bar, noise_z_[cursor_],
+                                              noise_field_[cursor_] );
+        }
+        // put bar event on events queue
+        events_queue_->push_back( new_bar );
+        cursor_++;
+    }
+    else{                                   // end of series
+        continue_parsing_ = false;
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Date of first bar of the series (of the window)
+*/
+Date HistoricalBarsMemory::first_date() const
+{
+    if( begin_ >= end_ ){
+        return(start_date_);
+    }
+    return( series_->timestamps[begin_].date() );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Date of last bar of the series (of the window)
+*/
+Date HistoricalBarsMemory::last_date() const
+{
+    if( begin_ >= end_ ){
+        return(end_date_);
+    }
+    return( series_->timestamps[end_-1].date() );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Clone object and wrap it into unique ptr (the series is shared)
+*/
+std::unique_ptr<DataFeed> HistoricalBarsMemory::clone() const
+{
+    return( std::make_unique<HistoricalBarsMemory>(*this) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Parse all bars of 'datafeed' (on a copy) into a new BarSeries
+*/
+std::shared_ptr<const BarSeries> load_bar_series( const DataFeed &datafeed )
+{
+    std::unique_ptr<DataFeed> feed { datafeed.clone() };
+    std::deque<Event> events_queue {};
+    auto series = std::make_shared<BarSeries>();
+
+    feed->set_events_queue( &events_queue );
+    feed->open_data_connection();
+    while( feed->continue_parsing() ){
+        feed->stream_next_bar();
+        while( !events_queue.empty() ){
+            const Event &bar { events_queue.front() };
+            series->timestamps.push_back( bar.timestamp() );
+            series->open.push_back( bar.open() );
+            series->high.push_back( bar.high() );
+            series->low.push_back( bar.low() );
+            series->close.push_back( bar.close() );
+            series->volume.push_back( bar.volume() );
+            events_queue.pop_front();
+        }
+    }
+    feed->close_data_connection();
+
+    return( series );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor: pool with max memory 'memory_budget' bytes (0: no limit)
+*/
+BarSeriesPool::BarSeriesPool( size_t memory_budget )
+: memory_budget_{memory_budget}
+{}
+
+
+// ------------------------------------------------------------------------- //
+/*! Series of 'datafeed': taken from the pool if already parsed, otherwise
+    parsed from file and added to the pool (releasing least recently used
+    series if the memory budget is exceeded)
+*/
+std::shared_ptr<const BarSeries> BarSeriesPool::get( const DataFeed &datafeed )
+{
+    clock_++;
+    std::string k { key(datafeed) };
+    auto it = entries_.find( k );
+    if( it != entries_.end() ){
+        hits_++;
+        it->second.last_use = clock_;
+        return( it->second.series );
+    }
+    loads_++;
+    Entry entry {};
+    entry.series = load_bar_series( datafeed );
+    entry.bytes = memory_size( *entry.series );
+    entry.last_use = clock_;
+    entries_.emplace( k, entry );
+    evict();
+    return( entry.series );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Release least recently used series which are not in use (owned only by
+    the pool), until memory of the pool is within memory_budget_
+*/
+void BarSeriesPool::evict()
+{
+    while( memory_budget_ > 0 && memory_used() > memory_budget_ ){
+        auto lru = entries_.end();
+        for( auto it = entries_.begin(); it != entries_.end(); it++ ){
+            if( it->second.series.use_count() == 1
+                && ( lru == entries_.end()
+                     || it->second.last_use < lru->second.last_use ) ){
+                lru = it;
+            }
+        }
+        if( lru == entries_.end() ){
+            break;                          // all series in use
+        }
+        entries_.erase( lru );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Release all series not in use
+*/
+void BarSeriesPool::clear()
+{
+    for( auto it = entries_.begin(); it != entries_.end(); ){
+        if( it->second.series.use_count() == 1 ){
+            it = entries_.erase( it );
+        }
+        else{
+            it++;
+        }
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Memory of series in the pool, in bytes
+*/
+size_t BarSeriesPool::memory_used() const
+{
+    size_t bytes {0};
+    for( const auto& e: entries_ ){
+        bytes += e.second.bytes;
+    }
+    return(bytes);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Print number of series parsed and reused, and memory in use
+*/
+void BarSeriesPool::print_statistics() const
+{
+    printf( "\nBar series: %d parsed, %d reused, %.1f MB in memory\n",
+            loads_, hits_, memory_used() / (1024.0 * 1024.0) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Key of series of 'datafeed': data file, format, symbol, timeframe, dates
+*/
+std::string BarSeriesPool::key( const DataFeed &datafeed )
+{
+    return( datafeed.type() + "|" + datafeed.data_file_path() + "|"
+            + std::to_string( datafeed.csv_format() ) + "|"
+            + datafeed.symbol().name() + "|" + datafeed.timeframe() + "|"
+            + datafeed.start_date().tostring() + "|"
+            + datafeed.end_date().tostring() );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Approximate memory of 'series' (column buffers), in bytes
+*/
+size_t BarSeriesPool::memory_size( const BarSeries &series )
+{
+    return( series.timestamps.capacity() * sizeof(DateTime)
+            + ( series.open.capacity() + series.high.capacity()
+                + series.low.capacity() + series.close.capacity() )
+              * sizeof(double)
+            + series.volume.capacity() * sizeof(int) );
+}
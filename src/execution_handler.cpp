@@ -36,9 +36,10 @@ void ExecutionHandler::set_events_queue(std::deque<Event> *events_queue)
    assign unique_ptr to that object.
 */
 void select_execution( std::unique_ptr<ExecutionHandler>& execution_ptr,
-                        bool include_commissions, int slippage )
+                        bool include_commissions, int slippage,
+                        uint64_t run_index )
 {
 
     execution_ptr = std::make_unique<SimulatedExecution>(include_commissions,
-                                                         slippage);
+                                                         slippage, run_index);
 }
@@ -1,6 +1,6 @@
 #include "execution_handler_sim.h"
 
-#include "utils_random.h"   // rand_generator
+#include "utils_random.h"   // uniform_int
 
 #include <iostream>         // std::cout
 
@@ -10,11 +10,13 @@
 */
 
 SimulatedExecution::SimulatedExecution( bool include_commissions,
-                                        int slippage)
+                                        int slippage, uint64_t run_index )
 
 : ExecutionHandler{},
   include_commissions_{include_commissions},
-  slippage_{slippage}
+  slippage_{slippage},
+  rng_{ utils_random::global_seed(), utils_random::execution_domain,
+        run_index, 0 }
 {}
 
 
@@ -30,8 +32,7 @@ void SimulatedExecution::on_order( const Event &order ) const
     // Entry order
     if( order.action() == "BUY" || order.action() == "SELLSHORT" ){
         // random integer (simulate broker assignment)
-        std::uniform_int_distribution<> distr1(1,10000);
-        ticket = distr1(utils_random::rand_generator);
+        ticket = utils_random::uniform_int( rng_, 1, 10000 );
     }
     // Exit order
     else if( order.action() == "SELL" || order.action() == "BUYTOCOVER" ){
@@ -60,8 +61,7 @@ void SimulatedExecution::on_order( const Event &order ) const
     // price offset wrt to ideal order price (can be positive or negative)
     double slipped_price {0};
     if( slippage_ > 0 ){
-        std::uniform_int_distribution<> distr2(-slippage_, slippage_);
-        slipped_price = distr2(utils_random::rand_generator)
+        slipped_price = utils_random::uniform_int( rng_, -slippage_, slippage_ )
                         * order.symbol().tick_size();
     }
     // round-turn commission cost by broker
@@ -1,15 +1,40 @@
 #include "genetic.h"
 
 #include "utils_optim.h" // append_to_optim_results
-#include "utils_random.h" // rand_generator
+#include "utils_params.h" // canonical_parameters
+#include "utils_random.h" // RandomStream, uniform01, uniform_int, shuffle
 //#include "utils_time.h"
-#include <algorithm>    // std::sort, std::shuffle, std::min_element, std::max_element
+#include <algorithm>    // std::sort, std::min_element, std::max_element
 #include <functional>   // std::bind, std::placeholders
 #include <iostream>     // std::cout
 #include <numeric>      // std::accumulate
 #include <omp.h>        // openMP
 
 
+// ------------------------------------------------------------------------- //
+/*! Key of 'chromosome' in fitness memo: gene values of its canonical
+    representative
+*/
+std::vector<int> chromosome_key( const chromosome_t &chromosome,
+                                 const param_deps_t &deps )
+{
+    std::vector<int> key {};
+    key.reserve( chromosome.size() );
+    if( deps.empty() ){
+        for( const auto& gene: chromosome ){
+            key.push_back( gene.second );
+        }
+    }
+    else{
+        for( const auto& gene: utils_params::canonical_parameters( chromosome,
+                                                                   deps ) ){
+            key.push_back( gene.second );
+        }
+    }
+    return(key);
+}
+
+
 // ------------------------------------------------------------------------- //
 /*! Constructor
 */
@@ -21,7 +46,7 @@ Individual::Individual(chromosome_t chromosome)
 // ------------------------------------------------------------------------- //
 /*! String representation of chromosomes
 */
-std::string Individual::tostring()
+std::string Individual::tostring() const
 {
     std::string result{"{"};
     for(auto gene : chromosome_ ){
@@ -43,7 +68,7 @@ bool operator<(const Individual &ind1, const Individual &ind2)
 // ------------------------------------------------------------------------- //
 /*! Calculate fittness score of single individual
    and assign it to fitness_ member variable.
-   Append performance+parameters to 'optim_results'.
+   Store performance metrics into 'record'.
 
    Names/Number/Order of performance metrics must be matched among:
        - utils_params::extract_parameters_from_single_strategy
@@ -59,60 +84,46 @@ bool operator<(const Individual &ind1, const Individual &ind2)
        - mode_factory_sequential (run_modes)
 
 */
-void Individual::compute_individual_fitness(BTfast &btf,
+void Individual::compute_individual_fitness(const BTfast &btf,
                                         std::unique_ptr<DataFeed> &datafeed,
                                         std::string metric,
-                                        std::vector<strategy_t> &optim_results )
+                                        BacktestRecord &record )
 {
-    // Initialize Account
-    Account account { btf.initial_balance() };
-
     // Run backtest (passing strategy parameters of current individual)
-    btf.run_backtest( account, datafeed, this->chromosome() );
-
-    // Initialize Performance object
-    Performance performance { btf.initial_balance(),
-                              std::vector<Transaction> {} };
-    // Load transaction history into performance object
-    performance.set_transactions( account.transactions() );
-    // Compute performance metrics
-    performance.compute_metrics();
+    // and compute performance metrics (or take them from cache).
+    // Only metrics of optimization results (including fitness) are computed
+    btf.run_cached_backtest( record, BacktestRequest { datafeed.get(),
+                                                       this->chromosome(),
+                                                       false, false, 0,
+                                                       false, metric_optim } );
 
     // Set fitness according to input fitness metric
     //if( metric == "NetPL" ){
-    //    fitness_ = performance.netpl();
+    //    fitness_ = record.netpl;
     //}
     if( metric == "AvgTicks" ){
-        fitness_ = performance.avgticks();
+        fitness_ = record.avgticks;
     }
     else if( metric == "WinPerc" ){
-        fitness_ = performance.winperc();
+        fitness_ = record.winperc;
     }
     //else if( metric == "AvgTrade" ){
-    //    fitness_ = performance.avgtrade();
+    //    fitness_ = record.avgtrade;
     //}
     else if( metric == "ProfitFactor" ){
-        fitness_ = performance.profitfactor();
+        fitness_ = record.profitfactor;
     }
     else if( metric == "NP/MDD" ){
-        fitness_ = performance.npmdd();
+        fitness_ = record.npmdd;
     }
     else if( metric == "Expectancy" ){
-        fitness_ = performance.expectancy();
+        fitness_ = record.expectancy;
     }
     else if( metric == "Z-score" ){
-        fitness_ = performance.zscore();
+        fitness_ = record.zscore;
     }
     else{   // default: AvgTicks
-        fitness_ = performance.avgticks();
-    }
-
-    // Append performance metrics and parameter combination (chromosome)
-    // to optimization results
-    #pragma omp critical
-    {
-        utils_optim::append_to_optim_results(optim_results, performance,
-                                             chromosome_);
+        fitness_ = record.avgticks;
     }
 };
 
@@ -120,19 +131,18 @@ void Individual::compute_individual_fitness(BTfast &btf,
 // ------------------------------------------------------------------------- //
 /*! Perform single-point crossover of two parents (-> 2 offsprings)
 */
-void Individual::single_crossover(Individual &parent2, double crossover_rate )
+void Individual::single_crossover(Individual &parent2, double crossover_rate,
+                                  utils_random::RandomStream &rng )
 {
     Individual offspring1 {*this};
     Individual offspring2 {parent2};
     int genes_num { static_cast<int>(chromosome_.size()) };
 
-    std::uniform_int_distribution<> rand_int {0, genes_num-1};
-    std::uniform_real_distribution<> rand01 {0.0,1.0};
-    double p = rand01(utils_random::rand_generator);  // random real in [0,1]
+    double p = utils_random::uniform01(rng);  // random real in [0,1]
 
     if( p < crossover_rate ){
         // index point after which to crossover chromosomes
-        int r = rand_int(utils_random::rand_generator); // random int in [0,1]
+        int r = utils_random::uniform_int(rng, 0, genes_num-1);
 
         // Swap genes after crossover point
         for(int i = r; i < genes_num; i++){
@@ -146,13 +156,12 @@ void Individual::single_crossover(Individual &parent2, double crossover_rate )
 // ------------------------------------------------------------------------- //
 /*! Perform uniform crossover of two parents (-> 1 offspring (this) )
 */
-void Individual::uniform_crossover(Individual &parent2)
+void Individual::uniform_crossover(Individual &parent2,
+                                   utils_random::RandomStream &rng )
 {
-    std::uniform_int_distribution<> rand_int {0,1};
-
     for(int i = 0; i < chromosome_.size(); i++){
 
-        int r { rand_int(utils_random::rand_generator) };// random int in [0,1]
+        int r { utils_random::uniform_int(rng, 0, 1) };// random int in [0,1]
         if( r == 1 ){
             // insert gene from parent 2
             this->set_chromosome(i, parent2.chromosome()[i] );
@@ -165,26 +174,24 @@ void Individual::uniform_crossover(Individual &parent2)
 // ------------------------------------------------------------------------- //
 /*! Mutate a random gene in this individual
 */
-void Individual::mutate( const std::vector<chromosome_t> &search_space )
+void Individual::mutate( const std::vector<chromosome_t> &search_space,
+                         utils_random::RandomStream &rng )
 {
     int genes_num  { static_cast<int>(chromosome_.size()) };
     int param_size { static_cast<int>(search_space.size()) };
 
-    std::uniform_int_distribution<> rand_int_1 (0, genes_num-1);
-    std::uniform_int_distribution<> rand_int_2 (0, param_size-1);
-
     // random integer in [0, chromosome.size-1 )
-    int r1 { rand_int_1(utils_random::rand_generator) };
+    int r1 { utils_random::uniform_int(rng, 0, genes_num-1) };
     // random integer in [0, search_space.size-1 )
-    int r2 { rand_int_2(utils_random::rand_generator) };
+    int r2 { utils_random::uniform_int(rng, 0, param_size-1) };
 
     int mutation_trials {0};
     // enforce that the gene mutates to different value
     // (at most 2*genes_num trials)
     while( chromosome_[r1] == search_space[r2][r1]
             && mutation_trials < 2*genes_num ){
-        r1 = rand_int_1(utils_random::rand_generator);
-        r2 = rand_int_2(utils_random::rand_generator);
+        r1 = utils_random::uniform_int(rng, 0, genes_num-1);
+        r2 = utils_random::uniform_int(rng, 0, param_size-1);
         mutation_trials++;
     }
     chromosome_[r1] = search_space[r2][r1];
@@ -204,22 +211,30 @@ void Individual::mutate( const std::vector<chromosome_t> &search_space )
 // ------------------------------------------------------------------------- //
 /*! Constructor
 */
-Population::Population( int population_size, std::string fitness_metric )
-: population_size_{population_size}, fitness_metric_{fitness_metric}
-{}
+Population::Population( int population_size, std::string fitness_metric,
+                        std::string selection )
+: population_size_{population_size}, fitness_metric_{fitness_metric},
+  selection_{selection}
+{
+    if( selection_ != "tournament" && selection_ != "roulette" ){
+        std::cout<<">>>ERROR: invalid selection method " << selection_
+                 <<" (genetic).\n";
+        exit(1);
+    }
+}
 
 
 // ------------------------------------------------------------------------- //
 /*! Fill 'population_' vector by random sampling 'population_size_' elements
   (without replacement) from whole parameter space 'search_space'
 */
-void Population::initialize_population(std::vector<chromosome_t> &search_space)
+void Population::initialize_population(std::vector<chromosome_t> &search_space,
+                                       utils_random::RandomStream &rng )
 {
     total_fitness_ = 0;
 
     // Shuffle the search space
-    std::shuffle( search_space.begin(), search_space.end(),
-                  utils_random::rand_generator );
+    utils_random::shuffle( search_space, rng );
 
     // Get the first 'population_size_' values
     std::vector<chromosome_t> population_chromosomes{
@@ -242,9 +257,9 @@ void Population::initialize_population(std::vector<chromosome_t> &search_space)
 // ------------------------------------------------------------------------- //
 /*! Print name and value of all chromosome in population's individuals.
 */
-void Population::print_population()
+void Population::print_population() const
 {
-    for(Individual indiv: population_){
+    for( const Individual &indiv: population_ ){
         std::cout<< "Fitness = " << indiv.fitness()
                  << ", Prob = "<< indiv.probability()
                  << " " << indiv.tostring() <<"\n";
@@ -275,15 +290,9 @@ void Population::sort()
 void Population::set_total_fitness()
 {
     total_fitness_ = 0.0;
-    for( Individual indiv: population_ ){
+    for( const Individual &indiv: population_ ){
         total_fitness_ += indiv.fitness();
     }
-
-    if( total_fitness_ == 0 ){
-        std::cout<<">>>ERROR: population fitness = 0. No trades generated."
-                 <<" (genetic).\n";
-        exit(1);
-    }
 }
 
 // ------------------------------------------------------------------------- //
@@ -306,6 +315,11 @@ void Population::set_probabilities()
                                             fitness_vec.end()) };
     double max_fitness { *std::max_element( fitness_vec.begin(),
                                             fitness_vec.end()) };
+    if( max_fitness == 0.0 && min_fitness == 0.0 ){
+        std::cout<<">>>ERROR: population fitness = 0. No trades generated."
+                 <<" (genetic).\n";
+        exit(1);
+    }
     if( (max_fitness-min_fitness) == 0.0 ){
         std::cout<<">>>ERROR: max fitness = min fitness (genetic). \n";
         exit(1);
@@ -337,6 +351,38 @@ void Population::set_probabilities()
         indiv.set_probability( prob.at(indiv_count) );
         indiv_count++;
     }
+
+    // Alias table (Vose's method): column i keeps individual i with
+    // probability alias_prob_[i], otherwise gives alias_index_[i]
+    int n { (int) prob.size() };
+    alias_prob_.assign( n, 1.0 );
+    alias_index_.resize( n );
+    std::vector<double> scaled ( n );
+    std::vector<int> small {};
+    std::vector<int> large {};
+    for( int i = 0; i < n; i++ ){
+        alias_index_[i] = i;
+        scaled[i] = prob[i] * n;
+        if( scaled[i] < 1.0 ){
+            small.push_back(i);
+        }
+        else{
+            large.push_back(i);
+        }
+    }
+    while( !small.empty() && !large.empty() ){
+        int s { small.back() };
+        small.pop_back();
+        int l { large.back() };
+        alias_prob_[s] = scaled[s];
+        alias_index_[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if( scaled[l] < 1.0 ){
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // remaining columns (rounding errors) keep their individual
 }
 
 // ------------------------------------------------------------------------- //
@@ -344,65 +390,201 @@ void Population::set_probabilities()
     set probability for all individuals in population,
     sort population in decreasing order of fitness of its individuals.
     Append performance+parameters to 'optim_results'.
+
+    Chromosomes already in 'memo' (evaluated in previous generations,
+    or equivalent to one of them) are not evaluated again, and each new
+    chromosome is evaluated once (and appended to 'optim_results' once).
 */
-void Population::compute_population_fitness(BTfast &btf,
+void Population::compute_population_fitness(const BTfast &btf,
                                         std::unique_ptr<DataFeed> &datafeed,
-                                        std::vector<strategy_t> &optim_results)
+                                        std::vector<strategy_t> &optim_results,
+                                        fitness_memo_t &memo )
 {
-    //int indiv_count {0};
+    // Keys of individuals, and first individual of each new key
+    std::vector<std::vector<int>> keys ( population_.size() );
+    std::vector<size_t> new_individuals {};
+    for( size_t i = 0; i < population_.size(); i++ ){
+        keys[i] = chromosome_key( population_[i].chromosome(),
+                                  btf.param_dependencies() );
+        // mark new keys in memo (fitness set below)
+        if( memo.emplace( keys[i], 0.0 ).second ){
+            new_individuals.push_back(i);
+        }
+    }
 
-    // Compute fitness of each individual in population
-    #pragma omp parallel for
-    for(auto indiv = population_.begin(); indiv < population_.end(); ++indiv){
+    std::vector<BacktestRecord> records ( new_individuals.size() );
+
+    // Compute fitness of each new individual in population
+    #pragma omp parallel for schedule(dynamic)
+    for( size_t k = 0; k < new_individuals.size(); k++ ){
 
         // Make a copy of DataFeed object and wrap it into a new unique_ptr
         std::unique_ptr<DataFeed> datafeed_copy = datafeed.get()->clone();
 
-        indiv->compute_individual_fitness( btf, datafeed_copy,
-                                           fitness_metric_, optim_results );
-
-        /*
-        #pragma omp critical
-        {
-            indiv_count++;        // Increment count on individuals
-            std::cout << utils_time::current_datetime_str() + " | "
-                      << "(Parallel) Running backtest on individual "
-                      << indiv_count << " / " << population_.size()
-                      << "\t Fitness = " << indiv->fitness() << "\n";
-        }
-        */
+        population_[new_individuals[k]].compute_individual_fitness(
+                            btf, datafeed_copy, fitness_metric_, records[k] );
     }
 
-    // Compute total fitness of population
-    set_total_fitness();
-    // Assign probabilities to each individual in population
-    set_probabilities();
+    // Store fitness of new individuals into memo, and append their
+    // performance metrics and parameter combinations (chromosomes)
+    // to optimization results (in order of population)
+    for( size_t k = 0; k < new_individuals.size(); k++ ){
+        const Individual &indiv { population_[new_individuals[k]] };
+        memo[ keys[new_individuals[k]] ] = indiv.fitness();
+        utils_optim::append_to_optim_results( optim_results, records[k],
+                                              indiv.chromosome() );
+    }
+    // Fitness of all individuals from memo
+    for( size_t i = 0; i < population_.size(); i++ ){
+        population_[i].set_fitness( memo[ keys[i] ] );
+    }
 
     // Sort individuals in population in decreasing order of fitness
     sort();
+    // Update total fitness and selection probabilities
+    update_selection();
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Update total fitness of population, and probabilities of each
+    individual (alias table) for roulette selection
+*/
+void Population::update_selection()
+{
+    set_total_fitness();
+    if( selection_ == "roulette" ){
+        set_probabilities();
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Select an individual in population:
+    - "tournament": fittest of tournament_size_ random individuals
+    - "roulette": fitness-proportionate selection (alias method)
+*/
+const Individual& Population::select( utils_random::RandomStream &rng ) const
+{
+    int n { (int) population_.size() };
+    if( selection_ == "roulette" ){
+        int column { utils_random::uniform_int(rng, 0, n-1) };
+        double p = utils_random::uniform01(rng); // random real in [0,1]
+        if( p < alias_prob_[column] ){
+            return( population_[column] );
+        }
+        return( population_[ alias_index_[column] ] );
+    }
+    // Tournament (population is sorted: fittest has lowest index)
+    int best { utils_random::uniform_int(rng, 0, n-1) };
+    for( int i = 1; i < tournament_size_; i++ ){
+        int r { utils_random::uniform_int(rng, 0, n-1) };
+        if( r < best ){
+            best = r;
+        }
+    }
+    return( population_[best] );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! New individual from two (different) selected parents, by uniform
+    crossover and mutation (with probability 'mutation_rate')
+*/
+Individual Population::breed( const std::vector<chromosome_t> &search_space,
+                              double mutation_rate,
+                              utils_random::RandomStream &rng ) const
+{
+    Individual offspring { select(rng) };
+    const Individual *parent2 { &select(rng) };
+    int selection_trials {0};
+    // enforce that the parents are different (max population_size trials)
+    while( parent2->chromosome() == offspring.chromosome()
+           && selection_trials < population_size_ ){
+        parent2 = &select(rng);
+        selection_trials++;
+    }
+    Individual other { *parent2 };
+    offspring.uniform_crossover( other, rng );
+    if( utils_random::uniform01(rng) < mutation_rate ){
+        offspring.mutate( search_space, rng );
+    }
+    return(offspring);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Replace least fit individual with 'offspring' (evaluated), if fitter,
+    keeping the population sorted. Return true if replaced
+*/
+bool Population::replace_worst( const Individual &offspring )
+{
+    if( population_.empty()
+        || offspring.fitness() <= population_.back().fitness() ){
+        return(false);
+    }
+    population_.back() = offspring;
+    // move offspring up to its position
+    for( size_t i = population_.size() - 1;
+         i > 0 && population_[i].fitness() > population_[i-1].fitness(); i-- ){
+        std::swap( population_[i], population_[i-1] );
+    }
+    update_selection();
+    return(true);
 }
 
 
 // ------------------------------------------------------------------------- //
-/*! Select an individual in population using fitness-proportionate selection
-    (aka roulette wheel selection)
+/*! New population (not evaluated) from current one (evaluated and sorted):
+    the 'elite_num' fittest individuals pass unchanged, the others are
+    offspring of selected parents by uniform crossover, then mutated
+    with probability 'mutation_rate'
 */
-Individual Population::select()
+Population Population::next_generation(
+                                const std::vector<chromosome_t> &search_space,
+                                double mutation_rate, int elite_num,
+                                utils_random::RandomStream &rng ) const
 {
-    std::uniform_real_distribution<> rand01 {0.0,1.0};
-    double p = rand01(utils_random::rand_generator); // random real in [0,1]
-    double offset {0.0};
-    Individual pick{};
-
-    // Select individual according to its probability
-    for( Individual indiv: population_ ){
-        offset += indiv.probability();
-        if( p < offset ){
-            pick = indiv;
-            break;
+    Population new_population {population_size_, fitness_metric_, selection_};
+
+    // Elitism
+    // (the 'elite_num' fittest individuals pass unchanged to new generation)
+    for( int j = 0; j < elite_num; j++){
+        new_population.insert_individual( population_[j] );
+    }
+
+    while( new_population.population().size() < population_size_ ){
+
+        // Selection
+        Individual offspring1 { select(rng) };
+        const Individual *parent2 { &select(rng) };
+        int selection_trials {0};
+        // enforce that the parents are different (max population_size trials)
+        while( parent2->chromosome() == offspring1.chromosome()
+               && selection_trials < population_size_ ){
+            parent2 = &select(rng);
+            selection_trials++;
         }
+        Individual offspring2 { *parent2 };
+
+        // Crossover
+        /*
+        //- single crossover
+        offspring1.single_crossover( offspring2, crossover_rate, rng );
+        new_population.insert_individual( offspring1 );
+        new_population.insert_individual( offspring2 );
+        //-
+        */
+        //- uniform crossover
+        offspring1.uniform_crossover( offspring2, rng );
+        new_population.insert_individual( offspring1 );
+        //-
     }
-    return(pick);
+
+    // Mutation
+    new_population.mutate( search_space, mutation_rate, elite_num, rng );
+
+    return(new_population);
 }
 
 
@@ -412,18 +594,54 @@ Individual Population::select()
     with probability given by mutation_rate
 */
 void Population::mutate( const std::vector<chromosome_t> &search_space,
-                         double mutation_rate, int exclude_first )
+                         double mutation_rate, int exclude_first,
+                         utils_random::RandomStream &rng )
 {
-    std::uniform_real_distribution<> rand01 {0.0,1.0};
 
     // loop over individuals in population
     // (excluding first 'exclude_first' elements)
     for( auto indiv = population_.begin() + exclude_first;
               indiv != population_.end(); ++indiv){
 
-        double p { rand01(utils_random::rand_generator) }; // random real in [0,1]
+        double p { utils_random::uniform01(rng) }; // random real in [0,1]
         if( p < mutation_rate ){
-            indiv->mutate(search_space);
+            indiv->mutate(search_space, rng);
         }
     }
 }
+
+
+
+// ------------------------------------------------------------------------- //
+/*! Post 'migrants' into mailbox, if empty. Return false (migrants dropped)
+    if mailbox is full or being accessed by another thread
+*/
+bool Mailbox::post( const std::vector<Individual> &migrants )
+{
+    int expected {0};
+    if( !state_.compare_exchange_strong( expected, 1,
+                                         std::memory_order_acquire ) ){
+        return(false);
+    }
+    migrants_ = migrants;
+    state_.store( 2, std::memory_order_release );
+    return(true);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Move migrants from mailbox into 'migrants', if full. Return false
+    (nothing received) if mailbox is empty or being written
+*/
+bool Mailbox::collect( std::vector<Individual> &migrants )
+{
+    int expected {2};
+    if( !state_.compare_exchange_strong( expected, 3,
+                                         std::memory_order_acquire ) ){
+        return(false);
+    }
+    migrants = std::move( migrants_ );
+    migrants_.clear();
+    state_.store( 0, std::memory_order_release );
+    return(true);
+}
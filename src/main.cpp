@@ -67,19 +67,13 @@
 
    [- genetic programming ( create bool nodes like HighD[1] > LowD[5],
                           out of building blocks )]
-   [- does the call to append_to_optim_results (in run_parallel_optimization)
-       need #pragma omp critical (as in genetic) ?
-   ]
 
    [- multiple comparison, benjamini-hochberg]
-   [- genetic optim: avoid computing the fitness of the same strategy (individual)
-     multiple times]
     [- fix IS/OOS dates. define:
         initial_date_IS (=input_start_date), final_date_IS,
         initial_date_OOS1, final_date_OOS1,
         initial_date_OOS2 (=final_date_OOS1+1 bday), final_date_OOS2(=input_end_date)
     ]
-    [- Bootstrap to get standard error on performance metrics]
     [- replace OpenMP parallelization with C++17 for_each loop and
         execution policy: std::execution::par_unseq
         (currently: error when #including <execution> )]
@@ -98,31 +92,63 @@
  *****************************************************************************/
 
 #include "account.h"
+#include "backtest_cache.h" // BacktestCache
 #include "btfast.h"         // type aliases (parameters_t, strategy_t)
 #include "datafeed.h"
+#include "datafeed_memory.h" // BarSeriesPool, HistoricalBarsMemory
 #include "instruments.h"
 #include "run_modes.h"      // mode_notrade, mode_single_bt, mode_optimization,
-                            // mode_factory, mode_factory_sequential, mode_overview
+                            // mode_factory, mode_factory_sequential, mode_overview,
+                            // mode_noise, mode_bootstrap, mode_walkforward
 
 #include "utils_fileio.h"   // read_config_file, read_param_file, read_strategies_from_file
 //#include "utils_math.h"
 //#include "utils_optim.h"    //  append_to_optim_results
 //#include "utils_params.h"   // single_parameter_combination, cartesian_product
 #include "utils_print.h"    // print_header, print_footer, show_backtest_results
+#include "utils_random.h"   // set_global_seed
 #include "utils_time.h"     // actual_start_date, actual_end_date
 
 
+#include <algorithm>    // std::find
 #include <iostream>     // std::cout
 #include <chrono>       // std::chrono
+#include <cstdio>       // printf
+#include <map>          // std::map
 #include <memory>       // std::unique_ptr
 #include <string>       // std::string
+#include <vector>       // std::vector
+
+
+/*!
+Resources shared by all jobs of a batch (run mode 9), in one process.
+
+- series_pool: bar series parsed from data files (memory-aware)
+- caches: backtest caches, by cache directory and content
+- param_ranges, param_deps: parsed strategy XML files, by file name
+*/
+struct BatchResources {
+    BarSeriesPool series_pool {};
+    std::map<std::string, std::unique_ptr<BacktestCache>> caches {};
+    std::map<std::string, param_ranges_t> param_ranges {};
+    std::map<std::string, param_deps_t> param_deps {};
+};
+
+// Run all jobs of 'batch_file' (run mode 9)
+int run_batch( const std::string &config_file, const std::string &batch_file,
+               int batch_memory_mb );
 
 
 ///////////////////////////////////////////////////////////////////////////////
 /////////////////////////    BEGIN OF MAIN PROGRAM    /////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-int main () {
+// ------------------------------------------------------------------------- //
+/*! Run job with settings of 'config_file', overridden by 'overrides'.
+    Jobs of a batch share the resources in 'batch' (nullptr: single job).
+*/
+int run_job( const std::string &config_file,
+             const setting_overrides_t &overrides, BatchResources *batch ) {
 
     // -----------------------   INITIALIZATIONS   ------------------------- //
     //--- Main program variables
@@ -132,20 +158,31 @@ int main () {
     int csv_format {1};                     ///< Data format of CSV file
     int max_bars_back {100};                ///< Max number of bars to keep in history
     int slippage {0};                       ///< max number of slippage ticks
-    int population_size {100};              ///< Number of individuals in population (GA)
-    int generations {10};                   ///< Max number of generations (GA)
+    OptimizerSettings optimizer {};         ///< Settings of optimization algorithms (GA, halving, islands, ...)
     int num_contracts {1};                  ///< Number of contracts to use in "fixed-size" position size
     int max_variation_pct {30};             ///< Percentage of max variation for stability test
     int num_noise_tests {100};              ///< Number of noise tests
+    int validation_target {0};              ///< Stop validation after this number of validated strategies (0: no limit)
+    bool filter_mask {false};               ///< Evaluate entry filters as masks over trades (sequential factory)
+    bool combined_is_oos {false};           ///< Run IS and OOS backtests of validation as a single backtest
+    int factory_pruning {0};                ///< Pruning of strategy factory backtests (0: off, 1: bounds, 2: bounds + heuristics)
+    int wf_windows {5};                     ///< Number of out-of-sample windows (walk-forward)
+    int wf_is_ratio {4};                    ///< Length of in-sample windows / out-of-sample windows (walk-forward)
+    bool wf_anchored {false};               ///< In-sample windows start at first session (walk-forward)
+    int random_seed {0};                    ///< Seed of random streams (0: non-reproducible)
+    int backtest_cache {0};                 ///< Backtest cache (0: off, 1: metrics, 2: metrics + trades)
+    int bootstrap_resamples {10000};        ///< Number of resamples of trades (bootstrap)
+    int bootstrap_block_size {0};           ///< Trades per block in block bootstrap (0: automatic)
+    int batch_memory_mb {2048};             ///< Max memory of bar series shared by batch jobs, in MB (0: no limit)
     bool print_progress {true};             ///< Print backtest progress on stdout
     bool print_performance_report {false};  ///< Print perf report on stdout
     bool print_trade_list {false};          ///< Print list of trades on stdout
     bool write_trades_to_file {false};      ///< Write trade history to file and show plot
     bool include_commissions {false};       ///< Include or not commissions
+    bool ga_steady_state {false};           ///< Steady-state (asynchronous) evaluation (GA)
     double initial_balance {100000.0};      ///< Initial account balance
     double risk_fraction {0.1};             ///< Fraction to use in "fixed-fractional", "fixed-notional" position size
 
-    std::string config_file {"settings.xml"};   ///<< XML configuration file
     std::string strategy_name {""};             ///< Name of the strategy
     std::string symbol_name {""};               ///< Name of the symbol
     std::string timeframe {""};                 ///< Main Timeframe of the strategy
@@ -159,24 +196,38 @@ int main () {
     std::string data_file {""};                 ///< File containing data
     std::string data_file_oos {""};             ///< FIle containing out-of-sample data
     std::string position_size_type {""};        ///< Type of position size (money management)
+    std::string ga_selection {"roulette"};      ///< Selection method (GA)
+    std::string batch_file {"batch.xml"};       ///< XML file with jobs of batch (run mode 9)
     //--- End main program variables
 
-    // unbuffer output
-    // (to call command: './run > log.txt &' with live update of log file)
-    std::cout << std::unitbuf;
-
     // Read configuration settings from XML config_file
     utils_fileio::read_config_file(
                     config_file, main_dir, run_mode, strategy_name,
                     symbol_name, timeframe, input_start_date, input_end_date,
                     data_dir, data_file, csv_format, datafeed_type,
                     print_progress, print_performance_report, print_trade_list,
-                    write_trades_to_file, fitness_metric,
-                    population_size, generations,
+                    write_trades_to_file, fitness_metric, optimizer,
                     max_bars_back, initial_balance,
                     position_size_type, num_contracts, risk_fraction,
                     include_commissions, slippage,
-                    data_file_oos, max_variation_pct, num_noise_tests );
+                    data_file_oos, max_variation_pct, num_noise_tests,
+                    validation_target, random_seed, backtest_cache,
+                    bootstrap_resamples, bootstrap_block_size,
+                    ga_selection, ga_steady_state, filter_mask,
+                    wf_windows, wf_is_ratio, wf_anchored,
+                    combined_is_oos, factory_pruning,
+                    batch_file, batch_memory_mb, overrides );
+
+    //--- Batch of jobs: each job runs these settings with its overrides
+    if( run_mode == 9 ){
+        if( batch != nullptr ){
+            std::cout << ">>> ERROR: RUN_MODE 9 in a job of batch file "
+                      << batch_file << " (run_job)\n";
+            exit(1);
+        }
+        return( run_batch( config_file, batch_file, batch_memory_mb ) );
+    }
+    //---
 
     //--- Define paths and result files
     //std::string data_dir { main_dir + "/BarData" } ; ///< Path to directory containing data
@@ -184,6 +235,8 @@ int main () {
     std::string profits_file { result_dir + "/profits.csv" };  ///< Path to profits file (needed by gnuplot)
     std::string noise_file { result_dir + "/noise.csv" };  ///< Path to file with noise test results (needed by gnuplot)
     std::string overview_file { result_dir + "/mkt_overview.csv" };  ///< Path to file with overview results (needed by gnuplot)
+    std::string bootstrap_file { result_dir + "/bootstrap.csv" };  ///< Path to file with bootstrap confidence intervals
+    std::string walkforward_file { result_dir + "/walkforward.csv" };  ///< Path to file with walk-forward results
     std::string trade_list_file { result_dir + "/transactions_"
                                     + strategy_name + "_" + symbol_name
                                     + "_" + timeframe + ".csv" }; ///< Path to transaction list file
@@ -199,6 +252,7 @@ int main () {
     std::string validated_file { result_dir + "/validated_" + strategy_name
                                 + "_" + symbol_name
                                 + "_" + timeframe + ".csv" };   ///< Path to validated strategies file
+    std::string cache_dir { result_dir + "/cache" };    ///< Path to directory containing backtest cache
 
     std::string param_file { "Strategies/" + strategy_name + ".xml" };  ///< File with strategy parameters
     //---
@@ -215,13 +269,31 @@ int main () {
     //---
     // --------------------------------------------------------------------- //
 
+    // Set seed of all random streams (noise, slippage, genetic operators)
+    utils_random::set_global_seed( (uint64_t) random_seed );
+
     // Print header
     utils_print::print_header( strategy_name,symbol_name,timeframe,data_file );
+    if( random_seed != 0 ){
+        printf("    Random Seed: %d\n", random_seed);
+    }
 
     // Read parameter values/range from strategy XML file
     // e.g.: [ ("p1", [10]), ("p2", [2,4,6,8]), ... ]
-    param_ranges_t parameter_ranges {
-                                 utils_fileio::read_param_file(param_file) };
+    // (parsed once for all jobs of a batch)
+    if( batch != nullptr && batch->param_ranges.count(param_file) == 0 ){
+        batch->param_ranges[param_file] =
+                                    utils_fileio::read_param_file(param_file);
+        batch->param_deps[param_file] =
+                            utils_fileio::read_param_dependencies(param_file);
+    }
+    param_ranges_t parameter_ranges { batch != nullptr
+                                ? batch->param_ranges[param_file]
+                                : utils_fileio::read_param_file(param_file) };
+    // Read dependencies among parameters (<ActiveIf> nodes)
+    param_deps_t parameter_dependencies { batch != nullptr
+                        ? batch->param_deps[param_file]
+                        : utils_fileio::read_param_dependencies(param_file) };
 
     // ------------------------   INSTANTIATIONS   ------------------------- //
     // Instantiate Instrument object
@@ -233,12 +305,51 @@ int main () {
     // and wrap it into the smart pointer 'datafeed'
     select_datafeed( datafeed, datafeed_type, symbol, timeframe,
                      data_dir, data_file, csv_format, start_date, end_date );
+    // Jobs of a batch stream data from memory (parsed once for all jobs)
+    if( batch != nullptr ){
+        std::shared_ptr<const BarSeries> series {
+                                    batch->series_pool.get( *datafeed ) };
+        datafeed = std::make_unique<HistoricalBarsMemory>( *datafeed, series );
+    }
 
     // Instantiate main class object
     BTfast btf { strategy_name, symbol, timeframe,
                  max_bars_back, initial_balance, position_size_type,
                  num_contracts, risk_fraction, print_progress,
                  include_commissions, slippage };
+
+    // Run one combination per class of equivalent ones in optimizations
+    btf.set_param_dependencies( parameter_dependencies );
+
+    // Options of genetic optimization
+    btf.set_genetic_options( ga_selection, ga_steady_state );
+
+    // Entry filters as masks over trades (sequential strategy factory)
+    btf.set_filter_mask( filter_mask );
+    btf.set_combined_is_oos( combined_is_oos );
+
+    // Pruning of generation backtests (strategy factory)
+    btf.set_factory_pruning( factory_pruning );
+
+    // Instantiate persistent cache of backtest results (if enabled)
+    // (shared by all jobs of a batch with the same cache)
+    std::unique_ptr<BacktestCache> job_cache { nullptr };
+    BacktestCache *cache { nullptr };
+    if( backtest_cache > 0 && batch != nullptr ){
+        std::unique_ptr<BacktestCache> &shared_cache {
+            batch->caches[ cache_dir + "|" + std::to_string(backtest_cache) ] };
+        if( shared_cache == nullptr ){
+            shared_cache = std::make_unique<BacktestCache>( cache_dir,
+                                                    backtest_cache == 2 );
+        }
+        cache = shared_cache.get();
+    }
+    else if( backtest_cache > 0 ){
+        job_cache = std::make_unique<BacktestCache>( cache_dir,
+                                                     backtest_cache == 2 );
+        cache = job_cache.get();
+    }
+    btf.set_cache( cache );
     // --------------------------------------------------------------------- //
 
 
@@ -265,21 +376,62 @@ int main () {
             // Exhaustive Parallel Optimization
             mode_optimization( btf, datafeed, parameter_ranges, "parallel",
                                optim_file, param_file, fitness_metric,
-                               population_size, generations );
+                               optimizer );
             break;
 
         case 22:
             // Genetic Parallel Optimization
             mode_optimization( btf, datafeed, parameter_ranges, "genetic",
                                optim_file, param_file, fitness_metric,
-                               population_size, generations );
+                               optimizer );
             break;
 
         case 222:
             // Exhaustive Serial Optimization
             mode_optimization( btf, datafeed, parameter_ranges, "serial",
                                optim_file, param_file, fitness_metric,
-                               population_size, generations );
+                               optimizer );
+            break;
+
+        case 23:
+            // Successive Halving (Parallel) Optimization
+            mode_optimization( btf, datafeed, parameter_ranges, "halving",
+                               optim_file, param_file, fitness_metric,
+                               optimizer );
+            break;
+
+        case 24:
+            // Island-model Genetic (Parallel) Optimization
+            mode_optimization( btf, datafeed, parameter_ranges, "island",
+                               optim_file, param_file, fitness_metric,
+                               optimizer );
+            break;
+
+        case 25:
+            // NSGA-II Multi-objective (Parallel) Optimization
+            mode_optimization( btf, datafeed, parameter_ranges, "nsga2",
+                               optim_file, param_file, fitness_metric,
+                               optimizer );
+            break;
+
+        case 26:
+            // Sobol/Latin-hypercube Sampling (Parallel) Optimization
+            mode_optimization( btf, datafeed, parameter_ranges, "sampling",
+                               optim_file, param_file, fitness_metric,
+                               optimizer );
+            break;
+
+        case 27:
+            // Coarse-to-fine (Parallel) Optimization
+            mode_optimization( btf, datafeed, parameter_ranges, "refine",
+                               optim_file, param_file, fitness_metric,
+                               optimizer );
+            break;
+        case 28:
+            // Surrogate-guided (Parallel) Optimization
+            mode_optimization( btf, datafeed, parameter_ranges, "surrogate",
+                               optim_file, param_file, fitness_metric,
+                               optimizer );
             break;
         // ----------------------------------------------------------------- //
 
@@ -290,7 +442,8 @@ int main () {
                                     selected_file, validated_file,
                                     fitness_metric, data_dir,
                                     data_file_oos, max_variation_pct,
-                                    num_noise_tests, noise_file );
+                                    num_noise_tests, validation_target,
+                                    noise_file );
 
             break;
         // ----------------------------------------------------------------- //
@@ -302,9 +455,11 @@ int main () {
             mode_factory_sequential( btf, datafeed, parameter_ranges,
                                       optim_file, param_file, selected_file,
                                       validated_file, fitness_metric,
-                                      population_size, generations,
+                                      optimizer.population_size,
+                                      optimizer.generations,
                                       data_dir, data_file_oos, max_variation_pct,
-                                      num_noise_tests, noise_file );
+                                      num_noise_tests, validation_target,
+                                      noise_file );
             break;
 
         case 44:
@@ -312,9 +467,9 @@ int main () {
             mode_factory( btf, datafeed, parameter_ranges, "parallel",
                           optim_file, param_file, selected_file,
                           validated_file, fitness_metric,
-                          population_size, generations,
+                          optimizer.population_size, optimizer.generations,
                           data_dir, data_file_oos, max_variation_pct,
-                          num_noise_tests, noise_file );
+                          num_noise_tests, validation_target, noise_file );
             break;
 
         case 444:
@@ -322,9 +477,9 @@ int main () {
             mode_factory( btf, datafeed, parameter_ranges, "genetic",
                           optim_file, param_file, selected_file,
                           validated_file, fitness_metric,
-                          population_size, generations,
+                          optimizer.population_size, optimizer.generations,
                           data_dir, data_file_oos, max_variation_pct,
-                          num_noise_tests, noise_file );
+                          num_noise_tests, validation_target, noise_file );
             break;
 
         case 4444:
@@ -332,9 +487,9 @@ int main () {
             mode_factory( btf, datafeed, parameter_ranges, "import",
                           optim_file, param_file, selected_file,
                           validated_file, fitness_metric,
-                          population_size, generations,
+                          optimizer.population_size, optimizer.generations,
                           data_dir, data_file_oos, max_variation_pct,
-                          num_noise_tests, noise_file );
+                          num_noise_tests, validation_target, noise_file );
             break;
         // ----------------------------------------------------------------- //
 
@@ -353,6 +508,22 @@ int main () {
         }
         // ----------------------------------------------------------------- //
 
+        // ---------------------   BOOTSTRAP OF TRADES   ------------------- //
+        case 7:
+            mode_bootstrap( btf, datafeed, parameter_ranges,
+                            bootstrap_resamples, bootstrap_block_size,
+                            bootstrap_file );
+            break;
+        // ----------------------------------------------------------------- //
+
+        // --------------------   WALK-FORWARD OPTIMIZATION   -------------- //
+        case 8:
+            mode_walkforward( btf, datafeed, parameter_ranges, fitness_metric,
+                              wf_windows, wf_is_ratio, wf_anchored,
+                              walkforward_file );
+            break;
+        // ----------------------------------------------------------------- //
+
 
 
 
@@ -365,6 +536,9 @@ int main () {
 
 
     // -------------------------   FINALIZATION   -------------------------- //
+    if( cache ){
+        cache->print_statistics();
+    }
     utils_print::print_footer( strategy_name, symbol_name, timeframe,
                                data_file, btf.first_date_parsed(),
                                btf.last_date_parsed(), btf.day_counter(),
@@ -373,6 +547,90 @@ int main () {
 
     return(0);
 }
+
+
+// ------------------------------------------------------------------------- //
+/*! Run all jobs of 'batch_file' in one process, each with the settings of
+    'config_file' overridden by those of the job.
+    Jobs run one after the other, each using all threads, and share parsed
+    data, strategy XML files and backtest caches (BatchResources).
+    Jobs on the same data (same data settings overridden) run consecutively,
+    and their bar series is released after the last of them, so that only
+    the data of the running jobs are in memory. Series in memory are
+    also limited to 'batch_memory_mb' MB (least recently used released).
+*/
+int run_batch( const std::string &config_file, const std::string &batch_file,
+               int batch_memory_mb )
+{
+    std::vector<setting_overrides_t> jobs {
+                                utils_fileio::read_batch_file( batch_file ) };
+    if( jobs.empty() ){
+        std::cout << "No jobs in batch file " << batch_file << "\n";
+        return(0);
+    }
+
+    //--- Schedule: group jobs by data settings (in order of first job)
+    const std::vector<std::string> data_settings { "DATA_DIR", "DATA_FILE",
+                        "CSV_FORMAT", "DATAFEED_TYPE", "SYMBOL_NAME",
+                        "TIMEFRAME", "START_DATE", "END_DATE" };
+    std::vector<std::string> data_key ( jobs.size() );
+    std::vector<std::string> groups {};
+    for( size_t j = 0; j < jobs.size(); j++ ){
+        for( const std::string &name: data_settings ){
+            data_key[j] += "|";
+            for( const auto& s: jobs[j] ){
+                if( s.first == name ){
+                    data_key[j] += s.second;
+                }
+            }
+        }
+        if( std::find( groups.begin(), groups.end(), data_key[j] )
+                                                            == groups.end() ){
+            groups.push_back( data_key[j] );
+        }
+    }
+    std::vector<size_t> order {};
+    for( const std::string &group: groups ){
+        for( size_t j = 0; j < jobs.size(); j++ ){
+            if( data_key[j] == group ){
+                order.push_back(j);
+            }
+        }
+    }
+    //---
+
+    printf( "\n    Batch      : %lu jobs on %lu data sets (%s)\n\n",
+            jobs.size(), groups.size(), batch_file.c_str() );
+
+    BatchResources batch {};
+    batch.series_pool = BarSeriesPool { (size_t) batch_memory_mb
+                                        * 1024 * 1024 };
+    for( size_t k = 0; k < order.size(); k++ ){
+        size_t j { order[k] };
+        printf( "\n    ======================   BATCH JOB %lu / %lu   "
+                "======================\n", k + 1, order.size() );
+        run_job( config_file, jobs[j], &batch );
+
+        // Release data of this group after its last job
+        if( k + 1 == order.size() || data_key[order[k + 1]] != data_key[j] ){
+            batch.series_pool.clear();
+        }
+    }
+    batch.series_pool.print_statistics();
+    return(0);
+}
+
+
+// ------------------------------------------------------------------------- //
+int main () {
+
+    // unbuffer output
+    // (to call command: './run > log.txt &' with live update of log file)
+    std::cout << std::unitbuf;
+
+    // XML configuration file
+    return( run_job( "settings.xml", setting_overrides_t {}, nullptr ) );
+}
 ///////////////////////////////////////////////////////////////////////////////
 //////////////////////////    END OF MAIN PROGRAM    //////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
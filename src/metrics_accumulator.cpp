@@ -0,0 +1,150 @@
+#include "metrics_accumulator.h"
+
+#include <cmath>            // std::abs, std::sqrt
+
+
+namespace {
+
+    // Min avg ticks of a profitable year (as Performance::profitable_years)
+    const double profitable_year_min_ticks {6.0};
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor
+*/
+MetricsAccumulator::MetricsAccumulator( unsigned needed )
+: needed_{ metric_prerequisites(needed) }
+{}
+
+
+// ------------------------------------------------------------------------- //
+/*! Update metrics with new closed trade (discarded if 0 contracts)
+*/
+void MetricsAccumulator::add_trade( const Transaction &trade )
+{
+    if( trade.quantity() <= 0 ){
+        return;
+    }
+    double pl { trade.net_pl() };
+    double ticks { trade.ticks() };
+
+    ntrades_++;
+
+    // Welford update of mean/variance
+    if( needed_ & metric_dispersion ){
+        double delta_pl { pl - mean_pl_ };
+        mean_pl_ += delta_pl / ntrades_;
+        m2_pl_ += delta_pl * ( pl - mean_pl_ );
+        double delta_ticks { ticks - mean_ticks_ };
+        mean_ticks_ += delta_ticks / ntrades_;
+        m2_ticks_ += delta_ticks * ( ticks - mean_ticks_ );
+    }
+    sum_pl_ += pl;
+    sum_ticks_ += ticks;
+
+    // Nwins, GrossProfit, GrossLoss, MaxProfit, MaxLoss
+    if( pl > 0 ){
+        nwins_++;
+        gross_profit_ += pl;
+    }
+    else{
+        gross_loss_ += pl;
+    }
+    if( pl > max_profit_ ){
+        max_profit_ = pl;
+    }
+    if( pl < max_loss_ ){
+        max_loss_ = pl;
+    }
+
+    // Running drawdown
+    if( needed_ & metric_drawdown ){
+        cumul_pl_ += pl;
+        if( cumul_pl_ > max_cumul_pl_ ){
+            max_cumul_pl_ = cumul_pl_;
+        }
+        if( cumul_pl_ - max_cumul_pl_ < max_dd_ ){
+            max_dd_ = cumul_pl_ - max_cumul_pl_;
+        }
+    }
+
+    // Yearly avg ticks: close previous year when year changes
+    if( !(needed_ & metric_years) ){
+        return;
+    }
+    int year { trade.exit_time().date().year() };
+    if( ntrades_ == 1 ){
+        year_ = year;
+    }
+    else if( year != year_ ){
+        nyears_closed_++;
+        if( year_sum_ticks_ / year_ntrades_ >= profitable_year_min_ticks ){
+            profitable_yrs_closed_++;
+        }
+        year_ = year;
+        year_sum_ticks_ = 0.0;
+        year_ntrades_ = 0;
+    }
+    year_sum_ticks_ += ticks;
+    year_ntrades_++;
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Metrics of all trades added so far
+    (same formulas as Performance::compute_metrics)
+*/
+TradeMetrics MetricsAccumulator::metrics() const
+{
+    TradeMetrics m {};
+    if( ntrades_ <= 0 ){
+        return(m);
+    }
+    double n { (double) ntrades_ };
+
+    m.ntrades = ntrades_;
+    m.nwins = nwins_;
+    m.net_pl = sum_pl_;
+    m.avg_trade = sum_pl_ / n;
+    m.avg_ticks = sum_ticks_ / n;
+    if( (needed_ & metric_dispersion) && ntrades_ >= 2 ){
+        m.std_trade = std::sqrt( m2_pl_ / (n - 1) );
+        m.std_ticks = std::sqrt( m2_ticks_ / (n - 1) );
+    }
+    m.gross_profit = gross_profit_;
+    m.gross_loss = gross_loss_;
+    m.max_profit = max_profit_;
+    m.max_loss = max_loss_;
+    m.max_dd = max_dd_;
+
+    // Years (current year included)
+    if( needed_ & metric_years ){
+        m.nyears = nyears_closed_ + 1;
+        m.profitable_yrs = profitable_yrs_closed_
+            + ( year_sum_ticks_ / year_ntrades_ >= profitable_year_min_ticks );
+    }
+
+    if( nwins_ > 0 ){
+        m.avg_profit = gross_profit_ / nwins_;
+    }
+    if( ntrades_ > nwins_ ){
+        m.avg_loss = gross_loss_ / ( ntrades_ - nwins_ );
+    }
+    m.win_perc = nwins_ / n * 100.0;
+    if( m.std_trade > 0.0 && ntrades_ >= 30 ){
+        m.zscore = std::sqrt(n) * m.avg_trade / m.std_trade;
+    }
+    if( gross_loss_ != 0.0 ){
+        m.profit_factor = gross_profit_ / std::abs(gross_loss_);
+    }
+    if( m.avg_loss < 0.0 ){
+        m.expectancy = ( m.avg_profit * m.win_perc / 100.0
+                         - std::abs(m.avg_loss) * (1 - m.win_perc / 100.0) )
+                       / std::abs(m.avg_loss);
+    }
+    if( max_dd_ != 0.0 ){
+        m.netpl_maxdd = sum_pl_ / std::abs(max_dd_);
+    }
+    return(m);
+}
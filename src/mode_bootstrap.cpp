@@ -0,0 +1,79 @@
+#include "run_modes.h"
+
+#include "account.h"
+#include "bootstrap.h"
+#include "utils_params.h"   // single_parameter_combination
+#include "utils_time.h"     // current_datetime_str
+
+#include <fstream>          // std::ofstream
+#include <iomanip>          // std::setprecision
+#include <iostream>         // std::cout
+
+
+// ------------------------------------------------------------------------- //
+/*! Bootstrap of trades for Single Strategy: confidence intervals of
+    performance metrics from iid, block and trade-order resampling of
+    the trades of a single backtest.
+    Results printed on stdout and written to 'bootstrap_file'.
+*/
+void mode_bootstrap( BTfast &btf,
+                     std::unique_ptr<DataFeed> &datafeed,
+                     const param_ranges_t &parameter_ranges,
+                     int num_resamples, int block_size,
+                     const std::string &bootstrap_file )
+{
+    std::cout<< "    Run Mode   : Bootstrap of Trades for Single Strategy\n\n";
+
+    // ----------------------------    BACKTEST   -------------------------- //
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Running Backtest \n";
+
+    // Extract single parameter combination from parameter_ranges
+    // (only the <Start> value is taken)
+    parameters_t parameter_combination {
+        utils_params::single_parameter_combination(parameter_ranges) };
+
+    // Run single backtest
+    Account account { btf.initial_balance() };
+    btf.run_backtest( account, datafeed, parameter_combination );
+    std::cout<<"\n";
+    // --------------------------------------------------------------------- //
+
+    // ---------------------------    BOOTSTRAP   -------------------------- //
+    Bootstrap bootstrap { account.transactions(), num_resamples, block_size };
+
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Running " << num_resamples << " resamples of "
+              << bootstrap.ntrades() << " trades (block size "
+              << bootstrap.block_size() << ")\n";
+
+    std::ofstream outfile;
+    outfile.open( bootstrap_file );
+    outfile << "# TimeStamp   : " << utils_time::current_datetime_str() << "\n";
+    outfile << "# Strategy    : " << btf.strategy_name() << "\n";
+    outfile << "# Symbol      : " << btf.symbol().name() << "\n";
+    outfile << "# TimeFrame   : " << btf.timeframe() << "\n";
+    outfile << "# Date Range  : " << btf.first_date_parsed().tostring()
+            << " --> " << btf.last_date_parsed().tostring() << "\n";
+    outfile << "# Resamples   : " << num_resamples << " (block size "
+            << bootstrap.block_size() << ", confidence "
+            << bootstrap.confidence() << ")\n";
+    outfile << "# Method, Metric, Original, Mean, StdError, Lower, Upper\n";
+
+    for( const std::string method : { "iid", "block", "shuffle" } ){
+        std::vector<BootstrapInterval> intervals {};
+        bootstrap.run( method, intervals );
+        Bootstrap::print_intervals( method, intervals );
+
+        for( const auto& ci: intervals ){
+            outfile << std::fixed << std::setprecision(4)
+                    << method << ", " << ci.metric << ", " << ci.value
+                    << ", " << ci.mean << ", " << ci.std_error
+                    << ", " << ci.lower << ", " << ci.upper << "\n";
+        }
+    }
+    outfile.close();
+    std::cout<< "\nBootstrap results written on file: " << bootstrap_file
+             << "\n";
+    // --------------------------------------------------------------------- //
+}
@@ -8,11 +8,13 @@
                             // first_parameters_from_range,
                             // parameter_value_by_name,
                             // set_parameter_value_by_name,
-                            // no_filter_strategy,
+                            // no_filter_strategy, no_two_filters_strategy,
                             // strategy_attribute_by_name,
                             // max_strategy_metric_by_name
 #include "utils_time.h"     // current_datetime_str
 
+#include "pruning.h"        // PruningRules
+#include "strategy_index.h" // StrategyIndex
 #include "validation.h"
 
 #include <cmath>            // std::abs, std::sqrt
@@ -35,6 +37,7 @@ void mode_factory( BTfast &btf,
                    const std::string &data_dir,
                    const std::string &data_file_oos,
                    int max_variation_pct, int num_noise_tests,
+                   int validation_target,
                    const std::string &noise_file )
 {
     int max_num_generations {1};
@@ -56,12 +59,28 @@ void mode_factory( BTfast &btf,
             // Combine 'parameter_ranges' into all parameter combinations
             std::vector<parameters_t> search_space {
                          utils_params::cartesian_product(parameter_ranges) };
+            // Stop early backtests which cannot pass
+            // Validation::selection_conditions (if enabled):
+            // Ntrades (bound, threshold grows with sessions parsed),
+            // NP/MDD (heuristic)
+            PruningRules pruning { datafeed->last_date() };
+            if( btf.factory_pruning() >= 1 ){
+                pruning.add( "Ntrades", []( const PruningState &s ){
+                    return( PruningRules::min_trades(
+                                    20 * s.sessions_elapsed / 252.0 )( s ) );
+                } );
+            }
+            if( btf.factory_pruning() >= 2 ){
+                pruning.add( "NP/MDD", PruningRules::min_npmdd( 4.0 ) );
+            }
             // Exhaustive Parallel Optimization
+            btf.set_pruning( pruning.empty() ? nullptr : &pruning );
             btf.run_parallel_optimization( search_space, generated_strategies,
                                            optim_file, param_file,
                                            fitness_metric, datafeed,
                                            //btf.start_date(),btf.end_date(),
                                            true, true );
+            btf.set_pruning( nullptr );
         }
 
         else if( optim_mode == "genetic" ){
@@ -129,7 +148,8 @@ void mode_factory( BTfast &btf,
                                 parameter_ranges, selected_file,
                                 validated_file, fitness_metric,
                                 data_dir, data_file_oos, max_variation_pct,
-                                num_noise_tests, noise_file };
+                                num_noise_tests, validation_target,
+                                noise_file, &generated_strategies };
 
         // Run full validation process
         validation.run_validation();
@@ -187,6 +207,7 @@ void mode_factory_sequential( BTfast &btf,
                               const std::string &data_dir,
                               const std::string &data_file_oos,
                               int max_variation_pct, int num_noise_tests,
+                              int validation_target,
                               const std::string &noise_file )
 {
     std::cout<< "    Run Mode   : Strategy Factory (Sequential Generation + Validation)\n\n";
@@ -210,6 +231,8 @@ void mode_factory_sequential( BTfast &btf,
     double zscore_no_filter {0};
     double perf_relative_improvement {0.2};
     strategy_t no_filter_strat {};
+    // Rows generated by all steps, reused as neighbours by validation
+    std::vector<strategy_t> generated_all {};
     //utils_params::print_param_ranges_t(parameter_ranges);
 
 
@@ -246,15 +269,29 @@ void mode_factory_sequential( BTfast &btf,
                             "Exit_switch", parameter_ranges, search_space);
     //utils_params::print_parameters_t_vector( search_space );
 
+    // Stop early backtests which cannot pass
+    // Validation::initial_generation_selection (if enabled):
+    // Ntrades (bound), NP/MDD (heuristic)
+    PruningRules pruning_1 { datafeed->last_date() };
+    if( btf.factory_pruning() >= 1 ){
+        pruning_1.add( "Ntrades", PruningRules::min_trades( 300 ) );
+    }
+    if( btf.factory_pruning() >= 2 ){
+        pruning_1.add( "NP/MDD", PruningRules::min_npmdd( 2.0 ) );
+    }
     // Exhaustive Parallel Optimization
     std::vector<strategy_t> generated_1 {};
+    btf.set_pruning( pruning_1.empty() ? nullptr : &pruning_1 );
     btf.run_parallel_optimization( search_space, generated_1, optim_file,
                                    param_file, fitness_metric, datafeed,
                                    true, true );
+    btf.set_pruning( nullptr );
     if( generated_1.empty() ){
         std::cout<<">>> ERROR: no strategy generated (mode_factory_sequential)\n";
         exit(1);
     }
+    generated_all.insert( generated_all.end(), generated_1.begin(),
+                          generated_1.end() );
     //---
     //--- SELECTION STEP 1
     std::vector<strategy_t> selected_1 {};
@@ -262,7 +299,7 @@ void mode_factory_sequential( BTfast &btf,
     Validation val1 { btf, datafeed, generated_1, parameter_ranges,
                       selected_file, validated_file, fitness_metric,
                       data_dir, data_file_oos, max_variation_pct,
-                      num_noise_tests, noise_file };
+                      num_noise_tests, validation_target, noise_file };
     val1.initial_generation_selection( generated_1, selected_1 );
     std::cout << "Number of strategies passing 1st generation step "
               << "(POI_switch, Distance_switch, fractN, Exit_switch) : "
@@ -281,22 +318,26 @@ void mode_factory_sequential( BTfast &btf,
     // Add optimization parameter range to each strategy in search space
     utils_params::expand_strategies_with_opt_range(
                                 "DOW_switch", parameter_ranges, search_space);
-    // Exhaustive Parallel Optimization
+    // Exhaustive Parallel Optimization (filter values as masks, if enabled)
     std::vector<strategy_t> generated_2 {};
-    btf.run_parallel_optimization( search_space, generated_2,
-                                   optim_file,  param_file, fitness_metric,
-                                   datafeed, true, true );
+    btf.run_filter_optimization( search_space, { "DOW_switch" }, generated_2,
+                                 optim_file,  param_file, fitness_metric,
+                                 datafeed, true, true );
     if( generated_2.empty() ){
          std::cout<<">>> ERROR: no strategy generated (mode_factory_sequential)\n";
          exit(1);
     }
+    generated_all.insert( generated_all.end(), generated_2.begin(),
+                          generated_2.end() );
     //---
     //--- SELECTION STEP 2
     std::vector<strategy_t> selected_2 {};
+    // Hashed lookup of strategies by parameter values
+    StrategyIndex index_2 { generated_2 };
     for( const auto& strat: generated_2 ){
         // Find strategy equal to 'strat' except without new filter
         no_filter_strat  = utils_params::no_filter_strategy("DOW_switch",
-                                                            strat, generated_2);
+                                                            strat, index_2);
         if( no_filter_strat.empty() ){
             continue;   // skip strat if corresponding no_filter_strat not found
         }
@@ -351,22 +392,26 @@ void mode_factory_sequential( BTfast &btf,
     // Add optimization parameter range to each strategy in search space
     utils_params::expand_strategies_with_opt_range(
                         "Intraday_switch", parameter_ranges, search_space);
-    // Exhaustive Parallel Optimization
+    // Exhaustive Parallel Optimization (filter values as masks, if enabled)
     std::vector<strategy_t> generated_3 {};
-    btf.run_parallel_optimization( search_space, generated_3,
-                                   optim_file,  param_file, fitness_metric,
-                                   datafeed, true, true );
+    btf.run_filter_optimization( search_space, { "Intraday_switch" },
+                                 generated_3, optim_file,  param_file,
+                                 fitness_metric, datafeed, true, true );
     if( generated_3.empty() ){
          std::cout<<">>> ERROR: no strategy generated (mode_factory_sequential)\n";
          exit(1);
     }
+    generated_all.insert( generated_all.end(), generated_3.begin(),
+                          generated_3.end() );
     //---
     //--- SELECTION STEP 3
     std::vector<strategy_t> selected_3 {};
+    // Hashed lookup of strategies by parameter values
+    StrategyIndex index_3 { generated_3 };
     for( const auto& strat: generated_3 ){
         // Find strategy equal to 'strat' except without new filter
         no_filter_strat  = utils_params::no_filter_strategy("Intraday_switch",
-                                                            strat, generated_3);
+                                                            strat, index_3);
         if( no_filter_strat.empty() ){
             continue;   // skip strat if corresponding no_filter_strat not found
         }
@@ -424,35 +469,40 @@ void mode_factory_sequential( BTfast &btf,
         utils_params::expand_strategies_with_opt_range(
                         "Filter1S_switch", parameter_ranges, search_space);
     }
-    // Exhaustive Parallel Optimization
+    // Exhaustive Parallel Optimization (filter values as masks, if enabled)
     std::vector<strategy_t> generated_4 {};
-    btf.run_parallel_optimization( search_space, generated_4,
-                                   optim_file,  param_file, fitness_metric,
-                                   datafeed, true, true );
+    btf.run_filter_optimization( search_space,
+                                 { "Filter1L_switch", "Filter1S_switch" },
+                                 generated_4, optim_file,  param_file,
+                                 fitness_metric, datafeed, true, true );
     if( generated_4.empty() ){
          std::cout<<">>> ERROR: no strategy generated (mode_factory_sequential)\n";
          exit(1);
     }
+    generated_all.insert( generated_all.end(), generated_4.begin(),
+                          generated_4.end() );
     //---
     //--- SELECTION STEP 4
     std::vector<strategy_t> selected_4 {};
+    // Hashed lookup of strategies by parameter values
+    StrategyIndex index_4 { generated_4 };
     for( const auto& strat: generated_4 ){
         switch( side_switch ){
             case 1:
                 // Find strategy equal to 'strat' except without new filter
                 no_filter_strat = utils_params::no_filter_strategy(
-                                        "Filter1L_switch", strat, generated_4 );
+                                        "Filter1L_switch", strat, index_4 );
                 break;
             case 2:
                 // Find strategy equal to 'strat' except without new filter
                 no_filter_strat = utils_params::no_filter_strategy(
-                                        "Filter1S_switch", strat, generated_4 );
+                                        "Filter1S_switch", strat, index_4 );
                 break;
             case 3:
                 // Find strategy equal to 'strat' except without two new filters
                 no_filter_strat = utils_params::no_two_filters_strategy(
                                         "Filter1L_switch", "Filter1S_switch",
-                                        strat, generated_4 );
+                                        strat, index_4 );
                 break;
         }
         if( no_filter_strat.empty() ){
@@ -529,34 +579,44 @@ void mode_factory_sequential( BTfast &btf,
             utils_params::expand_strategies_with_opt_range(
                         "MktRegimeS_switch", parameter_ranges, search_space);
         }
-        // Exhaustive Parallel Optimization
+        // Exhaustive Parallel Optimization (filter values as masks,
+        // if enabled)
         std::vector<strategy_t> generated_5 {};
-        btf.run_parallel_optimization( search_space, generated_5,
-                                       optim_file,  param_file, fitness_metric,
-                                       datafeed, true, false );
+        btf.run_filter_optimization( search_space,
+                                     { "MktRegimeL_switch", "MktRegimeS_switch" },
+                                     generated_5, optim_file,  param_file,
+                                     fitness_metric, datafeed, true, false );
         if( generated_5.empty() ){
              std::cout<<">>> ERROR: no strategy generated (mode_factory_sequential)\n";
              exit(1);
         }
 
+        generated_all.insert( generated_all.end(), generated_5.begin(),
+                              generated_5.end() );
+
         // SELECTION STEP 5
+        // Hashed lookup of strategies by parameter values
+        StrategyIndex index_5 { generated_5 };
+        // Maximum value of metric over generated strategies
+        double max_avgticks { utils_params::max_strategy_metric_by_name(
+                                                    "AvgTicks", generated_5 ) };
         for( auto& strat: generated_5 ){
             switch( side_switch ){
                 case 1:
                     // Find strategy equal to 'strat' except without new filter
                     no_filter_strat = utils_params::no_filter_strategy(
-                                        "MktRegimeL_switch", strat, generated_5);
+                                        "MktRegimeL_switch", strat, index_5);
                     break;
                 case 2:
                     // Find strategy equal to 'strat' except without new filter
                     no_filter_strat = utils_params::no_filter_strategy(
-                                        "MktRegimeS_switch", strat, generated_5);
+                                        "MktRegimeS_switch", strat, index_5);
                     break;
                 case 3:
                     // Find strategy equal to 'strat' except without two new filters
                     no_filter_strat = utils_params::no_two_filters_strategy(
                                         "MktRegimeL_switch", "MktRegimeS_switch",
-                                        strat, generated_5 );
+                                        strat, index_5 );
                     break;
             }
             if( no_filter_strat.empty() ){
@@ -568,9 +628,6 @@ void mode_factory_sequential( BTfast &btf,
             // Metric of strategy with new filter(s)
             avgticks_with_filter = utils_params::strategy_attribute_by_name(
                                                     "AvgTicks", strat );
-            // Maximum value of metric over genedated strategies
-            double max_avgticks { utils_params::max_strategy_metric_by_name(
-                                                    "AvgTicks", generated_5 ) };
 
             selection_conditions = ( max_avgticks > 0.0
                                 && avgticks_with_filter == max_avgticks
@@ -585,12 +642,9 @@ void mode_factory_sequential( BTfast &btf,
                 utils_params::set_parameter_value_by_name( "DPS_switch",
                                                            strat_params, 1);
                 // Backtest strategy with DPS
-                Account account_dps { btf.initial_balance() };
-                btf.run_backtest( account_dps, datafeed, strat_params );
-                Performance performance_dps { btf.initial_balance(),
-                                              std::vector<Transaction> {} };
-                performance_dps.set_transactions( account_dps.transactions() );
-                performance_dps.compute_metrics();
+                BacktestRecord performance_dps {};
+                btf.run_cached_backtest( performance_dps,
+                            BacktestRequest { datafeed.get(), strat_params } );
                 std::vector<strategy_t> optim_results {};
                 utils_optim::append_to_optim_results( optim_results,
                                                       performance_dps,
@@ -623,11 +677,16 @@ void mode_factory_sequential( BTfast &btf,
 
 
     // ---------------------------    VALIDATION   ------------------------- //
+    // Neighbours of selected strategies (varying fractN, epsilon, ...)
+    // looked up among the rows generated by all steps
+    generated_all.insert( generated_all.end(), selected_5.begin(),
+                          selected_5.end() );
     // Instantiate Validation object
     Validation validation { btf, datafeed, selected_5, parameter_ranges,
                             selected_file, validated_file, fitness_metric,
                             data_dir, data_file_oos, max_variation_pct,
-                            num_noise_tests, noise_file };
+                            num_noise_tests, validation_target,
+                            noise_file, &generated_all };
     // Run full validation process
     validation.run_validation();
     // --------------------------------------------------------------------- //
@@ -39,7 +39,8 @@ void mode_noise( BTfast &btf,
     Performance performance { btf.initial_balance(),
                               std::vector<Transaction> {} };
     performance.set_transactions( account.transactions() );
-    performance.compute_metrics();
+    // (only metrics of optimization results are used)
+    performance.compute_metrics( metric_optim );
     // Initialize vector to store results of backtest
     std::vector<strategy_t> strategy_to_validate {};
     utils_optim::append_to_optim_results( strategy_to_validate, performance,
@@ -52,7 +53,7 @@ void mode_noise( BTfast &btf,
     // Instantiate Validation object
     Validation validation { btf,datafeed, strategy_to_validate,parameter_ranges,
                             "", "", fitness_metric, "", "", 0,
-                            num_noise_tests, noise_file };
+                            num_noise_tests, 0, noise_file };
 
     // Run full validation process
     std::vector<strategy_t> passed_test {};
@@ -29,7 +29,7 @@ void mode_notrade( BTfast &btf, std::unique_ptr<DataFeed> &datafeed,
     //<<< tests
     //std::vector<double> v({1,2,3,4,5,6,7,8,9,10});
     //std::vector<double> w({1.1, 2.1, 3.1, 4.1, 5.1, 6.1, 7.1, 8.1, 9.1, 10.1});
-    //utils_math::mannwhitney(v, w);
+    //utils_stats::mannwhitney(v, w);
 
     std::string optim_param_name {"fractN_short"};
     std::vector<parameters_t> search_space_tmp {parameter_combination};
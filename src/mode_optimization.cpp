@@ -10,6 +10,12 @@
       - "parallel"
       - "genetic"
       - "serial"
+      - "halving"
+      - "island"
+      - "nsga2"
+      - "sampling"
+      - "refine"
+      - "surrogate"
 */
 void mode_optimization( BTfast &btf,
                         std::unique_ptr<DataFeed> &datafeed,
@@ -18,13 +24,18 @@ void mode_optimization( BTfast &btf,
                         const std::string &optim_file,
                         const std::string &param_file,
                         const std::string &fitness_metric,
-                        int population_size, int generations )
+                        const OptimizerSettings &optimizer )
 {
 
     // Combine 'parameter_ranges' into all parameter combinations
     // [ [("p1", 10), ("p2", 2), ...], [("p1", 10), ("p2", 4), ...] ]
-    std::vector<parameters_t> search_space {
-                    utils_params::cartesian_product(parameter_ranges) };
+    // (not built for sampling, coarse-to-fine and surrogate optimizations,
+    //  which draw combinations directly from 'parameter_ranges')
+    std::vector<parameters_t> search_space {};
+    if( optim_mode != "sampling" && optim_mode != "refine"
+        && optim_mode != "surrogate" ){
+        search_space = utils_params::cartesian_product(parameter_ranges);
+    }
 
     // Initialize vector where storing results of optimization:
     // performance metrics and parameter values of each run, e.g.
@@ -47,7 +58,8 @@ void mode_optimization( BTfast &btf,
         std::cout<< "    Run Mode   : Genetic Parallel Optimization\n\n";
         btf.run_genetic_optimization( search_space, optim_results, optim_file,
                                       param_file, fitness_metric,
-                                      datafeed, population_size, generations );
+                                      datafeed, optimizer.population_size,
+                                      optimizer.generations );
     }
 
     else if( optim_mode == "serial" ){  // Exhaustive Serial Optimization
@@ -59,6 +71,59 @@ void mode_optimization( BTfast &btf,
                               datafeed, sort_results, verbose );
     }
 
+    else if( optim_mode == "halving" ){ // Successive Halving Optimization
+        std::cout<< "    Run Mode   : Successive Halving Optimization\n\n";
+        btf.run_halving_optimization( search_space, optim_results, optim_file,
+                                      param_file, fitness_metric, datafeed,
+                                      optimizer.halving_eta,
+                                      optimizer.halving_rungs );
+    }
+
+    else if( optim_mode == "island" ){  // Island-model Genetic Optimization
+        std::cout<< "    Run Mode   : Island Genetic Parallel Optimization\n\n";
+        btf.run_island_optimization( search_space, optim_results, optim_file,
+                                     param_file, fitness_metric, datafeed,
+                                     optimizer.population_size,
+                                     optimizer.generations, optimizer.islands,
+                                     optimizer.migration_interval,
+                                     optimizer.migrants );
+    }
+
+    else if( optim_mode == "nsga2" ){   // NSGA-II Pareto Optimization
+        std::cout<< "    Run Mode   : NSGA-II Multi-objective Parallel Optimization\n\n";
+        btf.run_nsga2_optimization( search_space, optim_results, optim_file,
+                                    param_file, fitness_metric, datafeed,
+                                    optimizer.population_size,
+                                    optimizer.generations,
+                                    optimizer.pareto_objectives );
+    }
+
+    else if( optim_mode == "sampling" ){ // Sobol/LHS Sampling Optimization
+        std::cout<< "    Run Mode   : Sampling Parallel Optimization\n\n";
+        btf.run_sampling_optimization( parameter_ranges, optim_results,
+                                       optim_file, param_file, fitness_metric,
+                                       datafeed, optimizer.samples,
+                                       optimizer.sampling_method,
+                                       optimizer.sampling_refine );
+    }
+
+    else if( optim_mode == "refine" ){  // Coarse-to-fine Optimization
+        std::cout<< "    Run Mode   : Coarse-to-fine Parallel Optimization\n\n";
+        btf.run_refinement_optimization( parameter_ranges, optim_results,
+                                         optim_file, param_file,
+                                         fitness_metric, datafeed,
+                                         optimizer.coarse_factor,
+                                         optimizer.refine_top );
+    }
+
+    else if( optim_mode == "surrogate" ){ // Surrogate-guided Optimization
+        std::cout<< "    Run Mode   : Surrogate Parallel Optimization\n\n";
+        btf.run_surrogate_optimization( parameter_ranges, optim_results,
+                                        optim_file, param_file, fitness_metric,
+                                        datafeed, optimizer.surrogate_budget,
+                                        optimizer.surrogate_batch );
+    }
+
     else{
         std::cout<<">>>ERROR: invalid optim_mode (mode_optimization).\n";
         exit(1);
@@ -24,6 +24,7 @@ void mode_single_validation( BTfast &btf,
                              const std::string &data_dir,
                              const std::string &data_file_oos,
                              int max_variation_pct, int num_noise_tests,
+                             int validation_target,
                              const std::string &noise_file )
 {
     std::cout<< "    Run Mode   : Validation for Single Strategy\n\n";
@@ -67,7 +68,8 @@ void mode_single_validation( BTfast &btf,
     Validation validation { btf, datafeed, strategy_to_validate, parameter_ranges,
                             selected_file, validated_file, fitness_metric,
                             data_dir, data_file_oos, max_variation_pct,
-                            num_noise_tests, noise_file };
+                            num_noise_tests, validation_target,
+                            noise_file };
 
     // Run full validation process
     validation.run_validation();
@@ -0,0 +1,276 @@
+#include "run_modes.h"
+
+#include "backtest_cache.h" // BacktestRecord
+#include "datafeed_memory.h" // HistoricalBarsMemory, load_bar_series
+#include "metrics_accumulator.h" // MetricsAccumulator
+#include "utils_optim.h"    // append_to_optim_results, sort_by_metric
+#include "utils_params.h"   // cartesian_product, canonical_search_space
+#include "utils_time.h"     // current_datetime_str
+
+#include <fstream>          // std::ofstream
+#include <iomanip>          // std::setw, std::setprecision
+#include <iostream>         // std::cout
+#include <mutex>            // std::mutex
+#include <sstream>          // std::ostringstream
+
+
+// ------------------------------------------------------------------------- //
+/*! Walk-forward Optimization (Parallel windows).
+    The sessions of the date range are split into 'windows' consecutive
+    out-of-sample (OOS) windows of equal length, each preceded by an
+    in-sample (IS) window 'is_ratio' times longer (rolling), or starting
+    at the first session (anchored).
+    Data are parsed only once into memory, and all windows stream them
+    (HistoricalBarsMemory::set_window).
+    The exhaustive optimizations of all IS windows run in one parallel loop
+    (over windows and combinations). The best combination of each IS
+    window (by fitness_metric) is then backtested on its OOS window, and
+    the OOS trades of all windows are stitched into a single track record.
+    Walk-forward efficiency (WFE) of each window, and overall:
+        WFE = (OOS net P/L per day) / (IS net P/L per day)
+    (not defined if IS net P/L <= 0).
+    Results printed on stdout and written to 'walkforward_file'.
+*/
+void mode_walkforward( BTfast &btf,
+                       std::unique_ptr<DataFeed> &datafeed,
+                       param_ranges_t &parameter_ranges,
+                       const std::string &fitness_metric,
+                       int windows, int is_ratio, bool anchored,
+                       const std::string &walkforward_file )
+{
+    std::cout<< "    Run Mode   : Walk-forward Optimization "
+             << "(Parallel windows)\n\n";
+
+    if( windows < 1 || is_ratio < 1 ){
+        std::cout << ">>> ERROR: WF_WINDOWS and WF_IS_RATIO must be at least 1"
+                  << " (mode_walkforward).\n";
+        exit(1);
+    }
+
+    // ----------------------------    WINDOWS    -------------------------- //
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Loading data into memory\n";
+    std::shared_ptr<const BarSeries> series { load_bar_series( *datafeed ) };
+
+    // Sessions (distinct dates) of the series
+    std::vector<Date> sessions {};
+    for( const DateTime &t: series->timestamps ){
+        if( sessions.empty() || !( sessions.back() == t.date() ) ){
+            sessions.push_back( t.date() );
+        }
+    }
+    // Sessions of each OOS window (sessions left over are put in front)
+    int oos_days { (int) sessions.size() / ( is_ratio + windows ) };
+    if( oos_days < 1 ){
+        std::cout << ">>> ERROR: not enough sessions (" << sessions.size()
+                  << ") for " << windows << " windows (mode_walkforward).\n";
+        exit(1);
+    }
+    int is_days { is_ratio * oos_days };
+    int leftover { (int) sessions.size() - ( is_ratio + windows ) * oos_days };
+
+    // IS and OOS datafeeds of each window (sharing the series)
+    std::vector<std::unique_ptr<DataFeed>> is_feeds {};
+    std::vector<std::unique_ptr<DataFeed>> oos_feeds {};
+    for( int w = 0; w < windows; w++ ){
+        int is_last { leftover + is_days + w * oos_days - 1 };
+        int is_first { anchored ? 0 : is_last - is_days + 1 };
+        auto is_feed = std::make_unique<HistoricalBarsMemory>( *datafeed,
+                                                            series, false, 0 );
+        is_feed->set_window( sessions[is_first], sessions[is_last] );
+        is_feeds.push_back( std::move(is_feed) );
+        auto oos_feed = std::make_unique<HistoricalBarsMemory>( *datafeed,
+                                                            series, false, 0 );
+        oos_feed->set_window( sessions[is_last + 1],
+                              sessions[is_last + oos_days] );
+        oos_feeds.push_back( std::move(oos_feed) );
+    }
+    // --------------------------------------------------------------------- //
+
+    // ------------------------   IS OPTIMIZATIONS   ----------------------- //
+    // All parameter combinations (only one per class of equivalent ones)
+    std::vector<parameters_t> search_space {
+                        utils_params::cartesian_product(parameter_ranges) };
+    if( !btf.param_dependencies().empty() ){
+        std::vector<parameters_t> canonical {};
+        std::vector<size_t> class_index {};
+        utils_params::canonical_search_space( search_space,
+                                              btf.param_dependencies(),
+                                              canonical, class_index );
+        search_space = canonical;
+    }
+    size_t nruns { search_space.size() };
+    size_t total { windows * nruns };
+
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Optimizing " << windows << " IS windows ("
+              << nruns << " combinations each, " << total
+              << " backtests)\n";
+
+    // Results of each (window, combination), window-major
+    std::vector<BacktestRecord> records ( total );
+    std::mutex mtx;
+    size_t done {0};
+
+    #pragma omp parallel for schedule(dynamic)
+    for( size_t k = 0; k < total; k++ ){
+        size_t w { k / nruns };
+        std::unique_ptr<DataFeed> datafeed_copy { is_feeds[w]->clone() };
+        btf.run_cached_backtest( records[k],
+                                 BacktestRequest { datafeed_copy.get(),
+                                                   search_space[k % nruns],
+                                                   false, false, k,
+                                                   false } );
+        mtx.lock();
+        done++;
+        if( done % nruns == 0 ){
+            std::cout << utils_time::current_datetime_str() + " | "
+                      << "(Parallel) Backtests done: " << done << " / "
+                      << total << "\n";
+        }
+        mtx.unlock();
+    }
+
+    // Best combination of each IS window
+    std::vector<parameters_t> best_params ( windows );
+    std::vector<double> is_netpl ( windows, 0.0 );
+    for( int w = 0; w < windows; w++ ){
+        std::vector<strategy_t> optim_results {};
+        for( size_t i = 0; i < nruns; i++ ){
+            utils_optim::append_to_optim_results( optim_results,
+                                                  records[w * nruns + i],
+                                                  search_space[i] );
+        }
+        utils_optim::sort_by_metric( optim_results, fitness_metric );
+        utils_params::extract_parameters_from_single_strategy(
+                                    optim_results.front(), best_params[w] );
+        is_netpl[w] = utils_params::strategy_attribute_by_name( "NetPL",
+                                                    optim_results.front() );
+    }
+    // --------------------------------------------------------------------- //
+
+    // -------------------------   OOS BACKTESTS   ------------------------- //
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Running " << windows << " OOS backtests\n";
+
+    std::vector<std::vector<Transaction>> oos_trades ( windows );
+    std::vector<int> oos_day_counter ( windows, 0 );
+
+    #pragma omp parallel for schedule(dynamic)
+    for( int w = 0; w < windows; w++ ){
+        std::unique_ptr<DataFeed> datafeed_copy { oos_feeds[w]->clone() };
+        BacktestResult result { btf.run( BacktestRequest { datafeed_copy.get(),
+                                                           best_params[w],
+                                                           false, false,
+                                                           (uint64_t) w } ) };
+        oos_trades[w] = result.account.transactions();
+        oos_day_counter[w] = result.day_counter;
+    }
+    // --------------------------------------------------------------------- //
+
+    // ---------------------------   RESULTS   ----------------------------- //
+    std::ofstream outfile;
+    outfile.open( walkforward_file );
+    outfile << "# TimeStamp   : " << utils_time::current_datetime_str() << "\n";
+    outfile << "# Strategy    : " << btf.strategy_name() << "\n";
+    outfile << "# Symbol      : " << btf.symbol().name() << "\n";
+    outfile << "# TimeFrame   : " << btf.timeframe() << "\n";
+    outfile << "# Windows     : " << windows << " ("
+            << ( anchored ? "anchored" : "rolling" ) << ", IS/OOS ratio "
+            << is_ratio << ", OOS sessions " << oos_days << ")\n";
+    outfile << "# Fitness     : " << fitness_metric << "\n";
+    outfile << "# Window, IS_Start, IS_End, OOS_Start, OOS_End, IS_NetPL, "
+            << "IS_Days, OOS_Ntrades, OOS_NetPL, OOS_Days, WFE";
+    for( const auto &p: search_space.front() ){
+        outfile << ", " << p.first;
+    }
+    outfile << "\n";
+
+    std::cout << "\n" << std::setw(3) << "W" << std::setw(12) << "IS start"
+              << std::setw(12) << "OOS start" << std::setw(12) << "OOS end"
+              << std::setw(12) << "IS NetPL" << std::setw(8) << "Trades"
+              << std::setw(12) << "OOS NetPL" << std::setw(8) << "WFE"
+              << "   Parameters\n";
+
+    MetricsAccumulator stitched { metric_optim };
+    double sum_is_rate {0.0};
+    int sum_oos_days {0};
+    for( int w = 0; w < windows; w++ ){
+        int is_day_counter { records[w * nruns].day_counter };
+        double oos_netpl {0.0};
+        for( const Transaction &trade: oos_trades[w] ){
+            stitched.add_trade( trade );
+            oos_netpl += trade.net_pl();
+        }
+        sum_is_rate += is_day_counter > 0 ? is_netpl[w] / is_day_counter : 0.0;
+        sum_oos_days += oos_day_counter[w];
+
+        std::string wfe {"n/a"};
+        if( is_netpl[w] > 0 && is_day_counter > 0 && oos_day_counter[w] > 0 ){
+            std::ostringstream ss {};
+            ss << std::fixed << std::setprecision(2)
+               << ( oos_netpl / oos_day_counter[w] )
+                  / ( is_netpl[w] / is_day_counter );
+            wfe = ss.str();
+        }
+        std::string params {""};
+        for( const auto &p: best_params[w] ){
+            params += p.first + "=" + std::to_string(p.second) + " ";
+        }
+        std::cout << std::fixed << std::setprecision(0)
+                  << std::setw(3) << w + 1
+                  << std::setw(12) << is_feeds[w]->start_date().tostring()
+                  << std::setw(12) << oos_feeds[w]->start_date().tostring()
+                  << std::setw(12) << oos_feeds[w]->end_date().tostring()
+                  << std::setw(12) << is_netpl[w]
+                  << std::setw(8) << oos_trades[w].size()
+                  << std::setw(12) << oos_netpl
+                  << std::setw(8) << wfe << "   " << params << "\n";
+
+        outfile << std::fixed << std::setprecision(2) << w + 1 << ", "
+                << is_feeds[w]->start_date().tostring() << ", "
+                << is_feeds[w]->end_date().tostring() << ", "
+                << oos_feeds[w]->start_date().tostring() << ", "
+                << oos_feeds[w]->end_date().tostring() << ", "
+                << is_netpl[w] << ", " << is_day_counter << ", "
+                << oos_trades[w].size() << ", " << oos_netpl << ", "
+                << oos_day_counter[w] << ", " << wfe;
+        for( const auto &p: best_params[w] ){
+            outfile << ", " << p.second;
+        }
+        outfile << "\n";
+    }
+
+    // Stitched OOS track record
+    TradeMetrics oos { stitched.metrics() };
+    double mean_is_rate { sum_is_rate / windows };
+    std::string wfe {"n/a"};
+    if( mean_is_rate > 0 && sum_oos_days > 0 ){
+        std::ostringstream ss {};
+        ss << std::fixed << std::setprecision(2)
+           << ( oos.net_pl / sum_oos_days ) / mean_is_rate;
+        wfe = ss.str();
+    }
+    std::cout << std::fixed << std::setprecision(2)
+              << "\nStitched OOS: " << oos.ntrades << " trades, NetPL "
+              << oos.net_pl << ", WinPerc " << oos.win_perc
+              << ", ProfitFactor " << oos.profit_factor
+              << ", NP/MDD " << oos.netpl_maxdd << "\n"
+              << "Walk-forward efficiency: " << wfe << "\n";
+    outfile << "# Stitched OOS: Ntrades " << oos.ntrades << ", NetPL "
+            << oos.net_pl << ", WinPerc " << oos.win_perc
+            << ", PftFactor " << oos.profit_factor
+            << ", NP/MDD " << oos.netpl_maxdd << ", WFE " << wfe << "\n";
+    outfile.close();
+    std::cout<< "\nWalk-forward results written on file: "
+             << walkforward_file << "\n";
+
+    // Counters/dates of parsed data (for printing)
+    BacktestRecord parsed {};
+    parsed.bar_counter = (int) series->size();
+    parsed.day_counter = (int) sessions.size();
+    parsed.first_date_parsed = sessions.front();
+    parsed.last_date_parsed = sessions.back();
+    btf.set_parsed_info( parsed );
+    // --------------------------------------------------------------------- //
+}
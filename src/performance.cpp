@@ -31,39 +31,49 @@ Performance::Performance( double initial_balance, //int ndays,
 /*! Compute performance metrics from transaction history in 'transactions_'
     for all/long/short trades,
     and store them into maps: metrics_all_, metrics_long_, metrics_short_.
+
+    needed: groups of metrics to compute (MetricGroup flags), together with
+            their prerequisites. Metrics not computed are left to 0.
+            Long/short metrics are computed only with metric_sides.
 */
-void Performance::compute_metrics()
+void Performance::compute_metrics( unsigned needed )
 {
+    needed = metric_prerequisites( needed );
+
     // Select long/short transactions
     std::vector<Transaction> transactions_long {};
     std::vector<Transaction> transactions_short {};
 
-    for( Transaction tr: transactions_ ){
-        if( tr.side() == "LONG" ){
-            transactions_long.push_back(tr);
-        }
-        else if( tr.side() == "SHORT" ){
-            transactions_short.push_back(tr);
+    if( needed & metric_sides ){
+        for( const Transaction& tr: transactions_ ){
+            if( tr.side() == "LONG" ){
+                transactions_long.push_back(tr);
+            }
+            else if( tr.side() == "SHORT" ){
+                transactions_short.push_back(tr);
+            }
         }
     }
 
     // Compute metrics for all/long/short trades
     // and store them into corresponding maps
 
-    compute_metrics( transactions_, metrics_all_ );
-    compute_metrics( transactions_long, metrics_long_ );
-    compute_metrics( transactions_short, metrics_short_ );
+    compute_metrics( transactions_, metrics_all_, needed );
+    compute_metrics( transactions_long, metrics_long_, needed );
+    compute_metrics( transactions_short, metrics_short_, needed );
 
 }
 
 
 //-------------------------------------------------------------------------- //
 /*! Compute performance metrics from input 'transactions' history, and
-    store them into 'metrics' unordered map (name, value)
+    store them into 'metrics' unordered map (name, value).
+    Only groups in 'needed' are computed (prerequisites already included).
 */
 void Performance::compute_metrics(
                         const std::vector<Transaction> &transactions,
-                        std::unordered_map<std::string,double> &metrics )
+                        std::unordered_map<std::string,double> &metrics,
+                        unsigned needed )
 {
     //-- Initialize entries of unordered map
     metrics["ntrades"] = 0;
@@ -114,7 +124,7 @@ void Performance::compute_metrics(
         //double tick_value { transactions.front().symbol().tick_value() };
 
         // Loop over transaction objects
-        for( Transaction tr : transactions ) {
+        for( const Transaction& tr : transactions ) {
 
             if( tr.quantity() > 0 ){
                 // fill vector of profits/losses from transactions
@@ -151,18 +161,23 @@ void Performance::compute_metrics(
         metrics["net_pl_pct"] = ( metrics["net_pl"] / initial_balance_ ) * 100.0;
         // Avg Trade (mean of profits)
         metrics["avg_trade"]  = utils_math::mean( profits );
-        // Standard Deviation of Profits
-        metrics["std_trade"] = utils_math::stdev( profits );
         // Average Ticks per trade = (1/Ntrades)* sum_i PL_i/(Nlots_i*tick_value)
         metrics["avg_ticks"] = utils_math::mean(ticks);
-        // Standard Deviation of Ticks
-        metrics["std_ticks"] = utils_math::stdev(ticks);
+        if( needed & metric_dispersion ){
+            // Standard Deviation of Profits
+            metrics["std_trade"] = utils_math::stdev( profits );
+            // Standard Deviation of Ticks
+            metrics["std_ticks"] = utils_math::stdev(ticks);
+        }
         //avgticks( profits, lots, tick_value, metrics );
 
         // DrawDowns, Nwins, GrossProfit, GrossLoss, MaxProfit, MaxLoss
+        // (Nwins, Gross Profit/Loss are basic metrics)
         drawdown( profits, dates, metrics );
         // ProfitableYears, Nyears
-        profitable_years( ticks, dates, metrics );
+        if( needed & metric_years ){
+            profitable_years( ticks, dates, metrics );
+        }
         // Average number of bars in winning/losing trade, Average Profit, Loss
         if( metrics["nwins"] > 0 ){
             metrics["bars_in_win"]  /= metrics["nwins"];
@@ -195,13 +210,19 @@ void Performance::compute_metrics(
         // TSindex = (Net Profit / Max DD) * Nwins
         metrics["tsindex"] = metrics["netpl_maxdd"] * metrics["nwins"];
         // Max consecutive winning/losing trades
-        max_consec_win_loss( profits, metrics );
-        // CAGR
-        cagr( profits, metrics );
-        // MAR
-        metrics["mar"] = metrics["cagr"]/abs(metrics["max_dd_pct"]);
+        if( needed & metric_streaks ){
+            max_consec_win_loss( profits, metrics );
+        }
+        if( needed & metric_growth ){
+            // CAGR
+            cagr( profits, metrics );
+            // MAR
+            metrics["mar"] = metrics["cagr"]/abs(metrics["max_dd_pct"]);
+        }
         // R^2
-        rsquared( profits, metrics );
+        if( needed & metric_rsquared ){
+            rsquared( profits, metrics );
+        }
         // Minimum required capital
         metrics["min_capital"] = margin + 1.5 * abs( metrics["max_dd"] );
     }
@@ -9,11 +9,13 @@
 /*! Constructor
 */
 PriceCollection::PriceCollection(const Instrument &symbol, std::string timeframe,
-                                 int max_bars_back, bool random_noise )
+                                 int max_bars_back, bool random_noise,
+                                 uint64_t run_index )
 : symbol_name_{symbol.name()},
   timeframe_{timeframe},
   max_bars_back_{max_bars_back},
-  random_noise_{random_noise}
+  random_noise_{random_noise},
+  run_index_{run_index}
 {
     if( timeframe_ != "D" ){
         // exclude the first character of timeframe (="M")
@@ -44,9 +46,11 @@ PriceCollection::PriceCollection(const Instrument &symbol, std::string timeframe
 void PriceCollection::on_bar(Event &barevent){
 
     //-- Modify bar by adding gaussian noise
+    // (independent random stream for each (run, bar))
     if( random_noise_ ){
-        utils_random::add_gaussian_noise( barevent );
+        utils_random::add_gaussian_noise( barevent, run_index_, bar_index_ );
     }
+    bar_index_++;
     //--
 
     //-- Handle intraday bars
@@ -76,6 +80,7 @@ void PriceCollection::on_bar(Event &barevent){
         }
         // append new session bar in front of deque bar_collection_
         bar_collection_[barevent.symbol().name()]["D"].push_front(barevent);
+        sessions_++;
 
     }
     //--
@@ -108,6 +113,7 @@ void PriceCollection::update_D_bars(const Event &barevent){
                          barevent.low(), barevent.close(), barevent.volume() };
         // Insert new bar at the front of the deque
         bar_list.push_front(new_D_bar);
+        sessions_++;
     }
     // Update current daily bar
     else if( !bar_list.empty() ){   // deque is not empty
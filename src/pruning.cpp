@@ -0,0 +1,82 @@
+#include "pruning.h"
+
+#include <cmath>            // std::abs
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor
+    data_end: last date of data (e.g. DataFeed::last_date)
+*/
+PruningRules::PruningRules( const Date &data_end, int check_days,
+                            int min_days )
+: data_end_{ data_end }, check_days_{ check_days }, min_days_{ min_days }
+{
+    if( check_days_ < 1 ){
+        check_days_ = 1;
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Register new rule 'name': 'predicate' returns true if backtest
+    can be stopped
+*/
+void PruningRules::add( const std::string &name, pruning_predicate_t predicate )
+{
+    rules_.push_back( std::make_pair( name, predicate ) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Index of first rule true on 'state' (-1 if none)
+*/
+int PruningRules::check( const PruningState &state ) const
+{
+    for( size_t i = 0; i < rules_.size(); i++ ){
+        if( rules_[i].second( state ) ){
+            return( (int) i );
+        }
+    }
+    return(-1);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Rule: max number of trades at end of data <= 'min_trades'
+    (closed trades + open trades + max trades per session * remaining
+     sessions). Remaining sessions are bounded by the remaining calendar
+    days plus the current one, plus one for a session across midnight.
+    Never true for strategies without a max number of trades per session.
+*/
+pruning_predicate_t PruningRules::min_trades( double min_trades )
+{
+    return( [min_trades]( const PruningState &s ){
+        if( s.max_trades_per_session <= 0 ){
+            return(false);
+        }
+        double max_trades { s.metrics.ntrades + s.open_trades
+                            + (double) s.max_trades_per_session
+                                * ( s.days_remaining + 2 ) };
+        return( max_trades <= min_trades );
+    } );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Rule: projected net profit at end of data <= 'min_npmdd' * |MaxDD|
+    (current net profit + 'slack' * current gross profit rate * remaining
+     days; max drawdown can only grow, so final NP/MDD <= 'min_npmdd').
+    Heuristic: a strategy whose profit rate increases later may be pruned.
+*/
+pruning_predicate_t PruningRules::min_npmdd( double min_npmdd, double slack )
+{
+    return( [min_npmdd, slack]( const PruningState &s ){
+        if( s.metrics.max_dd == 0.0 ){
+            return(false);
+        }
+        double rate { s.metrics.gross_profit / (double) s.days_elapsed };
+        double projected { s.metrics.net_pl
+                           + slack * rate * s.days_remaining };
+        return( projected <= min_npmdd * std::abs( s.metrics.max_dd ) );
+    } );
+}
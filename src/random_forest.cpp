@@ -0,0 +1,174 @@
+#include "random_forest.h"
+
+#include "utils_random.h"   // RandomStream, uniform_int, shuffle
+
+#include <algorithm>        // std::sort, std::max
+#include <cmath>            // std::sqrt
+#include <numeric>          // std::iota
+
+
+namespace {
+
+    // --------------------------------------------------------------------- //
+    /*! Regression tree grown on points 'x', 'y' (indices 'sample')
+    */
+    class TreeBuilder {
+
+        const std::vector<std::vector<double>> &x_;
+        const std::vector<double> &y_;
+        int min_leaf_;
+        int features_per_split_;
+        utils_random::RandomStream &rng_;
+
+        public:
+            TreeBuilder( const std::vector<std::vector<double>> &x,
+                         const std::vector<double> &y, int min_leaf,
+                         int features_per_split,
+                         utils_random::RandomStream &rng )
+            : x_{x}, y_{y}, min_leaf_{min_leaf},
+              features_per_split_{features_per_split}, rng_{rng}
+            {}
+
+            // Grow node on points sample[begin, end) of 'nodes'.
+            // Return index of node
+            template <typename Node>
+            int grow( std::vector<Node> &nodes, std::vector<int> &sample,
+                      size_t begin, size_t end )
+            {
+                int id { (int) nodes.size() };
+                nodes.push_back( Node {} );
+
+                size_t n { end - begin };
+                double sum {0.0};
+                for( size_t i = begin; i < end; i++ ){
+                    sum += y_[sample[i]];
+                }
+                nodes[id].value = sum / n;
+                if( n < 2 * (size_t) min_leaf_ ){
+                    return(id);
+                }
+
+                // Random subset of features
+                int nfeatures { (int) x_[sample[begin]].size() };
+                std::vector<int> features ( nfeatures );
+                std::iota( features.begin(), features.end(), 0 );
+                utils_random::shuffle( features, rng_ );
+                features.resize( std::min( nfeatures, features_per_split_ ) );
+
+                // Best split: max reduction of sum of squared errors,
+                // i.e. max of sum_l^2/n_l + sum_r^2/n_r
+                double best_score { sum * sum / n + 1e-12 };
+                int best_feature {-1};
+                double best_threshold {0.0};
+                for( int f: features ){
+                    std::sort( sample.begin() + begin, sample.begin() + end,
+                               [this, f]( int a, int b ){
+                                   return( x_[a][f] < x_[b][f] );
+                               } );
+                    double sum_left {0.0};
+                    for( size_t i = begin; i + 1 < end; i++ ){
+                        sum_left += y_[sample[i]];
+                        size_t n_left { i + 1 - begin };
+                        size_t n_right { n - n_left };
+                        double xi { x_[sample[i]][f] };
+                        double xnext { x_[sample[i+1]][f] };
+                        if( xi == xnext || n_left < (size_t) min_leaf_
+                            || n_right < (size_t) min_leaf_ ){
+                            continue;
+                        }
+                        double sum_right { sum - sum_left };
+                        double score { sum_left * sum_left / n_left
+                                       + sum_right * sum_right / n_right };
+                        if( score > best_score ){
+                            best_score = score;
+                            best_feature = f;
+                            best_threshold = 0.5 * ( xi + xnext );
+                        }
+                    }
+                }
+                if( best_feature < 0 ){
+                    return(id);
+                }
+
+                // Partition points and grow children
+                auto middle = std::partition( sample.begin() + begin,
+                                              sample.begin() + end,
+                                [this, best_feature, best_threshold]( int a ){
+                                    return( x_[a][best_feature]
+                                            <= best_threshold );
+                                } );
+                size_t split { (size_t) ( middle - sample.begin() ) };
+                nodes[id].feature = best_feature;
+                nodes[id].threshold = best_threshold;
+                int left { grow( nodes, sample, begin, split ) };
+                int right { grow( nodes, sample, split, end ) };
+                nodes[id].left = left;
+                nodes[id].right = right;
+                return(id);
+            }
+    };
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor
+*/
+RandomForest::RandomForest( int num_trees, int min_leaf )
+: num_trees_{ std::max(1, num_trees) }, min_leaf_{ std::max(1, min_leaf) }
+{}
+
+
+// ------------------------------------------------------------------------- //
+/*! Grow trees on training points 'x' with targets 'y' (in parallel):
+    bootstrap sample of points for each tree, about 1/3 of the features
+    (at least 1) considered at each split
+*/
+void RandomForest::fit( const std::vector<std::vector<double>> &x,
+                        const std::vector<double> &y, uint64_t run_index )
+{
+    trees_.assign( num_trees_, std::vector<Node> {} );
+    if( x.empty() ){
+        return;
+    }
+    int n { (int) x.size() };
+    int features_per_split { std::max( 1, (int) x[0].size() / 3 ) };
+
+    #pragma omp parallel for schedule(dynamic)
+    for( int t = 0; t < num_trees_; t++ ){
+        utils_random::RandomStream rng { utils_random::global_seed(),
+                                         utils_random::sampling_domain,
+                                         run_index, (uint32_t) t + 1 };
+        // Bootstrap sample of points
+        std::vector<int> sample ( n );
+        for( int i = 0; i < n; i++ ){
+            sample[i] = utils_random::uniform_int( rng, 0, n-1 );
+        }
+        TreeBuilder builder { x, y, min_leaf_, features_per_split, rng };
+        builder.grow( trees_[t], sample, 0, sample.size() );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Mean and standard deviation of tree predictions at point 'x'
+*/
+void RandomForest::predict( const std::vector<double> &x,
+                            double &mean, double &stdev ) const
+{
+    double sum {0.0};
+    double sum2 {0.0};
+    for( const std::vector<Node> &tree: trees_ ){
+        if( tree.empty() ){
+            continue;
+        }
+        int node {0};
+        while( tree[node].feature >= 0 ){
+            node = ( x[tree[node].feature] <= tree[node].threshold )
+                   ? tree[node].left : tree[node].right;
+        }
+        sum += tree[node].value;
+        sum2 += tree[node].value * tree[node].value;
+    }
+    mean = sum / trees_.size();
+    stdev = std::sqrt( std::max( 0.0, sum2 / trees_.size() - mean * mean ) );
+}
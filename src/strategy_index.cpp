@@ -0,0 +1,182 @@
+#include "strategy_index.h"
+
+#include "utils_params.h"   // extract_parameters_from_single_strategy
+
+#include <functional>       // std::hash
+
+
+// ------------------------------------------------------------------------- //
+/*! Hash of vector of parameter values (combine as in boost::hash_combine)
+*/
+size_t ParamValuesHash::operator()( const std::vector<int> &values ) const
+{
+    size_t seed { values.size() };
+    for( int v : values ){
+        seed ^= std::hash<int>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return(seed);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor: index all strategies in 'strategies'
+*/
+StrategyIndex::StrategyIndex( const std::vector<strategy_t> &strategies )
+: strategies_{strategies}
+{
+    if( strategies_.empty() ){
+        return;
+    }
+    // Parameter layout taken from first strategy
+    parameters_t first_params {};
+    utils_params::extract_parameters_from_single_strategy( strategies_.front(),
+                                                           first_params );
+    for( const auto& p : first_params ){
+        param_names_.push_back( p.first );
+    }
+
+    index_.reserve( strategies_.size() );
+    std::vector<int> values {};
+    for( size_t i = 0; i < strategies_.size(); i++ ){
+        if( parameter_values( strategies_[i], values ) ){
+            // emplace does not overwrite: first occurrence is kept
+            index_.emplace( values, i );
+        }
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Parameter values of 'strat', in the indexed order.
+    Return false if 'strat' does not match the indexed layout
+*/
+bool StrategyIndex::parameter_values( const strategy_t &strat,
+                                      std::vector<int> &values ) const
+{
+    parameters_t params {};
+    utils_params::extract_parameters_from_single_strategy( strat, params );
+    return( parameter_values( params, values ) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Values of parameters 'params', in the indexed order.
+    Return false if 'params' does not match the indexed layout
+*/
+bool StrategyIndex::parameter_values( const parameters_t &params,
+                                      std::vector<int> &values ) const
+{
+    if( params.size() != param_names_.size() ){
+        return(false);
+    }
+    values.clear();
+    values.reserve( params.size() );
+    for( size_t i = 0; i < params.size(); i++ ){
+        if( params[i].first != param_names_[i] ){
+            return(false);
+        }
+        values.push_back( params[i].second );
+    }
+    return(true);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Position of parameter 'par_name' in param_names_ (-1 if not found)
+*/
+int StrategyIndex::parameter_position( const std::string &par_name ) const
+{
+    for( size_t i = 0; i < param_names_.size(); i++ ){
+        if( param_names_[i] == par_name ){
+            return( (int) i );
+        }
+    }
+    return(-1);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Row of strategy with parameter values 'values' (nullptr if absent)
+*/
+const strategy_t* StrategyIndex::find( const std::vector<int> &values ) const
+{
+    auto it = index_.find( values );
+    if( it == index_.end() ){
+        return(nullptr);
+    }
+    return( &strategies_[it->second] );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Row of strategy with same parameters as 'strat' (nullptr if absent)
+*/
+const strategy_t* StrategyIndex::find( const strategy_t &strat ) const
+{
+    std::vector<int> values {};
+    if( !parameter_values( strat, values ) ){
+        return(nullptr);
+    }
+    return( find(values) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Row of strategy with parameters 'params' (nullptr if absent)
+*/
+const strategy_t* StrategyIndex::find( const parameters_t &params ) const
+{
+    std::vector<int> values {};
+    if( !parameter_values( params, values ) ){
+        return(nullptr);
+    }
+    return( find(values) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Row of strategy equal to 'strat' except with parameter 'par_name'
+    set to 'value' (nullptr if absent).
+    If 'par_name' is not a parameter, look up 'strat' itself.
+*/
+const strategy_t* StrategyIndex::find_with( const strategy_t &strat,
+                                            const std::string &par_name,
+                                            int value ) const
+{
+    std::vector<int> values {};
+    int pos { parameter_position(par_name) };
+    if( !parameter_values( strat, values ) ){
+        return(nullptr);
+    }
+    if( pos >= 0 ){
+        values[pos] = value;
+    }
+    return( find(values) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Row of strategy equal to 'strat' except with parameters
+    'par_name_1', 'par_name_2' set to 'value_1', 'value_2' (nullptr if absent).
+    Names which are not parameters are ignored.
+*/
+const strategy_t* StrategyIndex::find_with( const strategy_t &strat,
+                                            const std::string &par_name_1,
+                                            int value_1,
+                                            const std::string &par_name_2,
+                                            int value_2 ) const
+{
+    std::vector<int> values {};
+    int pos_1 { parameter_position(par_name_1) };
+    int pos_2 { parameter_position(par_name_2) };
+    if( !parameter_values( strat, values ) ){
+        return(nullptr);
+    }
+    if( pos_1 >= 0 ){
+        values[pos_1] = value_1;
+    }
+    if( pos_2 >= 0 ){
+        values[pos_2] = value_2;
+    }
+    return( find(values) );
+}
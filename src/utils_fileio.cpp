@@ -2,7 +2,7 @@
 
 #include "xmlParser.h"  // XML parsing library
 
-#include <algorithm>    // std::remove, std::find
+#include <algorithm>    // std::remove, std::find, std::replace
 #include <cstring>      // strcmp
 #include <fstream>      // std::fstream, std::ofstream, open, close
 #include <iomanip>     // std::setw
@@ -26,13 +26,22 @@ void utils_fileio::read_config_file(
                         bool &print_progress,
                         bool &print_performance_report, bool &print_trade_list,
                         bool &write_trades_to_file, std::string &fitness_metric,
-                        int &population_size, int &generations,
+                        OptimizerSettings &optimizer,
                         int &max_bars_back, double &initial_balance,
                         std::string &position_size_type,
                         int &num_contracts, double &risk_fraction,
                         bool &include_commissions, int &slippage,
                         std::string &data_file_oos,
-                        int &max_variation_pct, int &num_noise_tests )
+                        int &max_variation_pct, int &num_noise_tests,
+                        int &validation_target, int &random_seed,
+                        int &backtest_cache, int &bootstrap_resamples,
+                        int &bootstrap_block_size,
+                        std::string &ga_selection, bool &ga_steady_state,
+                        bool &filter_mask,
+                        int &wf_windows, int &wf_is_ratio, bool &wf_anchored,
+                        bool &combined_is_oos, int &factory_pruning,
+                        std::string &batch_file, int &batch_memory_mb,
+                        const setting_overrides_t &overrides )
 {
     std::string node_name {""};
     std::string node_value {"-"};
@@ -43,7 +52,8 @@ void utils_fileio::read_config_file(
 
     XMLNode xNode {};
 
-    // Loop over all <Input> nodes
+    // Name/Value of all <Input> nodes, followed by 'overrides'
+    setting_overrides_t inputs {};
     for( int i = 0; i<n_inputs; i++){
 
         xNode = xMainNode.getChildNode("Input", i);
@@ -57,6 +67,15 @@ void utils_fileio::read_config_file(
             std::cout<< ">>> ERROR: empty value in settings (read_param_file)\n";
             exit(1);
         }
+        inputs.push_back( std::make_pair( node_name, node_value ) );
+    }
+    inputs.insert( inputs.end(), overrides.begin(), overrides.end() );
+
+    // Loop over all inputs
+    for( const auto& input: inputs ){
+
+        node_name = input.first;
+        node_value = input.second;
 
         // Print Name/Value elements
         //cout << node_name << "  =  " << node_value << endl;
@@ -151,20 +170,20 @@ void utils_fileio::read_config_file(
         }
         else if( node_name == "POPULATION_SIZE" ){
             try{
-                population_size = std::stoi( node_value );          // int
+                optimizer.population_size = std::stoi( node_value ); // int
             }
             catch (const std::invalid_argument& er) {
                 std::cerr << ">>> ERROR: invalid input for POPULATION_SIZE\n";
                 exit(1);
             }
             // population size must be even
-            if( population_size%2 != 0){
-                population_size += 1;
+            if( optimizer.population_size%2 != 0){
+                optimizer.population_size += 1;
             }
         }
         else if( node_name == "GENERATIONS" ){
             try{
-                generations = std::stoi( node_value );              // int
+                optimizer.generations = std::stoi( node_value );    // int
             }
             catch (const std::invalid_argument& er) {
                 std::cerr << ">>> ERROR: invalid input for GENERATIONS\n";
@@ -246,10 +265,289 @@ void utils_fileio::read_config_file(
                 exit(1);
             }
         }
+        else if( node_name == "VALIDATION_TARGET" ){
+            try{
+                validation_target = std::stoi( node_value );        // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for VALIDATION_TARGET\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "RANDOM_SEED" ){
+            try{
+                random_seed = std::stoi( node_value );              // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for RANDOM_SEED\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "BACKTEST_CACHE" ){
+            try{
+                backtest_cache = std::stoi( node_value );           // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for BACKTEST_CACHE\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "BOOTSTRAP_RESAMPLES" ){
+            try{
+                bootstrap_resamples = std::stoi( node_value );      // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for BOOTSTRAP_RESAMPLES\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "BOOTSTRAP_BLOCK_SIZE" ){
+            try{
+                bootstrap_block_size = std::stoi( node_value );     // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for BOOTSTRAP_BLOCK_SIZE\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "HALVING_ETA" ){
+            try{
+                optimizer.halving_eta = std::stoi( node_value );    // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for HALVING_ETA\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "HALVING_RUNGS" ){
+            try{
+                optimizer.halving_rungs = std::stoi( node_value );  // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for HALVING_RUNGS\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "GA_SELECTION" ){
+            ga_selection = node_value ;                             // string
+        }
+        else if( node_name == "GA_STEADY_STATE" ){
+            try{
+                ga_steady_state = std::stoi( node_value );          // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for GA_STEADY_STATE\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "ISLANDS" ){
+            try{
+                optimizer.islands = std::stoi( node_value );            // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for ISLANDS\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "MIGRATION_INTERVAL" ){
+            try{
+                optimizer.migration_interval = std::stoi( node_value ); // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for MIGRATION_INTERVAL\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "MIGRANTS" ){
+            try{
+                optimizer.migrants = std::stoi( node_value );           // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for MIGRANTS\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "PARETO_OBJECTIVES" ){
+            // comma-separated list of metrics                      // string
+            optimizer.pareto_objectives.clear();
+            std::stringstream ss { node_value };
+            std::string entry {""};
+            while( std::getline(ss, entry, ',') ) {
+                entry.erase( 0, entry.find_first_not_of(" \t\n") );
+                entry.erase( entry.find_last_not_of(" \t\n") + 1 );
+                if( !entry.empty() ){
+                    optimizer.pareto_objectives.push_back( entry );
+                }
+            }
+        }
+        else if( node_name == "SAMPLES" ){
+            try{
+                optimizer.samples = std::stoi( node_value );            // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for SAMPLES\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "SAMPLING_METHOD" ){
+            optimizer.sampling_method = node_value ;                // string
+        }
+        else if( node_name == "SAMPLING_REFINE" ){
+            try{
+                optimizer.sampling_refine = std::stoi( node_value );    // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for SAMPLING_REFINE\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "COARSE_FACTOR" ){
+            try{
+                optimizer.coarse_factor = std::stoi( node_value );      // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for COARSE_FACTOR\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "REFINE_TOP" ){
+            try{
+                optimizer.refine_top = std::stoi( node_value );         // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for REFINE_TOP\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "SURROGATE_BUDGET" ){
+            try{
+                optimizer.surrogate_budget = std::stoi( node_value );   // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for SURROGATE_BUDGET\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "SURROGATE_BATCH" ){
+            try{
+                optimizer.surrogate_batch = std::stoi( node_value );    // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for SURROGATE_BATCH\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "FILTER_MASK" ){
+            try{
+                filter_mask = std::stoi( node_value );                  // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for FILTER_MASK\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "WF_WINDOWS" ){
+            try{
+                wf_windows = std::stoi( node_value );                   // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for WF_WINDOWS\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "WF_IS_RATIO" ){
+            try{
+                wf_is_ratio = std::stoi( node_value );                  // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for WF_IS_RATIO\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "WF_ANCHORED" ){
+            try{
+                wf_anchored = std::stoi( node_value );                  // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for WF_ANCHORED\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "COMBINED_IS_OOS" ){
+            try{
+                combined_is_oos = std::stoi( node_value );              // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for COMBINED_IS_OOS\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "FACTORY_PRUNING" ){
+            try{
+                factory_pruning = std::stoi( node_value );              // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for FACTORY_PRUNING\n";
+                exit(1);
+            }
+        }
+        else if( node_name == "BATCH_FILE" ){
+            batch_file = node_value;                                // string
+        }
+        else if( node_name == "BATCH_MEMORY_MB" ){
+            try{
+                batch_memory_mb = std::stoi( node_value );              // int
+            }
+            catch (const std::invalid_argument& er) {
+                std::cerr << ">>> ERROR: invalid input for BATCH_MEMORY_MB\n";
+                exit(1);
+            }
+        }
     }
     // End of loop over <Input> nodes
 }
 
+// ------------------------------------------------------------------------- //
+/* Read jobs of a batch (run mode 9) from XML batch file.
+   Each <Job> node contains <Input> nodes (<Name>, <Value>) as in
+   settings, which override the settings for that job, e.g.
+        <Batch>
+            <Job>
+                <Input> <Name> SYMBOL_NAME </Name> <Value> GC </Value></Input>
+                <Input> <Name> RUN_MODE </Name> <Value> 4 </Value></Input>
+            </Job>
+            ...
+        </Batch>
+*/
+std::vector<setting_overrides_t> utils_fileio::read_batch_file(
+                                                    std::string batch_file )
+{
+    std::vector<setting_overrides_t> jobs {};
+    XMLNode xMainNode{ XMLNode::openFileHelper(batch_file.c_str(), "Batch") };
+    int n_jobs = xMainNode.nChildNode("Job");
+
+    for( int j = 0; j < n_jobs; j++ ){
+        XMLNode xJob { xMainNode.getChildNode("Job", j) };
+        int n_inputs = xJob.nChildNode("Input");
+        setting_overrides_t job {};
+        for( int i = 0; i < n_inputs; i++ ){
+            XMLNode xNode { xJob.getChildNode("Input", i) };
+            if( xNode.getChildNode("Name").getText() == NULL
+                || xNode.getChildNode("Value").getText() == NULL ){
+                std::cout << ">>> ERROR: empty name or value in job " << j + 1
+                          << " of batch file (read_batch_file)\n";
+                exit(1);
+            }
+            job.push_back( std::make_pair(
+                                    xNode.getChildNode("Name").getText(),
+                                    xNode.getChildNode("Value").getText() ) );
+        }
+        jobs.push_back( job );
+    }
+    return(jobs);
+}
+
+
 // ------------------------------------------------------------------------- //
 /* Read parameter values/ranges from XML parameter file
    and store them into vector of vectors (returned by function).
@@ -337,6 +635,81 @@ param_ranges_t utils_fileio::read_param_file( std::string paramfile )
     return(result);
 }
 
+// ------------------------------------------------------------------------- //
+/*! Read dependencies among parameters from XML parameter file.
+    A parameter (<Input> or <OptRange> node) is active only if all
+    its <ActiveIf> conditions hold, e.g.:
+
+        <OptRange>
+            <Name>fractN_short</Name>
+            <Start>0</Start> <Stop>4</Stop> <Step>1</Step>
+            <ActiveIf>
+                <Name>Side_switch</Name>
+                <Values>2,3</Values>
+            </ActiveIf>
+        </OptRange>
+
+    The controller parameter must precede the dependent one in XML.
+    Inactive value of a parameter is its <Value> (or <Start>).
+*/
+param_deps_t utils_fileio::read_param_dependencies( std::string paramfile )
+{
+    param_deps_t result {};
+    std::vector<std::string> names {};
+
+    XMLNode xMainNode{ XMLNode::openFileHelper(paramfile.c_str(),"Inputs") };
+    int n_params = xMainNode.nChildNode("Input")
+                   + xMainNode.nChildNode("OptRange");
+
+    // Loop over all parameter nodes
+    for( int i = 0; i < n_params; i++ ){
+        XMLNode xNode { xMainNode.getChildNode(i) };
+        std::string name { xNode.getChildNode("Name").getText() };
+        int n_conditions { xNode.nChildNode("ActiveIf") };
+
+        for( int j = 0; j < n_conditions; j++ ){
+            XMLNode xCond { xNode.getChildNode("ActiveIf", j) };
+            if( xCond.getChildNode("Name").isEmpty()
+                || xCond.getChildNode("Values").isEmpty() ){
+                std::cout<<">>> ERROR: invalid ActiveIf node of parameter "
+                         << name << " in XML (read_param_dependencies)\n";
+                exit(1);
+            }
+            ParamDependency dep {};
+            dep.param = name;
+            dep.controller = xCond.getChildNode("Name").getText();
+            // controller must precede dependent parameter
+            if( std::find( names.begin(), names.end(), dep.controller )
+                                                            == names.end() ){
+                std::cout<<">>> ERROR: ActiveIf parameter " << dep.controller
+                         << " must be defined before " << name
+                         << " in XML (read_param_dependencies)\n";
+                exit(1);
+            }
+            // comma/space separated list of values
+            std::string values { xCond.getChildNode("Values").getText() };
+            std::replace( values.begin(), values.end(), ',', ' ' );
+            std::stringstream ss { values };
+            int v {0};
+            while( ss >> v ){
+                dep.active_values.push_back(v);
+            }
+            if( strcmp(xNode.getName(), "Input") == 0 ){
+                dep.inactive_value = std::stoi(
+                                    xNode.getChildNode("Value").getText() );
+            }
+            else{
+                dep.inactive_value = std::stoi(
+                                    xNode.getChildNode("Start").getText() );
+            }
+            result.push_back(dep);
+        }
+        names.push_back(name);
+    }
+    return(result);
+}
+
+
 // ------------------------------------------------------------------------- //
 // Copy (append) content of file 'sourcefile' to file 'destfile'
 // with each line starting with '#'
@@ -123,71 +123,3 @@ double utils_math::stdev( const std::vector<double> &v )
 
     return( stdev );
 }
-
-
-// ------------------------------------------------------------------------- //
-// Compute the ranks of each element in 'v' and store it in 'ranks'
-void utils_math::ranks( const std::vector<double> &v,
-                        std::vector<double> &ranks )
-{
-    std::vector<int> int_ranks;
-    for( double el: v ){
-        std::vector<double> v_copy {v};
-        std::sort(v_copy.begin(), v_copy.end());
-        auto iter = std::lower_bound(v_copy.begin(), v_copy.end(), el);
-        int_ranks.push_back( int(iter - v_copy.begin())+1 );
-    }
-
-    for( int el: int_ranks ){
-        int ties { (int) std::count(int_ranks.begin(), int_ranks.end(), el) };
-        if( ties == 1 ){
-            ranks.push_back(el);
-        }
-        else{
-            int r {0};
-            for( int i = 0; i< ties; i++ ){
-                r += el + i;
-            }
-            ranks.push_back(r/(double) ties);
-        }
-    }
-    /*
-    for( auto el: ranks ){
-        std::cout << "rank: " << el<<"\n";
-    }
-    */
-}
-
-// ------------------------------------------------------------------------- //
-// Mann-Whitney U test of two samples. Returns the two-sided p-value.
-double utils_math::mannwhitney( const std::vector<double> &v,
-                                 const std::vector<double> &w )
-{
-    if( v.empty() || w.empty() ){
-        return(0.0);
-    }
-
-    // pool vector merging (v,w)
-    std::vector<double> pool {};
-    pool.reserve( v.size() + w.size() ); // preallocate memory
-    pool.insert( pool.end(), v.begin(), v.end() );
-    pool.insert( pool.end(), w.begin(), w.end() );
-
-    std::vector<double> pool_rank {};
-    utils_math::ranks( pool, pool_rank );
-
-    int n1 { (int) v.size() };
-    int n2 { (int) w.size() };
-    double r1 { std::accumulate(pool_rank.begin(), pool_rank.begin()+n1, 0.0) };
-    double r2 { std::accumulate(pool_rank.begin()+n1, pool_rank.end(), 0.0) };
-    double u1 { r1 - n1*(n1+1)*0.5 };
-    double u2 { r2 - n2*(n2+1)*0.5 };
-    double umin { std::min(u1,u2) };
-    double mean_u { n1*n2*0.5 };
-    double sigma_u { std::sqrt(n1*n2*(n1+n2+1)/12.0 ) };
-    double z { (umin-mean_u)/sigma_u };
-    // two-sided p-value
-    double pvalue = 2*( 1 - 0.5*std::erfc( -std::abs(z)/std::sqrt(2.0)) );
-
-    return(pvalue);
-}
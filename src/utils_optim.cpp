@@ -4,6 +4,8 @@
 
 #include <algorithm>    // std::sort
 #include <iostream>     // std::cout
+#include <limits>       // std::numeric_limits
+#include <numeric>      // std::iota
 
 // ------------------------------------------------------------------------- //
 /* Append to 'optim' the performance metrics and parameter combination of
@@ -57,6 +59,37 @@ void utils_optim::append_to_optim_results( std::vector<strategy_t> &optim,
 
 }
 
+// ------------------------------------------------------------------------- //
+/*! Same as above, with performance metrics stored in 'record'
+    (e.g. from BTfast::run_cached_backtest)
+*/
+void utils_optim::append_to_optim_results( std::vector<strategy_t> &optim,
+                                           const BacktestRecord& record,
+                                           const parameters_t& parameters )
+{
+    strategy_t row;
+    // Append performance metrics (those printed/written to file)
+    row.push_back( std::make_pair("Ntrades", record.ntrades) );            // 0
+    row.push_back( std::make_pair("AvgTicks", record.avgticks) );          // 1
+    row.push_back( std::make_pair("WinPerc", record.winperc) );            // 2
+    row.push_back( std::make_pair("PftFactor", record.profitfactor) );     // 3
+    row.push_back( std::make_pair("NP/MDD", record.npmdd) );               // 4
+    row.push_back( std::make_pair("Expectancy", record.expectancy) );      // 5
+    row.push_back( std::make_pair("Z-score", record.zscore) );             // 6
+
+    // Append additional performance metrics (excluded from printing/writing)
+    row.push_back( std::make_pair("NetPL", record.netpl) );
+    row.push_back( std::make_pair("AvgTrade", record.avgtrade) );
+    row.push_back( std::make_pair("StdTicks", record.stdticks) );
+
+    // Append parameter combination
+    for( single_param_t p : parameters ){
+        row.push_back( std::make_pair(p.first, (double) p.second) );
+    }
+
+    optim.push_back(row);
+}
+
 
 // ------------------------------------------------------------------------- //
 /*! Binary predicate function to compare two strategy_t objects
@@ -258,3 +291,123 @@ void utils_optim::sort_by_metric( std::vector<strategy_t> &optim,
     }
 
 }
+
+
+// ------------------------------------------------------------------------- //
+/*! True if solution 'a' dominates solution 'b' (objectives maximized):
+    'a' is not worse than 'b' in all objectives, and better in at least one
+*/
+bool utils_optim::dominates( const std::vector<double> &a,
+                             const std::vector<double> &b )
+{
+    bool better {false};
+    for( size_t m = 0; m < a.size(); m++ ){
+        if( a[m] < b[m] ){
+            return(false);
+        }
+        if( a[m] > b[m] ){
+            better = true;
+        }
+    }
+    return(better);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Non-dominated sorting of solutions with 'objectives' (maximized).
+    Return indices of solutions in each front (front 0 = Pareto front).
+
+    Efficient non-dominated sort with binary search (ENS-BS, Zhang et al.
+    2015): solutions are visited in decreasing lexicographic order of
+    objectives, so that none can be dominated by a later one. Each one is
+    assigned to the first front with no member dominating it, found by
+    binary search (a solution dominated by a member of front k is also
+    dominated by a member of front k-1). Members of a front are compared
+    from the last one (closest in lexicographic order).
+    Time O(M N^2) in the worst case, O(M N log N) when fronts are few,
+    memory O(N) (no domination lists).
+*/
+std::vector<std::vector<int>> utils_optim::nondominated_fronts(
+                        const std::vector<std::vector<double>> &objectives )
+{
+    std::vector<int> order ( objectives.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(),
+               [&objectives]( int a, int b ){
+                   return( objectives[a] > objectives[b] );
+               } );
+
+    std::vector<std::vector<int>> fronts {};
+
+    // True if a member of front 'k' dominates solution 'i'
+    auto dominated_in = [&]( size_t k, int i ){
+        const std::vector<int> &front { fronts[k] };
+        for( auto j = front.rbegin(); j != front.rend(); ++j ){
+            if( dominates( objectives[*j], objectives[i] ) ){
+                return(true);
+            }
+        }
+        return(false);
+    };
+
+    for( int i: order ){
+        // binary search of first front not dominating solution i
+        size_t low {0};
+        size_t high { fronts.size() };
+        while( low < high ){
+            size_t mid { (low + high) / 2 };
+            if( dominated_in( mid, i ) ){
+                low = mid + 1;
+            }
+            else{
+                high = mid;
+            }
+        }
+        if( low == fronts.size() ){
+            fronts.push_back( std::vector<int> {} );
+        }
+        fronts[low].push_back(i);
+    }
+    return(fronts);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Crowding distance of each solution in 'front' (NSGA-II): sum over
+    objectives of the normalized distance between the two neighbours
+    of the solution. Boundary solutions have infinite distance.
+*/
+std::vector<double> utils_optim::crowding_distance(
+                        const std::vector<std::vector<double>> &objectives,
+                        const std::vector<int> &front )
+{
+    size_t n { front.size() };
+    std::vector<double> distance ( n, 0.0 );
+    if( n == 0 ){
+        return(distance);
+    }
+    double infinity { std::numeric_limits<double>::infinity() };
+    std::vector<size_t> order ( n );
+
+    for( size_t m = 0; m < objectives[front[0]].size(); m++ ){
+        std::iota( order.begin(), order.end(), 0 );
+        std::sort( order.begin(), order.end(),
+                   [&]( size_t a, size_t b ){
+                       return( objectives[front[a]][m]
+                               < objectives[front[b]][m] );
+                   } );
+        double min { objectives[front[order.front()]][m] };
+        double max { objectives[front[order.back()]][m] };
+        distance[order.front()] = infinity;
+        distance[order.back()] = infinity;
+        if( max == min ){
+            continue;
+        }
+        for( size_t k = 1; k + 1 < n; k++ ){
+            distance[order[k]] += ( objectives[front[order[k+1]]][m]
+                                    - objectives[front[order[k-1]]][m] )
+                                  / ( max - min );
+        }
+    }
+    return(distance);
+}
@@ -3,7 +3,8 @@
 #include "utils_optim.h"    // remove_duplicates
 
 #include <algorithm>    // std::reverse, std::sort, std::unique,
-                        // std::max_element, std::find
+                        // std::max_element, std::find, std::find_if
+#include <map>          // std::map
 #include <numeric>      // std::accumulate
 #include <iostream>     // std::cout
 #include <utility>      // std::make_pair
@@ -172,6 +173,98 @@ void utils_params::extract_parameters_from_all_strategies(
 }
 
 
+// --------------------------------------------------------------------- //
+/*!  Combination of grid 'v' at position 'index'
+*/
+parameters_t utils_params::parameters_from_indices( const param_ranges_t &v,
+                                            const std::vector<int> &index )
+{
+    parameters_t params {};
+    params.reserve( v.size() );
+    for( size_t i = 0; i < v.size(); i++ ){
+        params.push_back( std::make_pair( v[i].first,
+                                          v[i].second[ index[i] ] ) );
+    }
+    return(params);
+}
+
+// --------------------------------------------------------------------- //
+/*!  Position in grid 'v' of the values of 'params'
+     (parameters in the same order as in 'v')
+*/
+std::vector<int> utils_params::indices_from_parameters(
+                                                const param_ranges_t &v,
+                                                const parameters_t &params )
+{
+    std::vector<int> index ( v.size(), -1 );
+    for( size_t i = 0; i < v.size() && i < params.size(); i++ ){
+        const std::vector<int> &values { v[i].second };
+        auto it = std::find( values.begin(), values.end(), params[i].second );
+        if( it != values.end() ){
+            index[i] = it - values.begin();
+        }
+    }
+    return(index);
+}
+
+// --------------------------------------------------------------------- //
+/*!  Canonical representative of combination 'params' (inactive parameters
+     set to their inactive value).
+     Dependencies are in order of 'param', and each controller precedes the
+     parameters depending on it: a controller is canonicalized before
+     being tested (an inactive switch deactivates its companions too).
+*/
+parameters_t utils_params::canonical_parameters( const parameters_t &params,
+                                                 const param_deps_t &deps )
+{
+    parameters_t result { params };
+    for( const auto& dep: deps ){
+        auto controller = std::find_if( result.begin(), result.end(),
+                            [&dep]( const single_param_t &p ){
+                                return( p.first == dep.controller ); } );
+        auto param = std::find_if( result.begin(), result.end(),
+                            [&dep]( const single_param_t &p ){
+                                return( p.first == dep.param ); } );
+        if( controller == result.end() || param == result.end() ){
+            continue;
+        }
+        if( std::find( dep.active_values.begin(), dep.active_values.end(),
+                       controller->second ) == dep.active_values.end() ){
+            param->second = dep.inactive_value;
+        }
+    }
+    return(result);
+}
+
+
+// --------------------------------------------------------------------- //
+/*!  Split 'search_space' into classes of equivalent combinations
+     (canonical representatives into 'canonical', class of each combination
+      into 'class_index')
+*/
+void utils_params::canonical_search_space(
+                                const std::vector<parameters_t> &search_space,
+                                const param_deps_t &deps,
+                                std::vector<parameters_t> &canonical,
+                                std::vector<size_t> &class_index )
+{
+    canonical.clear();
+    class_index.clear();
+    class_index.reserve( search_space.size() );
+    // map (representative, index in canonical)
+    std::map<parameters_t, size_t> classes {};
+    for( const auto& params: search_space ){
+        parameters_t repr { canonical_parameters( params, deps ) };
+        auto found = classes.find( repr );
+        if( found == classes.end() ){
+            found = classes.emplace( repr, canonical.size() ).first;
+            canonical.push_back( repr );
+        }
+        class_index.push_back( found->second );
+    }
+}
+
+
 // --------------------------------------------------------------------- //
 /*  Extract only the parameter values from strategy 'source'
     (ignoring the entries with performance metrics)
@@ -671,3 +764,38 @@ strategy_t utils_params::no_two_filters_strategy( std::string filter_name_1,
    }
    return(result);
 }
+
+
+// --------------------------------------------------------------------- //
+/*!  Same as no_filter_strategy() above, with hashed lookup in 'index'
+     (built over the strategies to be searched) instead of linear scan.
+*/
+strategy_t utils_params::no_filter_strategy( const std::string &filter_name,
+                                             const strategy_t &ref_strat,
+                                             const StrategyIndex &index )
+{
+    const strategy_t *found { index.find_with( ref_strat, filter_name, 0 ) };
+    if( found == nullptr ){
+        return( strategy_t {} );
+    }
+    return(*found);
+}
+
+// --------------------------------------------------------------------- //
+/*!  Same as no_two_filters_strategy() above, with hashed lookup in
+     'index' (built over the strategies to be searched)
+     instead of linear scan.
+*/
+strategy_t utils_params::no_two_filters_strategy(
+                                            const std::string &filter_name_1,
+                                            const std::string &filter_name_2,
+                                            const strategy_t &ref_strat,
+                                            const StrategyIndex &index )
+{
+    const strategy_t *found { index.find_with( ref_strat, filter_name_1, 0,
+                                               filter_name_2, 0 ) };
+    if( found == nullptr ){
+        return( strategy_t {} );
+    }
+    return(*found);
+}
@@ -1,28 +1,276 @@
 #include "utils_random.h"
 
+#include <cmath>            // std::sqrt, std::log, std::cos
+#include <iostream>         // std::cout
+#include <random>           // std::random_device
+
 
 namespace utils_random {
 
-    std::random_device rd{};            // seed for the random number engine
-    std::mt19937 rand_generator{rd()};  // initialize random generator with seed
+    // Global seed of all random streams (set by set_global_seed)
+    uint64_t global_seed_value {0};
+}
+
+
+namespace {
+
+    // 2^-32: maps 32-bit integers into [0,1)
+    const double inv_2pow32 { 1.0 / 4294967296.0 };
+
+    // Sobol direction numbers (Joe & Kuo, new-joe-kuo-6.21201) of
+    // dimensions 2, ..., 21: degree s and coefficients a of primitive
+    // polynomial, initial direction numbers m_1, ..., m_s
+    struct SobolInit {
+        uint32_t s;
+        uint32_t a;
+        uint32_t m[7];
+    };
+    const SobolInit sobol_init[20] {
+        {1,  0, {1}},
+        {2,  1, {1, 3}},
+        {3,  1, {1, 3, 1}},
+        {3,  2, {1, 1, 1}},
+        {4,  1, {1, 1, 3, 3}},
+        {4,  4, {1, 3, 5, 13}},
+        {5,  2, {1, 1, 5, 5, 17}},
+        {5,  4, {1, 1, 5, 5, 5}},
+        {5,  7, {1, 1, 7, 11, 19}},
+        {5, 11, {1, 1, 5, 1, 1}},
+        {5, 13, {1, 1, 1, 3, 11}},
+        {5, 14, {1, 3, 5, 5, 31}},
+        {6,  1, {1, 3, 3, 9, 7, 49}},
+        {6, 13, {1, 1, 1, 15, 21, 21}},
+        {6, 16, {1, 3, 1, 13, 27, 49}},
+        {6, 19, {1, 1, 1, 15, 7, 5}},
+        {6, 22, {1, 3, 1, 15, 13, 25}},
+        {6, 25, {1, 1, 5, 5, 19, 61}},
+        {7,  1, {1, 3, 7, 11, 23, 15, 103}},
+        {7,  4, {1, 3, 7, 13, 13, 15, 69}}
+    };
+
+    // Standard gaussian number and OHLC field (in [1,4]) from Philox block
+    // 'x'. Box-Muller transform on 32-bit uniforms u1 in (0,1], u2 in [0,1)
+    inline void block_to_noise( const uint32_t x[4], double &z, int &field )
+    {
+        double u1 { ( x[0] + 1.0 ) * inv_2pow32 };
+        double u2 { x[1] * inv_2pow32 };
+        z = std::sqrt( -2.0 * std::log(u1) ) * std::cos( 2.0 * M_PI * u2 );
+        // multiply-shift mapping of 32-bit integer into [0,4)
+        field = 1 + (int) ( ( (uint64_t) x[2] * 4 ) >> 32 );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor
+*/
+utils_random::RandomStream::RandomStream( uint64_t seed, uint32_t domain,
+                                          uint64_t run_index,
+                                          uint32_t substream )
+: key_{ { (uint32_t) seed, (uint32_t) (seed >> 32) ^ (domain * philox_w0) } },
+  counter_{ { 0, substream, (uint32_t) run_index,
+              (uint32_t) (run_index >> 32) } }
+{}
+
+
+// ------------------------------------------------------------------------- //
+/*! Next random 32-bit integer.
+    A new block of 4 integers is generated every 4 calls,
+    by 10 Philox rounds on the current counter.
+*/
+uint32_t utils_random::RandomStream::operator()()
+{
+    if( pos_ == 4 ){
+        block_ = counter_;
+        philox4x32_10( block_.data(), key_[0], key_[1] );
+        pos_ = 0;
+        counter_[0]++;
+    }
+    return( block_[pos_++] );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Constructor: direction numbers of 'dims' dimensions, and digital shift
+    from 'rng' (if not nullptr)
+*/
+utils_random::SobolSequence::SobolSequence( size_t dims, RandomStream *rng )
+: directions_( dims ), shift_( dims, 0 ), x_( dims, 0 )
+{
+    if( dims > max_dims ){
+        std::cout << ">>> ERROR: Sobol sequence supports at most " << max_dims
+                  << " dimensions (SobolSequence).\n";
+        exit(1);
+    }
+    for( size_t d = 0; d < dims; d++ ){
+        std::array<uint32_t, 32> &v { directions_[d] };
+        if( d == 0 ){
+            for( int k = 0; k < 32; k++ ){
+                v[k] = 1u << (31 - k);
+            }
+        }
+        else{
+            const SobolInit &init { sobol_init[d-1] };
+            int s { (int) init.s };
+            for( int k = 0; k < s; k++ ){
+                v[k] = init.m[k] << (31 - k);
+            }
+            for( int k = s; k < 32; k++ ){
+                v[k] = v[k-s] ^ ( v[k-s] >> s );
+                for( int j = 1; j < s; j++ ){
+                    if( (init.a >> (s - 1 - j)) & 1u ){
+                        v[k] ^= v[k-j];
+                    }
+                }
+            }
+        }
+        if( rng != nullptr ){
+            shift_[d] = (*rng)();
+        }
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Next point of Sobol sequence into 'u' (Gray-code order: a single
+    direction number XORed into each coordinate)
+*/
+void utils_random::SobolSequence::next( std::vector<double> &u )
+{
+    // index of rightmost zero bit of index_
+    int c {0};
+    uint32_t i { index_ };
+    while( i & 1u ){
+        i >>= 1;
+        c++;
+    }
+    index_++;
+    u.resize( x_.size() );
+    for( size_t d = 0; d < x_.size(); d++ ){
+        x_[d] ^= directions_[d][c];
+        u[d] = ( x_[d] ^ shift_[d] ) * inv_2pow32;
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Latin hypercube sample of 'n' points in [0,1)^dims
+*/
+std::vector<std::vector<double>> utils_random::latin_hypercube( size_t n,
+                                                        size_t dims,
+                                                        RandomStream &rng )
+{
+    std::vector<std::vector<double>> points ( n, std::vector<double>(dims) );
+    std::vector<size_t> strata ( n );
+    for( size_t d = 0; d < dims; d++ ){
+        for( size_t k = 0; k < n; k++ ){
+            strata[k] = k;
+        }
+        shuffle( strata, rng );
+        for( size_t k = 0; k < n; k++ ){
+            points[k][d] = ( strata[k] + uniform01(rng) ) / n;
+        }
+    }
+    return(points);
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Set global seed of all random streams.
+    Seed 0: non-reproducible seed (from std::random_device).
+*/
+void utils_random::set_global_seed( uint64_t seed )
+{
+    if( seed == 0 ){
+        std::random_device rd{};
+        seed = ( (uint64_t) rd() << 32 ) | rd();
+    }
+    global_seed_value = seed;
+}
+
+// ------------------------------------------------------------------------- //
+/*! Global seed of all random streams
+*/
+uint64_t utils_random::global_seed()
+{
+    return( global_seed_value );
+}
+
+
+// ------------------------------------------------------------------------- //
+// Random real number uniformly distributed in [0,1) (53 random bits)
+double utils_random::uniform01( RandomStream &rng )
+{
+    uint64_t hi { rng() >> 5 };     // 27 bits
+    uint64_t lo { rng() >> 6 };     // 26 bits
+    return( ( hi * 67108864.0 + lo ) * ( 1.0 / 9007199254740992.0 ) );
+}
+
+// ------------------------------------------------------------------------- //
+// Random integer uniformly distributed in [a,b]
+int utils_random::uniform_int( RandomStream &rng, int a, int b )
+{
+    uint64_t range { (uint64_t) ( (int64_t) b - a ) + 1 };
+    // multiply-shift mapping of 32-bit integer into [0, range)
+    return( a + (int) ( ( (uint64_t) rng() * range ) >> 32 ) );
+}
+
+// ------------------------------------------------------------------------- //
+// Random real number from normal distribution N(mean, stdev^2)
+double utils_random::gaussian( RandomStream &rng, double mean, double stdev )
+{
+    // u1 in (0,1] to avoid log(0)
+    double u1 { 1.0 - uniform01( rng ) };
+    double u2 { uniform01( rng ) };
+    return( mean + stdev * std::sqrt( -2.0 * std::log(u1) )
+                         * std::cos( 2.0 * M_PI * u2 ) );
 }
 
 
+// ------------------------------------------------------------------------- //
+// Noise of bar 'bar_index' in run 'run_index': standard gaussian number
+// and OHLC field to change, from first block of the bar stream
+void utils_random::bar_noise( uint64_t run_index, uint32_t bar_index,
+                              double &z, int &field )
+{
+    uint64_t seed { global_seed_value };
+    uint32_t x[4] { 0, bar_index, (uint32_t) run_index,
+                    (uint32_t) (run_index >> 32) };
+    philox4x32_10( x, (uint32_t) seed,
+                   (uint32_t) (seed >> 32) ^ (noise_domain * philox_w0) );
+    block_to_noise( x, z, field );
+}
+
+// ------------------------------------------------------------------------- //
+// Noise of all bars of run 'run_index', in bulk (same values as bar_noise).
+// Bars are independent (one Philox block each), so the loop is vectorized
+// into SIMD lanes by the compiler.
+void utils_random::bulk_bar_noise( uint64_t run_index, size_t nbars,
+                                   double *z, uint8_t *field )
+{
+    uint64_t seed { global_seed_value };
+    const uint32_t k0 { (uint32_t) seed };
+    const uint32_t k1 { (uint32_t) (seed >> 32) ^ (noise_domain * philox_w0) };
+    const uint32_t run_lo { (uint32_t) run_index };
+    const uint32_t run_hi { (uint32_t) (run_index >> 32) };
+
+    #pragma omp simd
+    for( size_t i = 0; i < nbars; i++ ){
+        uint32_t x[4] { 0, (uint32_t) i, run_lo, run_hi };
+        philox4x32_10( x, k0, k1 );
+        int f {0};
+        block_to_noise( x, z[i], f );
+        field[i] = (uint8_t) f;
+    }
+}
+
 // ------------------------------------------------------------------------- //
 // Add gaussian noise to bar. Uniform 25% chance to change OHLC.
 // Add Gaussian noise with zero-mean, and std=(H-L)/3
-void utils_random::add_gaussian_noise( Event &bar )
+void utils_random::add_gaussian_noise( Event &bar, double z, int field )
 {
-    //std::uniform_int_distribution<> rand_int_01 {0,1};
-    //int p { rand_int_01(utils_random::rand_generator) };// random int in [0,1]
-
     // Gaussian distribution with zero-mean, and std = (H-L)/3
-    std::normal_distribution<> gaussian {0, (bar.high()-bar.low())*0.33 };
-    double noise { gaussian(utils_random::rand_generator) };
-
-    // Random integer in [1,4]
-    std::uniform_int_distribution<> rand_int_14 {1,4};
-    int r { rand_int_14(utils_random::rand_generator) };
+    double noise { z * (bar.high()-bar.low())*0.33 };
 
     // Initialize new bar values to those prior to change
     double new_open { bar.open() };
@@ -31,7 +279,7 @@ void utils_random::add_gaussian_noise( Event &bar )
     double new_close { bar.close() };
 
     // Decide which bar value to change
-    switch( r ){
+    switch( field ){
         case 1:
             new_open += noise;
             break;
@@ -50,3 +298,14 @@ void utils_random::add_gaussian_noise( Event &bar )
     bar.reorder_OHLC(new_open, new_high, new_low, new_close);
 
 }
+
+// ------------------------------------------------------------------------- //
+// Add gaussian noise to bar 'bar_index' of run 'run_index'
+void utils_random::add_gaussian_noise( Event &bar, uint64_t run_index,
+                                       uint32_t bar_index )
+{
+    double z {0.0};
+    int field {0};
+    bar_noise( run_index, bar_index, z, field );
+    add_gaussian_noise( bar, z, field );
+}
@@ -0,0 +1,205 @@
+#include "utils_stats.h"
+
+#include "utils_random.h"   // RandomStream, uniform_int
+
+#include <algorithm>        // std::sort, std::min
+#include <cmath>            // std::sqrt, std::erfc, std::exp, std::abs
+#include <numeric>          // std::iota, std::accumulate
+
+
+namespace {
+
+    // Buffers reused across calls (one set per thread)
+    struct Scratch {
+        std::vector<size_t> order {};   // sorting permutation
+        std::vector<double> pool {};    // pooled samples
+        std::vector<double> ranks {};   // ranks of pooled samples
+        std::vector<double> sorted_v {};
+        std::vector<double> sorted_w {};
+    };
+    thread_local Scratch scratch {};
+
+    // Pool samples 'v', 'w' (in this order) into 'pool'
+    void pool_samples( const std::vector<double> &v,
+                       const std::vector<double> &w,
+                       std::vector<double> &pool )
+    {
+        pool.clear();
+        pool.insert( pool.end(), v.begin(), v.end() );
+        pool.insert( pool.end(), w.begin(), w.end() );
+    }
+
+    // Ranks of 'v' into 'ranks', using 'order' as sorting buffer.
+    // Single sort of indices, then one pass over groups of tied values.
+    double ranks_with_buffer( const std::vector<double> &v,
+                              std::vector<double> &ranks,
+                              std::vector<size_t> &order )
+    {
+        size_t n { v.size() };
+        order.resize( n );
+        std::iota( order.begin(), order.end(), 0 );
+        std::sort( order.begin(), order.end(),
+                   [&](size_t a, size_t b){ return( v[a] < v[b] ); } );
+
+        ranks.resize( n );
+        double tie_term {0.0};
+        size_t i {0};
+        while( i < n ){
+            // group [i, j) of tied values
+            size_t j { i + 1 };
+            while( j < n && v[order[j]] == v[order[i]] ){
+                j++;
+            }
+            // average of ranks i+1, ..., j
+            double avg_rank { ( i + 1 + j ) * 0.5 };
+            for( size_t k = i; k < j; k++ ){
+                ranks[order[k]] = avg_rank;
+            }
+            double t { (double) (j - i) };
+            tie_term += t * t * t - t;
+            i = j;
+        }
+        return( tie_term );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+// Ranks of each element in 'v' (average ranks for ties). Return tie term.
+double utils_stats::ranks( const std::vector<double> &v,
+                           std::vector<double> &ranks )
+{
+    return( ranks_with_buffer( v, ranks, scratch.order ) );
+}
+
+
+// ------------------------------------------------------------------------- //
+// Mann-Whitney U test of two samples (tie-corrected). Two-sided p-value.
+double utils_stats::mannwhitney( const std::vector<double> &v,
+                                 const std::vector<double> &w )
+{
+    if( v.empty() || w.empty() ){
+        return(0.0);
+    }
+    pool_samples( v, w, scratch.pool );
+    double tie_term { ranks_with_buffer( scratch.pool, scratch.ranks,
+                                         scratch.order ) };
+
+    double n1 { (double) v.size() };
+    double n2 { (double) w.size() };
+    double n { n1 + n2 };
+    double r1 { std::accumulate( scratch.ranks.begin(),
+                                 scratch.ranks.begin() + v.size(), 0.0 ) };
+    double u1 { r1 - n1*(n1+1)*0.5 };
+    double u2 { n1*n2 - u1 };
+    double umin { std::min(u1,u2) };
+    double mean_u { n1*n2*0.5 };
+    // variance of U, corrected for ties
+    double var_u { n1*n2/12.0 * ( (n+1) - tie_term/(n*(n-1)) ) };
+    if( var_u <= 0.0 ){
+        return(1.0);        // all values tied: no difference
+    }
+    double z { (umin-mean_u)/std::sqrt(var_u) };
+    // two-sided p-value
+    return( std::erfc( std::abs(z)/std::sqrt(2.0) ) );
+}
+
+
+// ------------------------------------------------------------------------- //
+// Two-sample Kolmogorov-Smirnov test. Return p-value (statistic D optional)
+double utils_stats::kolmogorov_smirnov( const std::vector<double> &v,
+                                        const std::vector<double> &w,
+                                        double *statistic )
+{
+    if( v.empty() || w.empty() ){
+        if( statistic != nullptr ){
+            *statistic = 0.0;
+        }
+        return(0.0);
+    }
+    std::vector<double> &a { scratch.sorted_v };
+    std::vector<double> &b { scratch.sorted_w };
+    a.assign( v.begin(), v.end() );
+    b.assign( w.begin(), w.end() );
+    std::sort( a.begin(), a.end() );
+    std::sort( b.begin(), b.end() );
+
+    // Max distance between empirical CDFs (ties advanced together)
+    double n1 { (double) a.size() };
+    double n2 { (double) b.size() };
+    size_t i {0};
+    size_t j {0};
+    double d {0.0};
+    while( i < a.size() && j < b.size() ){
+        double x { std::min( a[i], b[j] ) };
+        while( i < a.size() && a[i] == x ){
+            i++;
+        }
+        while( j < b.size() && b[j] == x ){
+            j++;
+        }
+        d = std::max( d, std::abs( i/n1 - j/n2 ) );
+    }
+    if( statistic != nullptr ){
+        *statistic = d;
+    }
+
+    // Kolmogorov distribution Q(lambda) = 2 sum_j (-1)^(j-1) exp(-2 j^2 lambda^2)
+    double en { std::sqrt( n1*n2/(n1+n2) ) };
+    double lambda { ( en + 0.12 + 0.11/en ) * d };
+    if( lambda < 1e-3 ){
+        return(1.0);
+    }
+    double sum {0.0};
+    double sign {1.0};
+    for( int k = 1; k <= 100; k++ ){
+        double term { sign * std::exp( -2.0 * k * k * lambda * lambda ) };
+        sum += term;
+        if( std::abs(term) < 1e-10 * std::abs(sum) ){
+            break;
+        }
+        sign = -sign;
+    }
+    return( std::min( 1.0, std::max( 0.0, 2.0 * sum ) ) );
+}
+
+
+// ------------------------------------------------------------------------- //
+// Two-sided permutation test of difference of means. Return p-value.
+double utils_stats::permutation_test( const std::vector<double> &v,
+                                      const std::vector<double> &w,
+                                      int num_permutations,
+                                      uint64_t run_index )
+{
+    if( v.empty() || w.empty() || num_permutations <= 0 ){
+        return(1.0);
+    }
+    std::vector<double> &pool { scratch.pool };
+    pool_samples( v, w, pool );
+    size_t n1 { v.size() };
+    size_t n { pool.size() };
+    double total { std::accumulate( pool.begin(), pool.end(), 0.0 ) };
+    double sum_v { std::accumulate( v.begin(), v.end(), 0.0 ) };
+    double observed { std::abs( sum_v/n1 - (total-sum_v)/(n-n1) ) };
+    // tolerance on equality of differences (rounding of sums)
+    double tolerance { 1e-12 * ( std::abs(observed) + 1.0 ) };
+
+    utils_random::RandomStream rng { utils_random::global_seed(),
+                                     utils_random::stats_domain,
+                                     run_index, 0 };
+    int count {0};
+    for( int p = 0; p < num_permutations; p++ ){
+        // random subset of n1 elements in front (partial Fisher-Yates)
+        double sum_first {0.0};
+        for( size_t i = 0; i < n1; i++ ){
+            std::swap( pool[i], pool[utils_random::uniform_int( rng, (int) i,
+                                                            (int) n - 1 )] );
+            sum_first += pool[i];
+        }
+        double diff { std::abs( sum_first/n1 - (total-sum_first)/(n-n1) ) };
+        if( diff >= observed - tolerance ){
+            count++;
+        }
+    }
+    return( ( count + 1.0 ) / ( num_permutations + 1.0 ) );
+}
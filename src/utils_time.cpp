@@ -2,6 +2,7 @@
 
 #include <cmath>        // std::abs
 #include <cstdio>       // sscanf
+#include <ctime>        // std::tm, std::mktime
 #include <iomanip>      // std::setfill, std::setw
 #include <iostream>     // std::cout
 #include <sstream>      // ostringstream
@@ -97,3 +98,19 @@ Date utils_time::actual_end_date( const std::string &input_end_date )
         return( Date {2100,1,1} );    // far in the future
     }
 }
+
+// --------------------------------------------------------------------- //
+// Date 'ndays' calendar days after 'date' (before, if 'ndays' < 0)
+
+Date utils_time::add_days( const Date &date, int ndays )
+{
+    // normalized by mktime (at noon, to be safe from DST changes)
+    std::tm t {};
+    t.tm_year = date.year() - 1900;
+    t.tm_mon = date.month() - 1;
+    t.tm_mday = date.day() + ndays;
+    t.tm_hour = 12;
+    t.tm_isdst = -1;
+    std::mktime( &t );
+    return( Date { t.tm_year + 1900, t.tm_mon + 1, t.tm_mday } );
+}
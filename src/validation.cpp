@@ -1,12 +1,16 @@
 #include "validation.h"
 
 #include "account.h"
+#include "backtest_cache.h"     // BacktestRecord
 #include "btfast.h"             // type aliases
+#include "datafeed_memory.h"    // HistoricalBarsMemory, load_bar_series
 #include "performance.h"
 #include "utils_fileio.h"       // write_strategies_to_file
 #include "utils_math.h"         // percentile, nearest_int
+#include "utils_optim.h"        // append_to_optim_results
 #include "utils_params.h"       // extract_parameters_from_strategies,
                                 // strategy_attribute_by_name
+#include "utils_stats.h"        // mannwhitney
 #include "utils_time.h"         // current_datetime_str
 
 #include <algorithm>    // std::max_element, std::min_element, std::remove, std::unique
@@ -14,12 +18,25 @@
 #include <cstdio>       // printf
 #include <iostream>     // std::cout
 #include <iterator>     // std::distance
+#include <atomic>       // std::atomic
 //#include <mutex>        // std::mutex
-//#include <omp.h>        // openMP
+#include <omp.h>        // openMP
 #include <utility>      // std::make_pair
 
+// ------------------------------------------------------------------------- //
+/*! Empty generation results (nothing to reuse as neighbours)
+*/
+namespace {
+    const std::vector<strategy_t> no_generation_results {};
+}
+
 // ------------------------------------------------------------------------- //
 /*! Constructor
+    generation_results: all rows generated in this process by the run mode
+                        on 'datafeed', indexed to reuse them as neighbours
+                        (nullptr: nothing reused, e.g. strategies read from
+                        a results file of another data file or date range,
+                        with rounded metrics)
 */
 Validation::Validation( BTfast &btf,
                         std::unique_ptr<DataFeed> &datafeed,
@@ -31,7 +48,9 @@ Validation::Validation( BTfast &btf,
                         const std::string &data_dir,
                         const std::string &data_file_oos,
                         int max_variation_pct, int num_noise_tests,
-                        const std::string &noise_file )
+                        int validation_target,
+                        const std::string &noise_file,
+                        const std::vector<strategy_t> *generation_results )
 
 : btf_ {btf},
   datafeed_ {datafeed},
@@ -44,7 +63,10 @@ Validation::Validation( BTfast &btf,
   data_file_oos_ {data_file_oos},
   max_variation_ { max_variation_pct / 100.0 },
   num_noise_tests_ {num_noise_tests},
-  noise_file_ {noise_file}
+  validation_target_ {validation_target},
+  noise_file_ {noise_file},
+  generation_index_ { generation_results != nullptr ? *generation_results
+                                                   : no_generation_results }
 {
     //date_i_ = btf.first_date_parsed();
     //date_f_ = btf.last_date_parsed();
@@ -82,6 +104,11 @@ Validation::Validation( BTfast &btf,
         - Validation: Stability test ("epsilon")
         - Validation: Noise test
 
+    Validation tests run as a pipeline (each strategy advances to the next
+    test as soon as it passes the current one) when there are enough
+    strategies to keep all threads busy, otherwise as strict stages.
+    If validation_target_ > 0, stop once that number of strategies passed.
+
     Return: number of validated strategies
 
     Names of optimization variables ("fractN_long", "fractN_short")
@@ -108,11 +135,6 @@ void Validation::run_validation()
 
     // Initialize vectors storing strategies passing each step
     std::vector<strategy_t> passed_selection {};
-    std::vector<strategy_t> passed_validation_1 {};
-    std::vector<strategy_t> passed_validation_2 {};
-    std::vector<strategy_t> passed_validation_3 {};
-    std::vector<strategy_t> passed_validation_4 {};
-    std::vector<strategy_t> passed_validation_5 {};
 
     //--- Selection
     // strategies_to_validate_ -> passed_selection
@@ -120,32 +142,35 @@ void Validation::run_validation()
     num_validated_ = (int) passed_selection.size();
     //---
 
-    //--- Validation - OOS metrics test
-    // passed_selection -> passed_validation_1
-    OOS_metrics_test( passed_selection, passed_validation_1 );
-    num_validated_ = (int) passed_validation_1.size();
-    //---
-
-    //--- Validation - OOS consistency test
-    // passed_validation_1 -> passed_validation_2
-    OOS_consistency_test( passed_validation_1, passed_validation_2 );
-    num_validated_ = (int) passed_validation_2.size();
-    //---
-
-    //--- Validation - Profitability test
-    // passed_validation_2 -> passed_validation_3
-    profitability_test( passed_validation_2, passed_validation_3 );
-    num_validated_ = (int) passed_validation_3.size();
-    //---//
+    // Datafeed of combined IS + OOS backtests (if enabled)
+    if( !passed_selection.empty() ){
+        make_datafeed_combined();
+    }
 
-    //--- Validation - Stability test
-    // passed_validation_3 -> passed_validation_4
-    stability_test( passed_validation_3, passed_validation_4 );
-    num_validated_ = (int) passed_validation_4.size();
+    //--- Validation - OOS metrics, OOS consistency, profitability,
+    //    stability and noise tests
+    // passed_selection -> passed_tests[0] -> ... -> passed_tests[4]
+    std::vector<std::vector<strategy_t>> passed_tests (5);
+    if( passed_selection.size() >= (size_t) omp_get_max_threads() ){
+        // enough strategies to keep all threads busy
+        validation_pipeline( passed_selection, passed_tests );
+    }
+    else{
+        // few strategies: parallelize backtests within each test
+        validation_stages( passed_selection, passed_tests );
+    }
+    const std::vector<strategy_t> &passed_validation_4 { passed_tests[3] };
+    const std::vector<strategy_t> &passed_validation_5 { passed_tests[4] };
+    num_validated_ = (int) passed_validation_5.size();
+    if( total_backtests_ > 0 ){
+        printf( "%21s Neighbour backtests reused from generation results: "
+                "%lld / %lld\n", "", reused_backtests_.load(),
+                total_backtests_.load() );
+    }
     //---
 
     // Write validated strategies before noise test to 'validated_file_prenoise'
-    if( num_validated_ > 0 ){
+    if( passed_validation_4.size() > 0 ){
         // remove extension from validated_file_
         std::string validated_file_prenoise { validated_file_ };
         std::string extension { ".csv" };
@@ -169,12 +194,6 @@ void Validation::run_validation()
         }
     }
 
-    //--- Validation - Noise test
-    // passed_validation_4 -> passed_validation_5
-    noise_test( passed_validation_4, passed_validation_5, false );
-    num_validated_ = (int) passed_validation_5.size();
-    //---
-
     printf( "\n>>> N. of strategies passing Full Validation: %d\n",
             num_validated_ );
 
@@ -200,6 +219,178 @@ void Validation::run_validation()
 
 
 
+// ------------------------------------------------------------------------- //
+/*! Names of validation tests, in order of execution
+*/
+namespace {
+    const std::vector<std::string> validation_test_names {
+        "OOS Metrics Test", "OOS Consistency Test", "Profitability Test",
+        "Stability Test", "Noise Test" };
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Validation by stages: all 'input_strategies' complete each test
+    before the next one starts (backtests within a test run in parallel).
+
+    passed_tests[k]: strategies passing tests 0,...,k (output)
+*/
+void Validation::validation_stages(
+                        const std::vector<strategy_t> &input_strategies,
+                        std::vector<std::vector<strategy_t>> &passed_tests )
+{
+    passed_tests.assign( validation_test_names.size(),
+                         std::vector<strategy_t> {} );
+
+    OOS_metrics_test( input_strategies, passed_tests[0] );
+    OOS_consistency_test( passed_tests[0], passed_tests[1] );
+    profitability_test( passed_tests[1], passed_tests[2] );
+    stability_test( passed_tests[2], passed_tests[3] );
+    noise_test( passed_tests[3], passed_tests[4], false );
+
+    // Keep first 'validation_target_' validated strategies
+    if( validation_target_ > 0
+        && passed_tests[4].size() > (size_t) validation_target_ ){
+        passed_tests[4].resize( validation_target_ );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Validation pipeline: strategies are distributed among threads, and each
+    strategy goes through all tests (stopping at the first failed one),
+    without waiting for the other strategies.
+
+    When 'validation_target_' strategies passed all tests, strategies not yet
+    started are skipped. Strategies are started in order, so the first
+    'validation_target_' validated strategies (kept in output) do not depend
+    on thread timing.
+    Results are printed at the end, in order of 'input_strategies'.
+
+    passed_tests[k]: strategies passing tests 0,...,k (output)
+*/
+void Validation::validation_pipeline(
+                        const std::vector<strategy_t> &input_strategies,
+                        std::vector<std::vector<strategy_t>> &passed_tests )
+{
+    if( input_strategies.empty() ){
+        return;
+    }
+    std::cout << "\n" << utils_time::current_datetime_str() + " | "
+              << "Running Validation Pipeline (";
+    for( size_t k = 0; k < validation_test_names.size(); k++ ){
+        std::cout << ( k > 0 ? ", " : "" ) << validation_test_names[k];
+    }
+    std::cout << ")\n";
+
+    std::unique_ptr<DataFeed> datafeed_oos { nullptr };
+    make_datafeed_oos( datafeed_oos );
+
+    size_t N { input_strategies.size() };
+    // Number of tests passed by each strategy (-1: skipped)
+    std::vector<int> tests_passed ( N, -1 );
+    // Number of strategies passing all tests
+    std::atomic<int> num_passed_all {0};
+
+    #pragma omp parallel for schedule(dynamic,1)
+    for( size_t i = 0; i < N; i++ ){
+        if( validation_target_ > 0 && num_passed_all >= validation_target_ ){
+            continue;   // target reached: skip strategy
+        }
+        tests_passed[i] = validation_chain( input_strategies[i],
+                                            *datafeed_oos );
+        if( tests_passed[i] == (int) validation_test_names.size() ){
+            num_passed_all++;
+        }
+    }
+
+    //--- Loop over input_strategies (in order, for deterministic output)
+    passed_tests.assign( validation_test_names.size(),
+                         std::vector<strategy_t> {} );
+    size_t num_skipped {0};
+    for( size_t i = 0; i < N; i++ ){
+        printf( "%25s Strategy %lu / %lu ","", i + 1, N );
+
+        if( tests_passed[i] < 0 ){
+            printf("-skipped-\n");
+            num_skipped++;
+            continue;
+        }
+        for( int k = 0; k < tests_passed[i]; k++ ){
+            passed_tests[k].push_back( input_strategies[i] );
+        }
+        if( tests_passed[i] == (int) validation_test_names.size() ){
+            printf("+PASSED+\n");
+        }
+        else{
+            printf( "-failed- (%s)\n",
+                    validation_test_names[tests_passed[i]].c_str() );
+        }
+    }
+    //--- End loop over input_strategies
+
+    // Keep first 'validation_target_' validated strategies
+    if( validation_target_ > 0
+        && passed_tests.back().size() > (size_t) validation_target_ ){
+        passed_tests.back().resize( validation_target_ );
+    }
+
+    for( size_t k = 0; k < validation_test_names.size(); k++ ){
+        printf( "%21s N. of strategies passing %s: %lu\n", "",
+                validation_test_names[k].c_str(), passed_tests[k].size() );
+    }
+    if( num_skipped > 0 ){
+        printf( "%21s N. of strategies skipped (target of %d reached): %lu\n",
+                "", validation_target_, num_skipped );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Run validation tests on single strategy 'strat', stopping at the first
+    failed test. Return number of tests passed (in order of
+    'validation_test_names').
+*/
+int Validation::validation_chain( const strategy_t &strat,
+                                  const DataFeed &datafeed_oos ) const
+{
+    if( datafeed_combined_ != nullptr ){
+        // single IS + OOS backtest for both OOS tests
+        parameters_t strat_params {};
+        utils_params::extract_parameters_from_single_strategy( strat,
+                                                               strat_params );
+        BacktestRecord record_is {};
+        BacktestRecord record_oos {};
+        run_combined_backtest( strat_params, record_is, record_oos, true );
+        if( !OOS_metrics_conditions( record_is, record_oos ) ){
+            return(0);
+        }
+        if( !OOS_consistency_conditions( record_is, record_oos ) ){
+            return(1);
+        }
+    }
+    else{
+        if( !OOS_metrics_passed( strat, datafeed_oos ) ){
+            return(0);
+        }
+        if( !OOS_consistency_passed( strat, datafeed_oos ) ){
+            return(1);
+        }
+    }
+    if( !profitability_passed( strat ) ){
+        return(2);
+    }
+    if( !stability_passed( strat ) ){
+        return(3);
+    }
+    if( !noise_passed( strat ) ){
+        return(4);
+    }
+    return(5);
+}
+
+
+
 // ------------------------------------------------------------------------- //
 /*! Perform selection
 
@@ -393,104 +584,19 @@ void Validation::OOS_metrics_test( const std::vector<strategy_t>
     std::cout << "\n" << utils_time::current_datetime_str() + " | "
               << "Running OOS Metrics Test\n";
 
-    // Initialize smart pointer to object derived from DataFeed base class
-    std::unique_ptr<DataFeed> datafeed_oos { nullptr };
-    // Instantiate DataFeed derived object corresponding to 'datafeed_type'
-    // and wrap it into the smart pointer 'datafeed'
-    select_datafeed( datafeed_oos, datafeed_->type(), btf_.symbol(),
-                     btf_.timeframe(), data_dir_, data_file_oos_,
-                     datafeed_->csv_format(),
-                     datafeed_->start_date(), datafeed_->end_date() );
+    // Run IS and OOS backtests of all strategies in parallel
+    std::vector<BacktestRecord> records_is {};
+    std::vector<BacktestRecord> records_oos {};
+    run_IS_OOS_backtests( input_strategies, records_is, records_oos, false );
 
-    //--- Loop over input_strategies
-    for( const auto& strat: input_strategies ){
-        printf( "%25s Strategy %lu / %lu ","",
-                &strat - &input_strategies[0] + 1, input_strategies.size() );
-                //std::distance(input_strategies.begin(), &strat) + 1
+    //--- Loop over input_strategies (in order, for deterministic output)
+    for( size_t i = 0; i < input_strategies.size(); i++ ){
+        printf( "%25s Strategy %lu / %lu ","", i + 1, input_strategies.size() );
 
-        // Extract parameters from strat and store them into strat_params
-        parameters_t strat_params {};
-        utils_params::extract_parameters_from_single_strategy( strat,
-                                                               strat_params );
-        //-- In-Sample Backtest
-        // Initialize Account for IS
-        Account account_is { btf_.initial_balance() };
-        // Run single backtest
-        btf_.run_backtest( account_is, datafeed_, strat_params );
-        // Initialize Performance object for IS
-        Performance performance_is { btf_.initial_balance(),
-                                     std::vector<Transaction> {} };
-
-        if( !account_is.transactions().empty() ){
-            // Load transaction history into performance object
-            performance_is.set_transactions( account_is.transactions() );
-            performance_is.compute_metrics();
-        }
-        else{
-            printf("-failed-\n");
-            continue;   // discard this strategy
-        }
-        int ndays_is { btf_.day_counter() };
-        int nyears_is { performance_is.nyears() };
-        int profitable_yrs_is { performance_is.profitable_yrs() };
-        //-- End In-Sample Backtest
-
-        //-- Out-of-Sample Backtest
-        // Initialize Account for OOS
-        Account account_oos { btf_.initial_balance() };
-        // Run single backtest
-        btf_.run_backtest( account_oos, datafeed_oos, strat_params );
-        // Initialize Performance object for OOS
-        Performance performance_oos { btf_.initial_balance(),
-                                     std::vector<Transaction> {} };
-
-        if( !account_oos.transactions().empty() ){
-            // Load transaction history into performance object
-            performance_oos.set_transactions( account_oos.transactions() );
-            performance_oos.compute_metrics();
-        }
-        else{
-            printf("-failed-\n");
-            continue;   // discard this strategy
-        }
-        int ndays_oos { btf_.day_counter() };
-        int nyears_oos { performance_oos.nyears() };
-        int profitable_yrs_oos { performance_oos.profitable_yrs() };
-        //-- End Out-of-Sample Backtest
-
-        // Avg number of trades per day
-        double trades_per_day_is {0.0};
-        if( ndays_is > 0 ){
-            trades_per_day_is = performance_is.ntrades()/(double) ndays_is;
-        }
-        double trades_per_day_oos {0.0};
-        if( ndays_oos > 0 ){
-            trades_per_day_oos = performance_oos.ntrades()/(double) ndays_oos;
-        }
-        // Total number of years
-        double nyears { (double) (nyears_is + nyears_oos) };
-
-        //-- Selection Conditions
-        // Similar number of trades per day
-        bool condition1 {  trades_per_day_oos >= 0.3 * trades_per_day_is
-                        && trades_per_day_oos <= 3.0 * trades_per_day_is };
-        // NetPL>0 on out-of-sample
-        bool condition2 { performance_oos.netpl() > 0.0 };
-        // At least 50% AvgTicks on out-of-sample wrt in-sample
-        bool condition3 {
-                performance_oos.avgticks() >= 0.5 * performance_is.avgticks() };
-        // At least 50% NetPL/MaxDD on out-of-sample wrt in-sample
-        bool condition4 {
-                performance_oos.npmdd() >= 0.5 * performance_is.npmdd() };
-        // At least 75% of all years are profitable (AvgTicks>=6)
-        bool condition5 { ( profitable_yrs_is + profitable_yrs_oos )
-                            / nyears  >= 0.75 };
-        //--
-
-        if(condition1 && condition2 && condition3 && condition4 && condition5){
+        if( OOS_metrics_conditions( records_is[i], records_oos[i] ) ){
             printf("+PASSED+\n");
             // append passed strategy to output_strategies
-            output_strategies.push_back( strat );
+            output_strategies.push_back( input_strategies[i] );
         }
         else{
             printf("-failed-\n");
@@ -520,78 +626,359 @@ void Validation::OOS_consistency_test( const std::vector<strategy_t>
     std::cout << "\n" << utils_time::current_datetime_str() + " | "
               << "Running OOS Consistency Test\n";
 
-    // Initialize smart pointer to object derived from DataFeed base class
-    std::unique_ptr<DataFeed> datafeed_oos { nullptr };
-    // Instantiate DataFeed derived object corresponding to 'datafeed_type'
-    // and wrap it into the smart pointer 'datafeed'
+    // Run IS and OOS backtests of all strategies in parallel,
+    // with list of ticks for each trade
+    std::vector<BacktestRecord> records_is {};
+    std::vector<BacktestRecord> records_oos {};
+    run_IS_OOS_backtests( input_strategies, records_is, records_oos, true );
+
+    //--- Loop over input_strategies (in order, for deterministic output)
+    for( size_t i = 0; i < input_strategies.size(); i++ ){
+        printf( "%25s Strategy %lu / %lu ","", i + 1, input_strategies.size() );
+
+        if( OOS_consistency_conditions( records_is[i], records_oos[i] ) ){
+            printf("+PASSED+\n");
+            // append passed strategy to output_strategies
+            output_strategies.push_back( input_strategies[i] );
+        }
+        else{
+            printf("-failed-\n");
+        }
+    }
+    //--- End loop over input_strategies
+
+    printf( "%21s N. of strategies passing OOS Consistency Test: %lu\n", "",
+            output_strategies.size() );
+}
+
+
+
+
+
+// ------------------------------------------------------------------------- //
+/*! Instantiate DataFeed derived object corresponding to datafeed_ type and
+    settings, on out-of-sample data file 'data_file_oos_',
+    and wrap it into the smart pointer 'datafeed_oos'
+*/
+void Validation::make_datafeed_oos(
+                            std::unique_ptr<DataFeed> &datafeed_oos ) const
+{
     select_datafeed( datafeed_oos, datafeed_->type(), btf_.symbol(),
                      btf_.timeframe(), data_dir_, data_file_oos_,
                      datafeed_->csv_format(),
                      datafeed_->start_date(), datafeed_->end_date() );
+}
 
-    //--- Loop over input_strategies
-    for( const auto& strat: input_strategies ){
 
-        printf( "%25s Strategy %lu / %lu ","",
-                                        &strat - &input_strategies[0] + 1,
-                                        input_strategies.size() );
+// ------------------------------------------------------------------------- //
+/*! If combined IS + OOS backtests are enabled (BTfast::combined_is_oos),
+    parse in-sample (datafeed_) and out-of-sample ('data_file_oos_') data
+    into a single in-memory series, streamed by datafeed_combined_.
+    Not enabled if OOS data do not follow IS data in time.
+*/
+void Validation::make_datafeed_combined()
+{
+    datafeed_combined_ = nullptr;
+    if( !btf_.combined_is_oos() ){
+        return;
+    }
+    std::unique_ptr<DataFeed> datafeed_oos { nullptr };
+    make_datafeed_oos( datafeed_oos );
+    std::shared_ptr<const BarSeries> series_is { load_bar_series(*datafeed_) };
+    std::shared_ptr<const BarSeries> series_oos {
+                                            load_bar_series(*datafeed_oos) };
+    if( series_is->size() == 0 || series_oos->size() == 0
+        || series_oos->timestamps.front() <= series_is->timestamps.back() ){
+        std::cout << ">>> WARNING: OOS data do not follow IS data, running "
+                  << "separate IS and OOS backtests (make_datafeed_combined)\n";
+        return;
+    }
 
-        // Extract parameters from strat and store them into strat_params
-        parameters_t strat_params {};
-        utils_params::extract_parameters_from_single_strategy( strat,
-                                                               strat_params );
-        //-- In-Sample Backtest
-        // Initialize Account for IS
-        Account account_is { btf_.initial_balance() };
-        // Run single backtest
-        btf_.run_backtest( account_is, datafeed_, strat_params );
-        // Load vector of IS ticks for each trade
-        std::vector<double> ticks_is {};
-        for( auto tr: account_is.transactions() ){
-            ticks_is.push_back( tr.ticks() );
-        }
-        if( ticks_is.empty() ){
-            printf("-failed-\n");
-            continue;   // discard this strategy
+    auto series = std::make_shared<BarSeries>( *series_is );
+    series->timestamps.insert( series->timestamps.end(),
+                               series_oos->timestamps.begin(),
+                               series_oos->timestamps.end() );
+    series->open.insert( series->open.end(), series_oos->open.begin(),
+                         series_oos->open.end() );
+    series->high.insert( series->high.end(), series_oos->high.begin(),
+                         series_oos->high.end() );
+    series->low.insert( series->low.end(), series_oos->low.begin(),
+                        series_oos->low.end() );
+    series->close.insert( series->close.end(), series_oos->close.begin(),
+                          series_oos->close.end() );
+    series->volume.insert( series->volume.end(), series_oos->volume.begin(),
+                           series_oos->volume.end() );
+
+    split_time_ = series_is->timestamps.back();
+    oos_start_ = series_oos->timestamps.front().date();
+    is_bars_ = (int) series_is->size();
+    is_days_ = 0;
+    for( size_t i = 0; i < series_is->size(); i++ ){
+        if( i == 0 || !( series_is->timestamps[i].date()
+                         == series_is->timestamps[i-1].date() ) ){
+            is_days_++;
         }
-        //-- End In-Sample Backtest
+    }
+    datafeed_combined_ = std::make_unique<HistoricalBarsMemory>( *datafeed_,
+                                                            series, false, 0 );
+    std::cout << utils_time::current_datetime_str() + " | "
+              << "Combined IS + OOS backtests (split at "
+              << split_time_.tostring() << ")\n";
+}
 
-        //-- Out-of-Sample Backtest
-        // Initialize Account for OOS
-        Account account_oos { btf_.initial_balance() };
-        // Run single backtest
-        btf_.run_backtest( account_oos, datafeed_oos, strat_params );
-        // Load vector of OOS ticks for each trade
-        std::vector<double> ticks_oos {};
-        for( auto tr: account_oos.transactions() ){
-            ticks_oos.push_back( tr.ticks() );
-        }
-        if( ticks_oos.empty() ){
-            printf("-failed-\n");
-            continue;   // discard this strategy
+
+// ------------------------------------------------------------------------- //
+/*! Run IS and OOS backtests of 'strat_params' as a single backtest on a copy
+    of datafeed_combined_, with trades attributed to IS or OOS by exit time
+*/
+void Validation::run_combined_backtest( const parameters_t &strat_params,
+                                        BacktestRecord &record_is,
+                                        BacktestRecord &record_oos,
+                                        bool with_ticks ) const
+{
+    std::unique_ptr<DataFeed> datafeed_copy { datafeed_combined_->clone() };
+    btf_.run_split_backtest( record_is, record_oos,
+                             BacktestRequest { datafeed_copy.get(),
+                                               strat_params },
+                             split_time_, oos_start_, is_bars_, is_days_,
+                             with_ticks );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Run in-sample (on datafeed_) and out-of-sample (on 'data_file_oos_')
+    backtests of all 'input_strategies' and store their results into
+    'records_is', 'records_oos' (same order as 'input_strategies').
+
+    Each IS and OOS backtest is an independent task: all 2*N tasks are
+    distributed among threads, each running on its own copy of the datafeed.
+    With combined IS + OOS backtests (datafeed_combined_), N single
+    backtests are run instead.
+
+    with_ticks: switch to fill the list of ticks of each trade
+*/
+void Validation::run_IS_OOS_backtests(
+                            const std::vector<strategy_t> &input_strategies,
+                            std::vector<BacktestRecord> &records_is,
+                            std::vector<BacktestRecord> &records_oos,
+                            bool with_ticks ) const
+{
+    // Initialize smart pointer to object derived from DataFeed base class
+    std::unique_ptr<DataFeed> datafeed_oos { nullptr };
+    make_datafeed_oos( datafeed_oos );
+
+    // Extract parameters from strategies
+    std::vector<parameters_t> strat_params {};
+    utils_params::extract_parameters_from_all_strategies( input_strategies,
+                                                          strat_params );
+    size_t N { input_strategies.size() };
+    records_is.clear();
+    records_is.resize( N );
+    records_oos.clear();
+    records_oos.resize( N );
+
+    if( datafeed_combined_ != nullptr ){
+        #pragma omp parallel for schedule(dynamic)
+        for( size_t i = 0; i < N; i++ ){
+            run_combined_backtest( strat_params[i], records_is[i],
+                                   records_oos[i], with_ticks );
         }
-        //-- End Out-of-Sample Backtest
+        return;
+    }
 
-        double pvalue { utils_math::mannwhitney(ticks_is, ticks_oos) };
-        if( pvalue >= 0.05 ){
-            printf("+PASSED+\n");
-            // append passed strategy to output_strategies
-            output_strategies.push_back( strat );
+    // task 2*i: IS backtest of strategy i, task 2*i+1: OOS backtest
+    #pragma omp parallel for schedule(dynamic)
+    for( size_t task = 0; task < 2 * N; task++ ){
+        size_t i { task / 2 };
+        bool is_task { task % 2 == 0 };
+        // Make a copy of DataFeed object and wrap it into a new unique_ptr
+        std::unique_ptr<DataFeed> datafeed_copy {
+                    is_task ? datafeed_->clone() : datafeed_oos->clone() };
+
+        btf_.run_cached_backtest( is_task ? records_is[i] : records_oos[i],
+                            BacktestRequest { datafeed_copy.get(),
+                                              strat_params[i] },
+                            with_ticks );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Conditions of OOS metrics test, given IS and OOS backtest results
+*/
+bool Validation::OOS_metrics_conditions( const BacktestRecord &performance_is,
+                                const BacktestRecord &performance_oos ) const
+{
+    if( performance_is.ntrades == 0 || performance_oos.ntrades == 0 ){
+        return(false);
+    }
+    int ndays_is { performance_is.day_counter };
+    int ndays_oos { performance_oos.day_counter };
+
+    // Avg number of trades per day
+    double trades_per_day_is {0.0};
+    if( ndays_is > 0 ){
+        trades_per_day_is = performance_is.ntrades/(double) ndays_is;
+    }
+    double trades_per_day_oos {0.0};
+    if( ndays_oos > 0 ){
+        trades_per_day_oos = performance_oos.ntrades/(double) ndays_oos;
+    }
+    // Total number of years
+    double nyears { (double) (performance_is.nyears + performance_oos.nyears) };
+
+    //-- Selection Conditions
+    // Similar number of trades per day
+    bool condition1 {  trades_per_day_oos >= 0.3 * trades_per_day_is
+                    && trades_per_day_oos <= 3.0 * trades_per_day_is };
+    // NetPL>0 on out-of-sample
+    bool condition2 { performance_oos.netpl > 0.0 };
+    // At least 50% AvgTicks on out-of-sample wrt in-sample
+    bool condition3 {
+            performance_oos.avgticks >= 0.5 * performance_is.avgticks };
+    // At least 50% NetPL/MaxDD on out-of-sample wrt in-sample
+    bool condition4 {
+            performance_oos.npmdd >= 0.5 * performance_is.npmdd };
+    // At least 75% of all years are profitable (AvgTicks>=6)
+    bool condition5 { ( performance_is.profitable_yrs
+                        + performance_oos.profitable_yrs ) / nyears  >= 0.75 };
+    //--
+
+    return( condition1 && condition2 && condition3 && condition4
+            && condition5 );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Condition of OOS consistency test, given IS and OOS backtest results
+    (with ticks): Mann-Whitney p-value >= 0.05
+*/
+bool Validation::OOS_consistency_conditions( const BacktestRecord &record_is,
+                                    const BacktestRecord &record_oos ) const
+{
+    if( record_is.ticks.empty() || record_oos.ticks.empty() ){
+        return(false);
+    }
+    double pvalue { utils_stats::mannwhitney( record_is.ticks,
+                                              record_oos.ticks ) };
+    return( pvalue >= 0.05 );
+}
+
+
+
+// ------------------------------------------------------------------------- //
+/*! OOS metrics test of single strategy 'strat' (IS and OOS backtests run
+    serially, on copies of datafeed_ and 'datafeed_oos')
+*/
+bool Validation::OOS_metrics_passed( const strategy_t &strat,
+                                     const DataFeed &datafeed_oos ) const
+{
+    parameters_t strat_params {};
+    utils_params::extract_parameters_from_single_strategy( strat,
+                                                           strat_params );
+    if( datafeed_combined_ != nullptr ){
+        BacktestRecord performance_is {};
+        BacktestRecord performance_oos {};
+        run_combined_backtest( strat_params, performance_is, performance_oos,
+                               false );
+        return( OOS_metrics_conditions( performance_is, performance_oos ) );
+    }
+    std::unique_ptr<DataFeed> datafeed_is_copy { datafeed_->clone() };
+    BacktestRecord performance_is {};
+    btf_.run_cached_backtest( performance_is,
+                BacktestRequest { datafeed_is_copy.get(), strat_params } );
+    if( performance_is.ntrades == 0 ){
+        return(false);
+    }
+    std::unique_ptr<DataFeed> datafeed_oos_copy { datafeed_oos.clone() };
+    BacktestRecord performance_oos {};
+    btf_.run_cached_backtest( performance_oos,
+                BacktestRequest { datafeed_oos_copy.get(), strat_params } );
+
+    return( OOS_metrics_conditions( performance_is, performance_oos ) );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! OOS consistency test of single strategy 'strat' (IS and OOS backtests run
+    serially, on copies of datafeed_ and 'datafeed_oos')
+*/
+bool Validation::OOS_consistency_passed( const strategy_t &strat,
+                                         const DataFeed &datafeed_oos ) const
+{
+    parameters_t strat_params {};
+    utils_params::extract_parameters_from_single_strategy( strat,
+                                                           strat_params );
+    if( datafeed_combined_ != nullptr ){
+        BacktestRecord record_is {};
+        BacktestRecord record_oos {};
+        run_combined_backtest( strat_params, record_is, record_oos, true );
+        return( OOS_consistency_conditions( record_is, record_oos ) );
+    }
+    std::unique_ptr<DataFeed> datafeed_is_copy { datafeed_->clone() };
+    BacktestRecord record_is {};
+    btf_.run_cached_backtest( record_is,
+                BacktestRequest { datafeed_is_copy.get(), strat_params },
+                true );
+    if( record_is.ticks.empty() ){
+        return(false);
+    }
+    std::unique_ptr<DataFeed> datafeed_oos_copy { datafeed_oos.clone() };
+    BacktestRecord record_oos {};
+    btf_.run_cached_backtest( record_oos,
+                BacktestRequest { datafeed_oos_copy.get(), strat_params },
+                true );
+
+    return( OOS_consistency_conditions( record_is, record_oos ) );
+}
+
+
+
+// ------------------------------------------------------------------------- //
+/*! Fill 'results' with optimization results (metrics + params) of backtests
+    of 'search_space', in the same order.
+    Combinations already evaluated during generation (found in
+    generation_index_) are copied from generation results; only the missing
+    ones are backtested (in parallel).
+*/
+void Validation::reuse_or_run_backtests(
+                            const std::vector<parameters_t> &search_space,
+                            std::vector<strategy_t> &results ) const
+{
+    results.assign( search_space.size(), strategy_t {} );
+
+    // Look up combinations in generation results
+    std::vector<parameters_t> missing_space {};
+    std::vector<size_t> missing_position {};
+    for( size_t i = 0; i < search_space.size(); i++ ){
+        const strategy_t *found { generation_index_.find( search_space[i] ) };
+        if( found != nullptr ){
+            results[i] = *found;
         }
         else{
-            printf("-failed-\n");
+            missing_space.push_back( search_space[i] );
+            missing_position.push_back( i );
         }
     }
-    //--- End loop over input_strategies
+    reused_backtests_ += search_space.size() - missing_space.size();
+    total_backtests_ += search_space.size();
 
-    printf( "%21s N. of strategies passing OOS Consistency Test: %lu\n", "",
-            output_strategies.size() );
+    // Run backtests of missing combinations
+    if( missing_space.empty() ){
+        return;
+    }
+    std::vector<BacktestRecord> records {};
+    btf_.run_parallel_backtests( missing_space, records, datafeed_ );
+    for( size_t j = 0; j < records.size(); j++ ){
+        std::vector<strategy_t> row {};
+        utils_optim::append_to_optim_results( row, records[j],
+                                              missing_space[j] );
+        results[missing_position[j]] = row.front();
+    }
 }
 
 
 
-
-
 // ------------------------------------------------------------------------- //
 /*! TS profitable across at least 80% of all parameter combinations.
     It checks all combination of the parameter named "optim_param_name"
@@ -610,37 +997,37 @@ void Validation::profitability_test(
     std::cout << "\n" << utils_time::current_datetime_str() + " | "
               << "Running Profitability Test \n";
 
-    //--- Loop over input_strategies
-    for( const auto& strat: input_strategies ){
+    // Backtests over the optimization parameter(s) of each strategy
+    std::vector<std::vector<ProfitabilityBlock>> blocks (
+                                                    input_strategies.size() );
+    // Backtests of all strategies, to be run in parallel
+    std::vector<parameters_t> search_space {};
+    for( size_t i = 0; i < input_strategies.size(); i++ ){
+        append_profitability_space( input_strategies[i], search_space,
+                                    blocks[i] );
+    }
 
-        printf( "%25s Strategy %lu / %lu ","",
-                &strat - &input_strategies[0] + 1, input_strategies.size() );
+    // Run backtests of all strategies in parallel (or reuse generation ones)
+    std::vector<strategy_t> results {};
+    reuse_or_run_backtests( search_space, results );
 
-        // Extract parameters from strat and store them into strat_params
-        parameters_t strat_params {};
-        utils_params::extract_parameters_from_single_strategy( strat,
-                                                               strat_params );
-        // Store value of Side switch (1=Long, 2=Short, 3=Both)
-        int side_switch { utils_params::parameter_by_name( "Side_switch",
-                                                           strat_params) };
-        bool test_passed {false};
-        switch( side_switch ){
-            case 1:
-                test_passed = check_profitability(strat_params, "fractN_long");
-                break;
-            case 2:
-                test_passed = check_profitability(strat_params, "fractN_short");
-                break;
-            case 3:
-                test_passed = (
-                            check_profitability(strat_params, "fractN_long")
-                        && check_profitability(strat_params, "fractN_short") );
+    //--- Loop over input_strategies (in order, for deterministic output)
+    for( size_t i = 0; i < input_strategies.size(); i++ ){
+
+        printf( "%25s Strategy %lu / %lu ","", i + 1, input_strategies.size() );
+
+        bool test_passed { !blocks[i].empty() };
+        for( const ProfitabilityBlock& block: blocks[i] ){
+            std::cout << "( " << block.optim_param_name << " ) ";
+            if( !profitability_conditions( results, block.begin, block.end ) ){
+                test_passed = false;
                 break;
+            }
         }
         if( test_passed ){
             printf("+PASSED+\n");
             // append passed strategy to output_strategies
-            output_strategies.push_back( strat );
+            output_strategies.push_back( input_strategies[i] );
         }
         else{
             printf("-failed-\n");
@@ -655,52 +1042,93 @@ void Validation::profitability_test(
 
 
 // ------------------------------------------------------------------------- //
-/*! Check profitability of single strategy by varying 'optim_param_name':
-    >= 80% of all runs must be profitable
+/*! Append to 'search_space' the backtests of the profitability test of
+    'strat' (all values of "fractN_long" and/or "fractN_short", according to
+    "Side_switch"), and to 'blocks' their position in 'search_space'
 */
-bool Validation::check_profitability( const parameters_t& strat_params,
-                                      const std::string &optim_param_name )
+void Validation::append_profitability_space( const strategy_t &strat,
+                                std::vector<parameters_t> &search_space,
+                                std::vector<ProfitabilityBlock> &blocks ) const
 {
-    bool result {false};
-
-    std::cout << "( " << optim_param_name << " ) ";
+    // Extract parameters from strat and store them into strat_params
+    parameters_t strat_params {};
+    utils_params::extract_parameters_from_single_strategy( strat,
+                                                           strat_params );
+    // Store value of Side switch (1=Long, 2=Short, 3=Both)
+    int side_switch { utils_params::parameter_by_name( "Side_switch",
+                                                       strat_params) };
+    std::vector<std::string> optim_param_names {};
+    switch( side_switch ){
+        case 1:
+            optim_param_names = { "fractN_long" };
+            break;
+        case 2:
+            optim_param_names = { "fractN_short" };
+            break;
+        case 3:
+            optim_param_names = { "fractN_long", "fractN_short" };
+            break;
+    }
+    for( const std::string& name: optim_param_names ){
+        // Fill 'strat_space' with combinations of 'name'
+        std::vector<parameters_t> strat_space {strat_params};
+        utils_params::expand_strategies_with_opt_range(
+                                name, parameter_ranges_, strat_space );
+        blocks.push_back( ProfitabilityBlock { name, search_space.size(),
+                                search_space.size() + strat_space.size() } );
+        search_space.insert( search_space.end(),
+                             strat_space.begin(), strat_space.end() );
+    }
+}
 
-    // Initialize 'search_space' with single strategy parameters
-    std::vector<parameters_t> search_space {strat_params};
-    // Fill 'search_space' with combintations of 'optim_param_name'
-    utils_params::expand_strategies_with_opt_range(
-                      optim_param_name, parameter_ranges_, search_space );
-    // Initialize vector where storing optimization results of running
-    std::vector<strategy_t> optim_results {};
-    // Run optimization over optimization parameter
-    btf_.run_parallel_optimization( search_space, optim_results, "", "",
-                                    fitness_metric_, datafeed_,true,false);
 
-    // Fill vector of AvgTicks from backtests over optim param
-    std::vector<double> metric {};
-    for( const strategy_t& opres: optim_results ){
-        for( const auto& el: opres ){
-            if( el.first == "AvgTicks" ){
-                metric.push_back( el.second );
-            }
+// ------------------------------------------------------------------------- //
+/*! Profitability test of single strategy 'strat'
+*/
+bool Validation::profitability_passed( const strategy_t &strat ) const
+{
+    std::vector<ProfitabilityBlock> blocks {};
+    std::vector<parameters_t> search_space {};
+    append_profitability_space( strat, search_space, blocks );
+    if( blocks.empty() ){
+        return(false);
+    }
+    std::vector<strategy_t> results {};
+    reuse_or_run_backtests( search_space, results );
+    for( const ProfitabilityBlock& block: blocks ){
+        if( !profitability_conditions( results, block.begin, block.end ) ){
+            return(false);
         }
     }
+    return(true);
+}
+
+
+
+// ------------------------------------------------------------------------- //
+/*! Check profitability of single strategy over the backtests
+    'results[begin:end]' (obtained by varying one optimization parameter):
+    >= 80% of all runs must be profitable
+*/
+bool Validation::profitability_conditions(
+                                const std::vector<strategy_t> &results,
+                                size_t begin, size_t end ) const
+{
     // Check if metric vector is empty
-    if( metric.empty() ){
+    if( begin >= end || end > results.size() ){
         std::cout<<">>> ERROR: empty metric vector (validation).\n";
         exit(1);
     }
     // Count profitable runs (with AvgTicks > transaction costs)
     int profitable_runs {0};
-    for( double at: metric ){
-        if( at > btf_.symbol().transaction_cost_ticks() ){
+    for( size_t i = begin; i < end; i++ ){
+        if( utils_params::strategy_attribute_by_name( "AvgTicks", results[i] )
+            > btf_.symbol().transaction_cost_ticks() ){
             profitable_runs++;
         }
     }
     // at least 80% of all runs must be profitable
-    result = ( profitable_runs >= 0.8 * metric.size() );
-
-    return( result );
+    return( profitable_runs >= 0.8 * (end - begin) );
 }
 
 
@@ -723,83 +1151,13 @@ void Validation::stability_test( const std::vector<strategy_t>
     std::cout << "\n" << utils_time::current_datetime_str() + " | "
               << "Running Stability Test\n";
 
-    // Create vector with epsilon parameters [-2,-1,0,1,2]
-    // corresponding to [-10%,-5%, 0, +5%, +10%] parameter variation
-    std::vector<int> eps_values {};
-    for( int i=-2; i<=2; i++){
-        eps_values.push_back(i);
-    }
-
     //--- Loop over input_strategies
     for( const auto& strat: input_strategies ){
 
         printf( "%25s Strategy %lu / %lu ","",
                 &strat - &input_strategies[0] + 1, input_strategies.size() );
 
-        // Extract parameters from strat and store them into strat_params
-        parameters_t strat_params {};
-        utils_params::extract_parameters_from_single_strategy( strat,
-                                                               strat_params );
-
-        param_ranges_t param_ranges {};
-        // Fill 'param_ranges'...
-        for( const auto& el: strat_params ){
-            if( el.first != "epsilon" ){        //  ... with strategy parameters
-                param_ranges.push_back( std::make_pair(
-                                    el.first, std::vector<int>{el.second} ) );
-            }
-            else if( el.first == "epsilon" ){   // ... with epsilons
-                param_ranges.push_back( std::make_pair("epsilon", eps_values));
-            }
-            else{
-                std::cout<<">>> ERROR: epsilon parameter not found "
-                         <<"in strategy parameters (validation).\n";
-                exit(1);
-            }
-        }
-
-        // Cartesian product of all epsilons
-        std::vector<parameters_t> search_space {
-                        utils_params::cartesian_product(param_ranges) };
-
-        // Initialize vector where storing optimization results of running
-        std::vector<strategy_t> optim_results {};
-
-        // Run optimization over all values of epsilon
-        btf_.run_parallel_optimization( search_space,
-                                        optim_results, "", "",
-                                        fitness_metric_, datafeed_,
-                                        true, false );
-
-        // Fill vector of fitness_metric_ from backtests over epsilons
-        std::vector<double> metric {};
-        for( auto opres: optim_results ){
-            for( auto el: opres ){
-                if( el.first == fitness_metric_ ){
-                    metric.push_back( el.second );
-                }
-            }
-        }
-        // Check if metric vector is empty
-        if( metric.empty() ){
-            std::cout<<">>> ERROR: empty metric vector. "
-                     << "Check FITNESS_METRIC (validation).\n";
-            exit(1);
-        }
-        /*
-        // Print values of performance metrics over neighborhood
-        std::cout<<fitness_metric_<<": ";
-        for( double m: metric ){
-            std::cout<< m<<", ";
-        }
-        std::cout<<"\n";
-        */
-        // Min/Max of performance metric over neighborhood
-        double max_metric { *max_element(metric.begin(), metric.end()) };
-        double min_metric { *min_element(metric.begin(), metric.end()) };
-
-        // Stability condition ( |1-min/max|<= max_variation_ )
-        if( min_metric >= (1-max_variation_) * max_metric ){
+        if( stability_passed( strat ) ){
             printf("+PASSED+\n");
             // append passed strategy to output_strategies
             output_strategies.push_back( strat );
@@ -817,6 +1175,82 @@ void Validation::stability_test( const std::vector<strategy_t>
 
 
 
+// ------------------------------------------------------------------------- //
+/*! Stability test of single strategy 'strat'
+*/
+bool Validation::stability_passed( const strategy_t &strat ) const
+{
+    // Create vector with epsilon parameters [-2,-1,0,1,2]
+    // corresponding to [-10%,-5%, 0, +5%, +10%] parameter variation
+    std::vector<int> eps_values {};
+    for( int i=-2; i<=2; i++){
+        eps_values.push_back(i);
+    }
+
+    // Extract parameters from strat and store them into strat_params
+    parameters_t strat_params {};
+    utils_params::extract_parameters_from_single_strategy( strat,
+                                                           strat_params );
+
+    param_ranges_t param_ranges {};
+    // Fill 'param_ranges'...
+    for( const auto& el: strat_params ){
+        if( el.first != "epsilon" ){        //  ... with strategy parameters
+            param_ranges.push_back( std::make_pair(
+                                el.first, std::vector<int>{el.second} ) );
+        }
+        else if( el.first == "epsilon" ){   // ... with epsilons
+            param_ranges.push_back( std::make_pair("epsilon", eps_values));
+        }
+        else{
+            std::cout<<">>> ERROR: epsilon parameter not found "
+                     <<"in strategy parameters (validation).\n";
+            exit(1);
+        }
+    }
+
+    // Cartesian product of all epsilons
+    std::vector<parameters_t> search_space {
+                    utils_params::cartesian_product(param_ranges) };
+
+    // Optimization results (metrics + params) of backtests over all values
+    // of epsilon (or of generation results, when available)
+    std::vector<strategy_t> optim_results {};
+    reuse_or_run_backtests( search_space, optim_results );
+
+    // Fill vector of fitness_metric_ from backtests over epsilons
+    std::vector<double> metric {};
+    for( auto opres: optim_results ){
+        for( auto el: opres ){
+            if( el.first == fitness_metric_ ){
+                metric.push_back( el.second );
+            }
+        }
+    }
+    // Check if metric vector is empty
+    if( metric.empty() ){
+        std::cout<<">>> ERROR: empty metric vector. "
+                 << "Check FITNESS_METRIC (validation).\n";
+        exit(1);
+    }
+    /*
+    // Print values of performance metrics over neighborhood
+    std::cout<<fitness_metric_<<": ";
+    for( double m: metric ){
+        std::cout<< m<<", ";
+    }
+    std::cout<<"\n";
+    */
+    // Min/Max of performance metric over neighborhood
+    double max_metric { *max_element(metric.begin(), metric.end()) };
+    double min_metric { *min_element(metric.begin(), metric.end()) };
+
+    // Stability condition ( |1-min/max|<= max_variation_ )
+    return( min_metric >= (1-max_variation_) * max_metric );
+}
+
+
+
 // ------------------------------------------------------------------------- //
 /*! Perf metric of strategy on original data in [mean - 2*std , mean + 2*stdev]
 
@@ -843,70 +1277,25 @@ void Validation::noise_test( const std::vector<strategy_t>
         printf( "%25s Strategy %lu / %lu ","",
                 &strat - &input_strategies[0] + 1, input_strategies.size() );
 
-        // Initialize vector where storing optimization results of running
+        // Run backtests on original and noised data
         std::vector<strategy_t> noise_results {};
+        run_noise_backtests( strat, noise_results );
 
-        // Add original strategy as first entry of noise_results
-        noise_results.push_back( strat );
-
-        // Extract parameters from strat and store them into strat_params
-        parameters_t strat_params {};
-        utils_params::extract_parameters_from_single_strategy( strat,
-                                                               strat_params );
-
-        //-- Backtest with noised data
-        // Replicate the same 'strat_params' for 'num_noise_tests-1' times,
-        // since 1 run is on original data
-        std::vector<parameters_t> search_space {};
-        for( int i = 0; i < num_noise_tests_-1; i++ ){
-            search_space.push_back(strat_params);
-        }
-
-        // Each run is with same strategy parameters but with
-        // random noise added to price data
-        btf_.set_random_noise(true);
-        btf_.run_parallel_optimization( search_space,
-                                        noise_results, noise_file_, "",
-                                        fitness_metric_, datafeed_,
-                                        false, write_to_file);
-        //--
-
-        //-- Fill vector of 'perf_metric_name' from backtests over noise_results
-        std::string perf_metric_name { "AvgTicks" };
-        std::vector<double> perf_metric {};
-
-        for( const strategy_t& res: noise_results ){
-            perf_metric.push_back(
-                utils_params::strategy_attribute_by_name(perf_metric_name, res)
-                                 );
-        }
-        // Check if metric vector is empty
-        if( perf_metric.empty() ){
-            std::cout<<">>> ERROR: empty "<< perf_metric_name
-                     << " vector (validation).\n";
-            exit(1);
-        }
-        //--
-
-        // first entry of 'perf_metric' is performance metric on original data
-        double original_metric { perf_metric.at(0) };
-
-        // mean +/- 2std of performance metric
-        double lower_level { utils_math::mean( perf_metric )
-                            - 2 * utils_math::stdev( perf_metric ) };
-                            //{ utils_math::percentile( perf_metric, 0.05 ) };
-        double upper_level { utils_math::mean( perf_metric )
-                            + 2 * utils_math::stdev( perf_metric ) };
-                            //{ utils_math::percentile( perf_metric, 0.95 ) };
         if( write_to_file ){
-            std::cout << "\n";
-            std::cout << perf_metric_name <<"  |  original: "<< original_metric
-                      << " |  mean +/- 2*std: [ "
-                      << lower_level <<" , "<< upper_level<<" ]\n\n";
+            // Write noise test results to file 'noise_file_' and on stdout
+            int control = utils_fileio::write_strategies_to_file(
+                                        noise_file_, "", noise_results,
+                                        btf_.strategy_name(),
+                                        btf_.symbol().name(), btf_.timeframe(),
+                                        btf_.first_date_parsed(),
+                                        btf_.last_date_parsed(), true );
+            if( control == 1 ){
+                std::cout << "\nNoise test results written on file: "
+                          << noise_file_ <<"\n";
+            }
         }
 
-        if( lower_level < upper_level &&
-            original_metric >= lower_level && original_metric <= upper_level ){
+        if( noise_conditions( noise_results, write_to_file ) ){
             printf("+PASSED+\n");
             // append passed strategy to output_strategies
             output_strategies.push_back( strat );
@@ -923,6 +1312,100 @@ void Validation::noise_test( const std::vector<strategy_t>
 
 
 
+// ------------------------------------------------------------------------- //
+/*! Fill 'noise_results' with optimization results of 'strat' on original data
+    (first entry) and of 'num_noise_tests_-1' backtests on noised data
+*/
+void Validation::run_noise_backtests( const strategy_t &strat,
+                                std::vector<strategy_t> &noise_results ) const
+{
+    noise_results.clear();
+    // Add original strategy as first entry of noise_results
+    noise_results.push_back( strat );
+
+    // Extract parameters from strat and store them into strat_params
+    parameters_t strat_params {};
+    utils_params::extract_parameters_from_single_strategy( strat,
+                                                           strat_params );
+
+    // Replicate the same 'strat_params' for 'num_noise_tests-1' times,
+    // since 1 run is on original data
+    std::vector<parameters_t> search_space {};
+    for( int i = 0; i < num_noise_tests_-1; i++ ){
+        search_space.push_back(strat_params);
+    }
+
+    // Each run is with same strategy parameters but with
+    // random noise added to price data
+    std::vector<BacktestRecord> records {};
+    btf_.run_parallel_backtests( search_space, records, datafeed_, true );
+    for( size_t i = 0; i < records.size(); i++ ){
+        utils_optim::append_to_optim_results( noise_results, records[i],
+                                              search_space[i] );
+    }
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Condition of noise test: performance metric on original data
+    (first entry of 'noise_results') in [mean - 2*std , mean + 2*stdev]
+    of all entries.
+    If 'print_levels', print original metric and levels on stdout.
+*/
+bool Validation::noise_conditions( const std::vector<strategy_t> &noise_results,
+                                   bool print_levels ) const
+{
+    //-- Fill vector of 'perf_metric_name' from backtests over noise_results
+    std::string perf_metric_name { "AvgTicks" };
+    std::vector<double> perf_metric {};
+
+    for( const strategy_t& res: noise_results ){
+        perf_metric.push_back(
+            utils_params::strategy_attribute_by_name(perf_metric_name, res)
+                             );
+    }
+    // Check if metric vector is empty
+    if( perf_metric.empty() ){
+        std::cout<<">>> ERROR: empty "<< perf_metric_name
+                 << " vector (validation).\n";
+        exit(1);
+    }
+    //--
+
+    // first entry of 'perf_metric' is performance metric on original data
+    double original_metric { perf_metric.at(0) };
+
+    // mean +/- 2std of performance metric
+    double lower_level { utils_math::mean( perf_metric )
+                        - 2 * utils_math::stdev( perf_metric ) };
+                        //{ utils_math::percentile( perf_metric, 0.05 ) };
+    double upper_level { utils_math::mean( perf_metric )
+                        + 2 * utils_math::stdev( perf_metric ) };
+                        //{ utils_math::percentile( perf_metric, 0.95 ) };
+    if( print_levels ){
+        std::cout << "\n";
+        std::cout << perf_metric_name <<"  |  original: "<< original_metric
+                  << " |  mean +/- 2*std: [ "
+                  << lower_level <<" , "<< upper_level<<" ]\n\n";
+    }
+
+    return( lower_level < upper_level &&
+            original_metric >= lower_level && original_metric <= upper_level );
+}
+
+
+// ------------------------------------------------------------------------- //
+/*! Noise test of single strategy 'strat'
+*/
+bool Validation::noise_passed( const strategy_t &strat ) const
+{
+    std::vector<strategy_t> noise_results {};
+    run_noise_backtests( strat, noise_results );
+    return( noise_conditions( noise_results, false ) );
+}
+
+
+
 
 
 